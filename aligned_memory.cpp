@@ -0,0 +1,101 @@
+#include "aligned_memory.h"
+#include "alloc_tracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#define ENGINE_HAS_MMAP 1
+#endif
+
+namespace {
+
+bool ReadHugePagesEnv() {
+    const char* value = std::getenv("ENGINE_HUGE_PAGES");
+    return !value || std::strcmp(value, "0") != 0;
+}
+
+std::atomic<bool> g_hugePages{ReadHugePagesEnv()};
+
+#ifdef ENGINE_HAS_MMAP
+size_t RoundToHugePages(size_t bytes) {
+    return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+// Крупные блоки живут в отдельном отображении: так его можно выровнять на 2 МБ и вернуть системе целиком
+bool IsMapped(size_t bytes) {
+    return bytes >= HUGE_PAGE_SIZE;
+}
+#endif
+
+void* AllocateSmall(size_t bytes) {
+    bytes = (bytes + MEMORY_ALIGNMENT - 1) & ~(MEMORY_ALIGNMENT - 1);
+#ifdef _MSC_VER
+    return _aligned_malloc(bytes ? bytes : MEMORY_ALIGNMENT, MEMORY_ALIGNMENT);
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, MEMORY_ALIGNMENT, bytes ? bytes : MEMORY_ALIGNMENT) != 0) return nullptr;
+    return p;
+#endif
+}
+
+void FreeSmall(void* p) {
+#ifdef _MSC_VER
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+} // namespace
+
+// Выделение в обход operator new: об удачном сообщаем AllocTracker сами, неудачное не считается
+void* AlignedMemory::Allocate(size_t bytes) {
+#ifdef ENGINE_HAS_MMAP
+    if (IsMapped(bytes)) {
+        // Лишние 2 МБ позволяют найти выровненное начало; хвосты до и после сразу возвращаются
+        size_t size = RoundToHugePages(bytes);
+        size_t reserve = size + HUGE_PAGE_SIZE;
+        void* raw = mmap(nullptr, reserve, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) return nullptr;
+
+        uintptr_t start = ((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+        size_t head = start - (uintptr_t)raw;
+        if (head) munmap(raw, head);
+        if (reserve - head - size) munmap((void*)(start + size), reserve - head - size);
+
+#ifdef MADV_HUGEPAGE
+        if (g_hugePages.load(std::memory_order_relaxed)) madvise((void*)start, size, MADV_HUGEPAGE);
+#endif
+        AllocTracker::NoteAllocation();
+        return (void*)start;
+    }
+#endif
+    void* p = AllocateSmall(bytes);
+    if (p) AllocTracker::NoteAllocation();
+    return p;
+}
+
+void AlignedMemory::Free(void* p, size_t bytes) {
+    if (!p) return;
+    AllocTracker::NoteFree();
+#ifdef ENGINE_HAS_MMAP
+    if (IsMapped(bytes)) {
+        munmap(p, RoundToHugePages(bytes));
+        return;
+    }
+#else
+    (void)bytes;
+#endif
+    FreeSmall(p);
+}
+
+void AlignedMemory::SetHugePages(bool enabled) {
+    g_hugePages.store(enabled, std::memory_order_relaxed);
+}
+
+bool AlignedMemory::GetHugePages() {
+    return g_hugePages.load(std::memory_order_relaxed);
+}
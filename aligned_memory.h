@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <new>
+
+// Память под крупные массивы: буферы кадра, вершины мешей.
+// Начало всегда выровнено на кэш-линию (64 байта) — под SIMD и потоковые записи.
+// Крупные блоки (от 2 МБ) на Linux берутся через mmap, выравниваются на 2 МБ и помечаются
+// MADV_HUGEPAGE: ядро отдаёт их прозрачными огромными страницами, и кадр 4K занимает
+// пару десятков записей TLB вместо тысяч. Отключается SetHugePages(false)
+// или переменной окружения ENGINE_HUGE_PAGES=0.
+// Выделения и освобождения учитывает AllocTracker наравне с operator new.
+const size_t MEMORY_ALIGNMENT = 64;
+const size_t HUGE_PAGE_SIZE = 2u << 20;
+
+namespace AlignedMemory {
+    void* Allocate(size_t bytes);
+    void Free(void* p, size_t bytes); // bytes — тот же размер, что при выделении
+
+    void SetHugePages(bool enabled);  // Действует на следующие выделения
+    bool GetHugePages();
+}
+
+template <class T>
+struct AlignedAllocator {
+    using value_type = T;
+
+    AlignedAllocator() = default;
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t count) {
+        if (count > (size_t)-1 / sizeof(T)) throw std::bad_alloc();
+        void* p = AlignedMemory::Allocate(count * sizeof(T));
+        if (!p) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t count) { AlignedMemory::Free(p, count * sizeof(T)); }
+
+    template <class U>
+    bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <class U>
+    bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+template <class T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
@@ -0,0 +1,174 @@
+#include "alloc_tracker.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifndef ENGINE_ALLOC_TRACKING
+#define ENGINE_ALLOC_TRACKING 0
+#endif
+
+namespace {
+
+// Счётчики тривиальные: operator new может вызываться до конструкторов статических объектов
+thread_local uint64_t t_allocations = 0;
+thread_local uint64_t t_frees = 0;
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_frees{0};
+
+bool ReadAssertEnv() {
+    const char* value = std::getenv("ENGINE_ASSERT_NO_ALLOC");
+    return value && std::strcmp(value, "0") != 0;
+}
+
+std::atomic<bool> g_assertMode{ReadAssertEnv()};
+
+} // namespace
+
+#if ENGINE_ALLOC_TRACKING
+
+namespace {
+
+void Count() {
+    t_allocations++;
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CountFree() {
+    t_frees++;
+    g_frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Free(void* p) {
+    if (p) CountFree();
+    std::free(p);
+}
+
+void* AllocateOrThrow(std::size_t size) {
+    Count();
+    for (;;) {
+        if (void* p = std::malloc(size ? size : 1)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* AllocateAligned(std::size_t size, std::size_t align) {
+    Count();
+    void* p = nullptr;
+#ifdef _MSC_VER
+    p = _aligned_malloc(size ? size : 1, align);
+#else
+    if (posix_memalign(&p, align < sizeof(void*) ? sizeof(void*) : align, size ? size : 1) != 0) p = nullptr;
+#endif
+    return p;
+}
+
+void FreeAligned(void* p) {
+    if (p) CountFree();
+#ifdef _MSC_VER
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return AllocateOrThrow(size); }
+void* operator new[](std::size_t size) { return AllocateOrThrow(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    Count();
+    return std::malloc(size ? size : 1);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    Count();
+    return std::malloc(size ? size : 1);
+}
+void operator delete(void* p) noexcept { Free(p); }
+void operator delete[](void* p) noexcept { Free(p); }
+void operator delete(void* p, std::size_t) noexcept { Free(p); }
+void operator delete[](void* p, std::size_t) noexcept { Free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { Free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { Free(p); }
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    void* p = AllocateAligned(size, (std::size_t)align);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](std::size_t size, std::align_val_t align) {
+    void* p = AllocateAligned(size, (std::size_t)align);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return AllocateAligned(size, (std::size_t)align);
+}
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return AllocateAligned(size, (std::size_t)align);
+}
+void operator delete(void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(p); }
+
+void AllocTracker::NoteAllocation() { Count(); }
+void AllocTracker::NoteFree() { CountFree(); }
+
+#else
+
+void AllocTracker::NoteAllocation() {}
+void AllocTracker::NoteFree() {}
+
+#endif
+
+bool AllocTracker::IsEnabled() {
+    return ENGINE_ALLOC_TRACKING != 0;
+}
+
+uint64_t AllocTracker::GetThreadCount() {
+    return t_allocations;
+}
+
+uint64_t AllocTracker::GetTotalCount() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocTracker::GetThreadFreeCount() {
+    return t_frees;
+}
+
+uint64_t AllocTracker::GetTotalFreeCount() {
+    return g_frees.load(std::memory_order_relaxed);
+}
+
+void AllocTracker::SetAssertMode(bool enabled) {
+    g_assertMode.store(enabled, std::memory_order_relaxed);
+}
+
+bool AllocTracker::GetAssertMode() {
+    return g_assertMode.load(std::memory_order_relaxed);
+}
+
+NoAllocScope::NoAllocScope(const char* name, bool active)
+    : m_name(name), m_active(active && AllocTracker::IsEnabled()), m_start(t_allocations) {}
+
+NoAllocScope::~NoAllocScope() {
+    if (!m_active || !AllocTracker::GetAssertMode()) return;
+    uint64_t count = GetCount();
+    if (count == 0) return;
+
+    // Печать без iostream: она сама может выделять память
+    std::fprintf(stderr, "ERROR: %llu heap allocations inside no-allocation scope \"%s\"\n",
+                 (unsigned long long)count, m_name);
+    std::abort();
+}
+
+uint64_t NoAllocScope::GetCount() const {
+    return t_allocations - m_start;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+
+// Подсчёт выделений памяти в куче через замену глобального operator new.
+// Собирается только с ENGINE_ALLOC_TRACKING=1 (опция CMake): замена действует на всю программу
+// и стоит пары инкрементов на каждое выделение. Без неё счётчики всегда нулевые.
+//
+// NoAllocScope отмечает участок, который в установившемся режиме не должен трогать кучу
+// (кадр рендера после прогрева). В режиме проверки (SetAssertMode или переменная окружения
+// ENGINE_ASSERT_NO_ALLOC=1) выделение внутри такого участка печатает ошибку и завершает программу.
+namespace AllocTracker {
+    // Собрана ли программа с подсчётом
+    bool IsEnabled();
+
+    // Выделений с запуска: в текущем потоке и во всех потоках
+    uint64_t GetThreadCount();
+    uint64_t GetTotalCount();
+
+    // Освобождений с запуска, так же по потоку и по всем
+    uint64_t GetThreadFreeCount();
+    uint64_t GetTotalFreeCount();
+
+    // Учёт памяти, выделенной в обход operator new (AlignedMemory: posix_memalign, mmap),
+    // чтобы её тоже видел NoAllocScope. Без ENGINE_ALLOC_TRACKING ничего не делают
+    void NoteAllocation();
+    void NoteFree();
+
+    void SetAssertMode(bool enabled);
+    bool GetAssertMode();
+}
+
+class NoAllocScope {
+public:
+    // active = false — участок не проверяется (например, ещё идёт прогрев)
+    explicit NoAllocScope(const char* name, bool active = true);
+    ~NoAllocScope();
+
+    NoAllocScope(const NoAllocScope&) = delete;
+    NoAllocScope& operator=(const NoAllocScope&) = delete;
+
+    // Выделений в текущем потоке с начала участка
+    uint64_t GetCount() const;
+
+private:
+    const char* m_name;
+    bool m_active;
+    uint64_t m_start;
+};
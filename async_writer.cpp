@@ -0,0 +1,139 @@
+#include "async_writer.h"
+#include "profiler.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+
+using Clock = std::chrono::steady_clock;
+
+AsyncWriter::AsyncWriter(size_t maxQueued) : m_maxQueued(maxQueued ? maxQueued : 1) {
+    m_thread = std::thread(&AsyncWriter::Run, this);
+}
+
+AsyncWriter::~AsyncWriter() {
+    Finish();
+}
+
+void AsyncWriter::Write(std::string filename, std::vector<uint8_t> data) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_queue.size() >= m_maxQueued) {
+        auto start = Clock::now();
+        m_hasRoom.wait(lock, [this] { return m_queue.size() < m_maxQueued; });
+        m_stats.stallSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    m_queue.push_back({std::move(filename), std::move(data)});
+    m_hasWork.notify_one();
+}
+
+void AsyncWriter::Finish() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_hasWork.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void AsyncWriter::Run() {
+    Profiler::SetThreadName("writer");
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_hasWork.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+            // Остановка только после того, как очередь опустела
+            if (m_queue.empty()) return;
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        m_hasRoom.notify_one();
+
+        PROFILE_SCOPE("Disk write");
+        auto start = Clock::now();
+        std::ofstream out(job.filename, std::ios::binary);
+        bool ok = out.is_open() && out.write(reinterpret_cast<const char*>(job.data.data()), job.data.size());
+        out.close();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (!ok) std::cerr << "Failed to write " << job.filename << std::endl;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.writeSeconds += seconds;
+        if (ok) {
+            m_stats.files++;
+            m_stats.bytes += job.data.size();
+        } else {
+            m_stats.failed++;
+        }
+    }
+}
+
+// --- AsyncStreamWriter ---
+
+AsyncStreamWriter::AsyncStreamWriter(FILE* out, size_t maxQueued)
+    : m_out(out), m_maxQueued(maxQueued ? maxQueued : 1), m_window(m_maxQueued), m_ready(m_maxQueued, false) {
+    m_thread = std::thread(&AsyncStreamWriter::Run, this);
+}
+
+AsyncStreamWriter::~AsyncStreamWriter() {
+    Finish();
+}
+
+void AsyncStreamWriter::Write(int sequence, std::vector<uint8_t> data) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if ((size_t)(sequence - m_next) >= m_maxQueued) {
+        auto start = Clock::now();
+        m_hasRoom.wait(lock, [&] { return (size_t)(sequence - m_next) < m_maxQueued; });
+        m_stats.stallSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    size_t slot = (size_t)sequence % m_maxQueued;
+    m_window[slot] = std::move(data);
+    m_ready[slot] = true;
+    if (sequence == m_next) m_hasWork.notify_one();
+}
+
+void AsyncStreamWriter::Finish() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_hasWork.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void AsyncStreamWriter::Run() {
+    Profiler::SetThreadName("writer");
+    for (;;) {
+        std::vector<uint8_t> data;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            size_t slot = (size_t)m_next % m_maxQueued;
+            m_hasWork.wait(lock, [&] { return m_stop || m_ready[slot]; });
+            if (!m_ready[slot]) {
+                // Остановка: дописываем всё, что есть, дальше дыра в нумерации
+                fflush(m_out);
+                return;
+            }
+            data = std::move(m_window[slot]);
+            m_ready[slot] = false;
+        }
+
+        PROFILE_SCOPE("Disk write");
+        auto start = Clock::now();
+        bool ok = fwrite(data.data(), 1, data.size(), m_out) == data.size();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_next++;
+            m_stats.writeSeconds += seconds;
+            if (ok) {
+                m_stats.files++;
+                m_stats.bytes += data.size();
+            } else {
+                // Продолжаем вычитывать очередь, иначе производители зависнут на полном окне
+                m_stats.failed++;
+            }
+        }
+        m_hasRoom.notify_all();
+    }
+}
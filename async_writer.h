@@ -0,0 +1,93 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+struct WriterStats {
+    int files = 0;             // Записанных файлов (для потока — кусков)
+    int failed = 0;
+    size_t bytes = 0;
+    double writeSeconds = 0.0; // Время потока-писателя внутри записи
+    double stallSeconds = 0.0; // Сколько производители простояли на полной очереди
+};
+
+// Запись файлов в отдельном потоке: рендер не ждёт диска.
+// Очередь ограничена maxQueued файлами, чтобы медленный диск не съел всю память:
+// при переполнении Write блокируется, пока писатель не освободит место.
+class AsyncWriter {
+public:
+    explicit AsyncWriter(size_t maxQueued = 16);
+    ~AsyncWriter();
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    // Потокобезопасна: может вызываться из нескольких рабочих потоков
+    void Write(std::string filename, std::vector<uint8_t> data);
+
+    // Дожидается записи всей очереди и останавливает поток
+    void Finish();
+
+    // Читать после Finish()
+    const WriterStats& GetStats() const { return m_stats; }
+
+private:
+    struct Job {
+        std::string filename;
+        std::vector<uint8_t> data;
+    };
+
+    void Run();
+
+    size_t m_maxQueued;
+    std::deque<Job> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_hasWork;
+    std::condition_variable m_hasRoom;
+    bool m_stop = false;
+    WriterStats m_stats;
+    std::thread m_thread;
+};
+
+// Запись последовательности кусков в один поток (файл, stdout) в отдельном потоке.
+// Куски могут приходить из разных потоков в любом порядке, а пишутся строго по номеру sequence.
+// Память ограничена окном из maxQueued номеров: производитель куска с номером
+// next + maxQueued и дальше ждёт, пока писатель не продвинется.
+class AsyncStreamWriter {
+public:
+    // out не закрывается: им владеет вызывающий код
+    AsyncStreamWriter(FILE* out, size_t maxQueued = 8);
+    ~AsyncStreamWriter();
+
+    AsyncStreamWriter(const AsyncStreamWriter&) = delete;
+    AsyncStreamWriter& operator=(const AsyncStreamWriter&) = delete;
+
+    // Каждый номер, начиная с 0, должен быть передан ровно один раз
+    void Write(int sequence, std::vector<uint8_t> data);
+
+    // Дожидается записи всех переданных подряд идущих кусков и останавливает поток
+    void Finish();
+
+    const WriterStats& GetStats() const { return m_stats; }
+
+private:
+    void Run();
+
+    FILE* m_out;
+    size_t m_maxQueued;
+    std::vector<std::vector<uint8_t>> m_window; // Кольцо по sequence % maxQueued
+    std::vector<bool> m_ready;
+    int m_next = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_hasWork;
+    std::condition_variable m_hasRoom;
+    bool m_stop = false;
+    WriterStats m_stats;
+    std::thread m_thread;
+};
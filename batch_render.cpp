@@ -0,0 +1,350 @@
+// Пакетный рендер без окна: меш + путь камеры -> последовательность кадров на диске
+// или один поток несжатого видео (.y4m, "-" — stdout).
+// Независимые кадры рисуются параллельно (у каждого потока свой Renderer),
+// кодирование идёт в рабочих потоках, запись на диск — в отдельном потоке-писателе.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+
+#include "renderer.h"
+#include "mesh.h"
+#include "math_3d.h"
+#include "pipeline.h"
+#include "shapes_generator.h"
+#include "parallel.h"
+#include "image_io.h"
+#include "async_writer.h"
+#include "y4m_writer.h"
+#include "profiler.h"
+#include "alloc_tracker.h"
+#include "cpu_features.h"
+#include "fast_math.h"
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+const float PI = 3.14159265f;
+
+struct BatchOptions {
+    std::string mesh = "sphere";
+    std::string camera = "turntable";
+    std::string output = "frames/frame_%04d.png";
+    std::string trace;
+    int width = 800;
+    int height = 600;
+    int frames = 120;
+    int fps = 30;
+    int threads = 0;
+    bool pngStore = false;
+    Renderer::Layout layout = Renderer::Linear;
+    Renderer::ViewMode view = Renderer::Shaded;
+    float zoom = 5.0f;
+    float tilt = 20.0f; // Наклон камеры для поворотного стола, в градусах
+};
+
+// Ключевой кадр камеры. В файле: "frame rotX rotY zoom", углы в градусах, # — комментарий
+struct CameraKey {
+    float frame;
+    float rotX;
+    float rotY;
+    float zoom;
+};
+
+struct CameraPose {
+    float rotX;
+    float rotY;
+    float zoom;
+};
+
+static void PrintUsage() {
+    std::cerr <<
+        "Usage: engine_batch [options]\n"
+        "  --mesh <name|path>      sphere, torus, icosphere, stress or an .obj/.glb file (default sphere)\n"
+        "  --camera <turntable|file>  turntable or a keyframe file with lines \"frame rotX rotY zoom\"\n"
+        "  --size <W>x<H>          frame size (default 800x600)\n"
+        "  --frames <N>            number of frames (default 120)\n"
+        "  --threads <N>           render threads, 0 = all cores (default 0)\n"
+        "  --output <pattern>      path with one %d-style frame index (%04d, %%), .png or .ppm (default frames/frame_%04d.png),\n"
+        "                          or a single .y4m video file, or - to stream .y4m to stdout\n"
+        "  --png <fast|store>      PNG compression: filtered deflate or uncompressed (default fast)\n"
+        "  --layout <linear|tiled> framebuffer layout while rasterizing: rows or 8x8 blocks (default linear)\n"
+        "  --view <shaded|overdraw>  shaded image or an overdraw heatmap (default shaded)\n"
+        "  --fps <N>               frame rate written to the .y4m header (default 30)\n"
+        "  --zoom <Z>              turntable camera distance (default 5)\n"
+        "  --tilt <degrees>        turntable camera tilt (default 20)\n"
+        "  --math <exact|fast>     sin/cos and 1/sqrt for shapes, normals and lighting: libm or approximations (default exact)\n"
+        "  --cpu <level>           limit SIMD to scalar, sse2, sse4.1, avx2 or avx512 (default: best supported)\n"
+        "  --trace <file.json>     record per-stage timings and write a Chrome trace\n";
+}
+
+static bool ParseOptions(int argc, char** argv, BatchOptions& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") return false;
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--mesh") opt.mesh = value;
+        else if (arg == "--camera") opt.camera = value;
+        else if (arg == "--output") opt.output = value;
+        else if (arg == "--trace") opt.trace = value;
+        else if (arg == "--frames") opt.frames = std::atoi(value.c_str());
+        else if (arg == "--png") opt.pngStore = value == "store";
+        else if (arg == "--layout") opt.layout = value == "tiled" ? Renderer::Tiled : Renderer::Linear;
+        else if (arg == "--view") opt.view = value == "overdraw" ? Renderer::Overdraw : Renderer::Shaded;
+        else if (arg == "--fps") opt.fps = std::atoi(value.c_str());
+        else if (arg == "--threads") opt.threads = std::atoi(value.c_str());
+        else if (arg == "--zoom") opt.zoom = (float)std::atof(value.c_str());
+        else if (arg == "--tilt") opt.tilt = (float)std::atof(value.c_str());
+        else if (arg == "--math") FastMath::SetMode(value == "fast" ? FastMath::Fast : FastMath::Exact);
+        else if (arg == "--cpu") {
+            CpuFeatures::Level level;
+            if (!CpuFeatures::Parse(value, level) || !CpuFeatures::Force(level)) {
+                std::cerr << "Unknown or unsupported CPU level " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--size") {
+            if (std::sscanf(value.c_str(), "%dx%d", &opt.width, &opt.height) != 2) {
+                std::cerr << "Bad --size, expected WxH: " << value << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (opt.width <= 0 || opt.height <= 0 || opt.frames <= 0 || opt.fps <= 0) {
+        std::cerr << "Size, frame count and fps must be positive" << std::endl;
+        return false;
+    }
+    bool video = opt.output == "-" || fs::path(opt.output).extension() == ".y4m";
+    if (!video && !IsFramePathPattern(opt.output)) {
+        std::cerr << "Bad --output, expected one %d conversion for the frame index (use %% for a percent sign): "
+                  << opt.output << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static Mesh LoadBatchMesh(const std::string& name) {
+    if (name == "sphere") return ShapesGenerator::SmoothSphere(1.0f, 50, 50);
+    if (name == "torus") return ShapesGenerator::SmoothTorus(1.0f, 0.4f, 60, 30);
+    if (name == "icosphere") return ShapesGenerator::Icosphere(1.0f, 64);
+    if (name == "stress") return ShapesGenerator::InstanceField(ShapesGenerator::Icosphere(1.0f, 8), 400, 2.5f, 1);
+
+    Mesh mesh = Mesh::LoadFromFile(name);
+    if (!mesh.validated) mesh.faces.clear();
+    return mesh;
+}
+
+static bool LoadKeyframes(const std::string& filename, std::vector<CameraKey>& keys) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "ERROR: Could not open camera file " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::stringstream ss(line);
+        CameraKey key;
+        if (ss >> key.frame >> key.rotX >> key.rotY >> key.zoom) keys.push_back(key);
+    }
+    if (keys.empty()) {
+        std::cerr << "ERROR: No keyframes in " << filename << std::endl;
+        return false;
+    }
+
+    std::sort(keys.begin(), keys.end(), [](const CameraKey& a, const CameraKey& b) { return a.frame < b.frame; });
+    return true;
+}
+
+// Линейная интерполяция между ключами, за пределами — крайний ключ
+static CameraPose SampleKeyframes(const std::vector<CameraKey>& keys, float frame) {
+    const float toRad = PI / 180.0f;
+    auto it = std::upper_bound(keys.begin(), keys.end(), frame,
+                               [](float f, const CameraKey& k) { return f < k.frame; });
+    const CameraKey& a = (it == keys.begin()) ? *it : *(it - 1);
+    const CameraKey& b = (it == keys.end()) ? *(it - 1) : *it;
+
+    float t = (b.frame > a.frame) ? (frame - a.frame) / (b.frame - a.frame) : 0.0f;
+    t = std::clamp(t, 0.0f, 1.0f);
+    return {(a.rotX + (b.rotX - a.rotX) * t) * toRad,
+            (a.rotY + (b.rotY - a.rotY) * t) * toRad,
+            a.zoom + (b.zoom - a.zoom) * t};
+}
+
+int main(int argc, char** argv) {
+    BatchOptions opt;
+    if (!ParseOptions(argc, argv, opt)) {
+        PrintUsage();
+        return 1;
+    }
+
+    // Видео в stdout: весь текстовый вывод (включая сообщения загрузчиков) уходит в stderr
+    bool video = opt.output == "-" || fs::path(opt.output).extension() == ".y4m";
+    bool toStdout = opt.output == "-";
+    if (toStdout) std::cout.rdbuf(std::cerr.rdbuf());
+    FILE* report = toStdout ? stderr : stdout;
+
+    std::vector<CameraKey> keys;
+    bool turntable = opt.camera == "turntable";
+    if (!turntable && !LoadKeyframes(opt.camera, keys)) return 1;
+
+    auto loadStart = Clock::now();
+    Mesh mesh = LoadBatchMesh(opt.mesh);
+    double loadSeconds = std::chrono::duration<double>(Clock::now() - loadStart).count();
+    if (mesh.faces.empty()) {
+        std::cerr << "ERROR: Nothing to render in " << opt.mesh << std::endl;
+        return 1;
+    }
+
+    fs::path outDir = toStdout ? fs::path() : fs::path(opt.output).parent_path();
+    if (!outDir.empty()) {
+        std::error_code ec;
+        fs::create_directories(outDir, ec);
+    }
+
+    Profiler::SetEnabled(!opt.trace.empty());
+    Profiler::SetThreadName("main");
+
+    int threads = opt.threads > 0 ? opt.threads : HardwareThreads();
+    threads = std::min(threads, opt.frames);
+    Mat4 matProj = MakeProjection(opt.width, opt.height);
+
+    // Кадры уже идут параллельно, поэтому на сжатие одного PNG отдаём только свободные ядра
+    PngSettings png;
+    png.mode = opt.pngStore ? PngSettings::Store : PngSettings::Compressed;
+    png.threads = std::max(1, HardwareThreads() / threads);
+
+    // Время по стадиям суммируется по всем потокам
+    struct StageTimes {
+        double render = 0.0;
+        double encode = 0.0;
+        double queue = 0.0;
+        uint64_t renderAllocations = 0; // Выделений в куче при рисовании кадров после первого
+        RenderStats pipeline;
+    };
+    StageTimes total;
+    std::mutex totalMutex;
+
+    AsyncWriter writer(threads * 2);
+    Y4mWriter videoWriter;
+    if (video && !videoWriter.Open(opt.output, opt.width, opt.height, opt.fps, threads * 2)) return 1;
+    std::atomic<int> nextFrame{0};
+
+    auto start = Clock::now();
+
+    // Один кусок ParallelFor — один рабочий поток. Кадры раздаются по одному через счётчик,
+    // потому что их стоимость сильно различается (крупный план против общего вида)
+    ParallelFor(0, threads, [&](int first, int last) {
+        for (int worker = first; worker < last; worker++) {
+            Renderer renderer(opt.width, opt.height, nullptr, opt.layout);
+            StageTimes local;
+            std::string path;
+            Profiler::SetThreadName("worker " + std::to_string(worker));
+            renderer.SetViewMode(opt.view);
+            bool warmedUp = false;
+
+            for (int frame = nextFrame++; frame < opt.frames; frame = nextFrame++) {
+                PROFILE_SCOPE("Frame");
+                CameraPose pose = turntable
+                    ? CameraPose{opt.tilt * PI / 180.0f, 2.0f * PI * frame / opt.frames, opt.zoom}
+                    : SampleKeyframes(keys, (float)frame);
+
+                auto t0 = Clock::now();
+                {
+                    // Первый кадр потока разогревает арену кадра, дальше куча не нужна
+                    NoAllocScope noAlloc("batch frame render", warmedUp);
+                    renderer.Clear(MakeColor(40, 40, 40));
+                    RenderFaces(renderer, mesh.vertices, mesh.faces, MakeWorldMatrix(pose.rotX, pose.rotY, pose.zoom), matProj);
+                    renderer.Resolve();
+                    if (warmedUp) local.renderAllocations += noAlloc.GetCount();
+                    warmedUp = true;
+                }
+                local.pipeline += renderer.GetStats();
+
+                auto t1 = Clock::now();
+                std::vector<uint8_t> data;
+                if (video) {
+                    data = videoWriter.EncodeFrame(renderer.GetPixels(), renderer.GetStride());
+                } else {
+                    path = FormatFramePath(opt.output, frame);
+                    data = EncodeImage(path, renderer.GetPixels(), opt.width, opt.height, renderer.GetStride(), png);
+                }
+
+                auto t2 = Clock::now();
+                if (video) {
+                    videoWriter.WriteFrame(frame, std::move(data));
+                } else {
+                    writer.Write(path, std::move(data));
+                }
+
+                auto t3 = Clock::now();
+                local.render += std::chrono::duration<double>(t1 - t0).count();
+                local.encode += std::chrono::duration<double>(t2 - t1).count();
+                local.queue += std::chrono::duration<double>(t3 - t2).count();
+            }
+
+            std::lock_guard<std::mutex> lock(totalMutex);
+            total.render += local.render;
+            total.encode += local.encode;
+            total.queue += local.queue;
+            total.pipeline += local.pipeline;
+            total.renderAllocations += local.renderAllocations;
+        }
+    }, threads);
+
+    writer.Finish();
+    bool videoOk = videoWriter.Close();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    const WriterStats& io = video ? videoWriter.GetStats() : writer.GetStats();
+
+    double perFrame = 1000.0 / opt.frames;
+    std::fprintf(report, "Rendered %d frames %dx%d, %zu triangles, %d threads, %s layout, %s kernels, %s math\n",
+                opt.frames, opt.width, opt.height, mesh.faces.size(), threads,
+                opt.layout == Renderer::Tiled ? "tiled" : "linear", CpuFeatures::Name(CpuFeatures::Active()),
+                FastMath::GetMode() == FastMath::Fast ? "fast" : "exact");
+    std::fprintf(report, "  wall time   %8.3f s  (%.1f fps)\n", seconds, opt.frames / seconds);
+    std::fprintf(report, "  mesh load   %8.3f s\n", loadSeconds);
+    std::fprintf(report, "  render      %8.3f ms/frame\n", total.render * perFrame);
+    std::fprintf(report, video ? "  to I420     %8.3f ms/frame\n" : "  encode      %8.3f ms/frame\n", total.encode * perFrame);
+    std::fprintf(report, "  queue wait  %8.3f ms/frame\n", total.queue * perFrame);
+    std::fprintf(report, "  disk write  %8.3f ms/frame  (%d %s, %.1f MB, writer thread)\n",
+                io.writeSeconds * perFrame, io.files, video ? "frames" : "files", io.bytes / (1024.0 * 1024.0));
+
+    // Счётчики конвейера в среднем на кадр: видно, упирается ли сцена в геометрию или в заливку
+    const RenderStats& ps = total.pipeline;
+    double frames = opt.frames;
+    std::fprintf(report, "  faces       %10.0f submitted, %.0f back-culled, %.0f off-screen, %.0f clipped per frame\n",
+                ps.facesSubmitted / frames, ps.facesBackCulled / frames, ps.facesFrustumCulled / frames,
+                ps.trianglesClipped / frames);
+    std::fprintf(report, "  raster      %10.0f triangles, %.0f vertices transformed per frame\n",
+                ps.trianglesRasterized / frames, ps.verticesTransformed / frames);
+    std::fprintf(report, "  pixels      %10.0f tested, %.0f written per frame (overdraw %.2fx of the frame)\n",
+                ps.pixelsTested / frames, ps.pixelsWritten / frames,
+                ps.pixelsWritten / frames / ((double)opt.width * opt.height));
+    if (AllocTracker::IsEnabled()) {
+        std::fprintf(report, "  heap allocs %10llu in steady-state frame rendering\n",
+                    (unsigned long long)total.renderAllocations);
+    }
+
+    bool traceOk = opt.trace.empty() || Profiler::WriteChromeTrace(opt.trace);
+    if (!opt.trace.empty() && traceOk) std::fprintf(report, "  trace       %s\n", opt.trace.c_str());
+
+    return (io.failed == 0 && videoOk && traceOk) ? 0 : 1;
+}
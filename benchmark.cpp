@@ -0,0 +1,571 @@
+// Микробенчмарки ядра движка без окна: математика, растеризация, загрузка и генерация мешей.
+// Результаты — JSON (в stdout или файл), чтобы прогоны можно было сравнивать между коммитами.
+// Для параметрических наборов (размер меша, число потоков) каждая точка — отдельная запись.
+//
+// Каждая запись: несколько серий по iterations повторов, в отчёт идут медиана и минимум
+// времени одного повтора. Число повторов подбирается так, чтобы серия шла не меньше --min-time / 5.
+// На Linux, если ядро разрешает perf_event_open, туда же пишутся промахи TLB данных на повтор
+// (наборы с параметром huge_pages сравнивают буферы в обычных и огромных страницах).
+// Наборы kernel_* прогоняют каждый вариант ядер SIMD, который поддерживает машина; параметр
+// cpu_level — номер уровня: 0 scalar, 1 sse2, 2 sse4.1, 3 avx2, 4 avx512. Остальные наборы
+// идут на уровне --cpu (по умолчанию — лучшем доступном). Наборы math_* сравнивают режимы FastMath:
+// fast = 0 — libm, fast = 1 — приближения.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#include "renderer.h"
+#include "math_3d.h"
+#include "mesh.h"
+#include "shapes_generator.h"
+#include "parallel.h"
+#include "aligned_memory.h"
+#include "cpu_features.h"
+#include "simd_kernels.h"
+#include "fast_math.h"
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    std::string filter;
+    std::string output;
+    double minTime = 0.5;
+    bool quick = false;
+};
+
+struct BenchParam {
+    BenchParam(const char* name, double value) : name(name), value(value) {}
+    BenchParam(const char* name, int value) : name(name), value(value) {}
+    std::string name;
+    double value;
+};
+
+struct BenchResult {
+    std::string name;
+    std::vector<BenchParam> params;
+    long long iterations = 0;
+    double medianNs = 0.0;
+    double minNs = 0.0;
+    double items = 0.0;  // Единиц работы за повтор (вершин, треугольников, пикселей...)
+    std::string unit;
+    double tlbMisses = -1.0; // Промахов TLB данных за повтор, < 0 — счётчик недоступен
+};
+
+// Промахи TLB данных (чтение и запись) текущего потока через perf_event_open.
+// В контейнерах и при perf_event_paranoid > 2 счётчик обычно недоступен — тогда он просто молчит
+class TlbCounter {
+public:
+    TlbCounter() {
+#if defined(__linux__)
+        const uint64_t ops[2] = {PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_OP_WRITE};
+        for (int i = 0; i < 2; i++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | (ops[i] << 8) | ((uint64_t)PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            m_fd[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+#endif
+    }
+
+    ~TlbCounter() {
+#if defined(__linux__)
+        for (int fd : m_fd) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    bool IsAvailable() const { return m_fd[0] >= 0; }
+
+    void Start() {
+#if defined(__linux__)
+        for (int fd : m_fd) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    uint64_t Stop() {
+        uint64_t total = 0;
+#if defined(__linux__)
+        for (int fd : m_fd) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t value = 0;
+            if (read(fd, &value, sizeof(value)) == (ssize_t)sizeof(value)) total += value;
+        }
+#endif
+        return total;
+    }
+
+private:
+    int m_fd[2] = {-1, -1};
+};
+
+// Результаты складываются сюда, чтобы компилятор не выбросил «бесполезные» вычисления
+static volatile uint64_t g_sink = 0;
+
+static void Consume(uint64_t value) {
+    g_sink = g_sink + value;
+}
+
+static uint64_t Hash(const Vec3& v) {
+    uint32_t bits[3];
+    std::memcpy(bits, &v, sizeof(bits));
+    return bits[0] ^ ((uint64_t)bits[1] << 21) ^ ((uint64_t)bits[2] << 42);
+}
+
+// Простой детерминированный генератор для координат треугольников и линий
+static uint32_t NextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+class BenchRunner {
+public:
+    explicit BenchRunner(const BenchOptions& options) : m_options(options) {}
+
+    bool Enabled(const std::string& name) const {
+        return m_options.filter.empty() || name.find(m_options.filter) != std::string::npos;
+    }
+
+    bool Quick() const { return m_options.quick; }
+
+    template <class Body>
+    void Run(const std::string& name, const std::vector<BenchParam>& params, double items,
+             const std::string& unit, Body&& body) {
+        if (!Enabled(name)) return;
+
+        // Прогрев: первый вызов выделяет память и заполняет кэши
+        body();
+
+        const double batchTime = m_options.minTime / 5.0;
+        long long iterations = 1;
+        for (;;) {
+            double seconds = TimeBatch(body, iterations);
+            if (seconds >= batchTime || iterations >= (1LL << 30)) break;
+            double scale = seconds > 0.0 ? batchTime / seconds * 1.2 : 10.0;
+            iterations = std::max(iterations + 1, (long long)(iterations * std::min(scale, 10.0)));
+        }
+
+        std::vector<double> samples;
+        m_tlb.Start();
+        for (int batch = 0; batch < 5; batch++) {
+            samples.push_back(TimeBatch(body, iterations) * 1e9 / iterations);
+        }
+        uint64_t tlbMisses = m_tlb.Stop();
+        std::sort(samples.begin(), samples.end());
+
+        BenchResult result;
+        result.name = name;
+        result.params = params;
+        result.iterations = iterations;
+        result.medianNs = samples[samples.size() / 2];
+        result.minNs = samples.front();
+        result.items = items;
+        result.unit = unit;
+        if (m_tlb.IsAvailable()) result.tlbMisses = (double)tlbMisses / (5.0 * iterations);
+        m_results.push_back(result);
+
+        std::cerr << "  " << name;
+        for (const BenchParam& p : params) std::cerr << " " << p.name << "=" << p.value;
+        std::fprintf(stderr, ": %.3f us/iter, %.3g %s/s", result.medianNs / 1000.0,
+                     items / (result.medianNs * 1e-9), unit.c_str());
+        if (result.tlbMisses >= 0.0) std::fprintf(stderr, ", %.0f dTLB misses/iter", result.tlbMisses);
+        std::fprintf(stderr, "\n");
+    }
+
+    bool WriteJson() const;
+
+private:
+    BenchOptions m_options;
+    std::vector<BenchResult> m_results;
+    TlbCounter m_tlb;
+
+    template <class Body>
+    static double TimeBatch(Body& body, long long iterations) {
+        auto start = Clock::now();
+        for (long long i = 0; i < iterations; i++) body();
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+};
+
+bool BenchRunner::WriteJson() const {
+    FILE* out = m_options.output.empty() ? stdout : std::fopen(m_options.output.c_str(), "w");
+    if (!out) {
+        std::cerr << "ERROR: Could not write " << m_options.output << std::endl;
+        return false;
+    }
+
+    std::fprintf(out, "{\n  \"hardware_threads\": %d,\n", HardwareThreads());
+#ifdef NDEBUG
+    std::fprintf(out, "  \"build\": \"release\",\n");
+#else
+    std::fprintf(out, "  \"build\": \"debug\",\n");
+#endif
+    std::fprintf(out, "  \"min_time\": %g,\n  \"results\": [\n", m_options.minTime);
+    for (size_t i = 0; i < m_results.size(); i++) {
+        const BenchResult& r = m_results[i];
+        std::fprintf(out, "    {\"name\": \"%s\", \"params\": {", r.name.c_str());
+        for (size_t p = 0; p < r.params.size(); p++) {
+            std::fprintf(out, "%s\"%s\": %g", p ? ", " : "", r.params[p].name.c_str(), r.params[p].value);
+        }
+        std::fprintf(out, "}, \"iterations\": %lld, \"ns_per_iter\": %.1f, \"ns_per_iter_min\": %.1f, "
+                     "\"items_per_iter\": %g, \"unit\": \"%s\", \"items_per_second\": %.6g",
+                     r.iterations, r.medianNs, r.minNs, r.items, r.unit.c_str(), r.items / (r.medianNs * 1e-9));
+        if (r.tlbMisses >= 0.0) std::fprintf(out, ", \"dtlb_misses_per_iter\": %.1f", r.tlbMisses);
+        std::fprintf(out, "}%s\n", i + 1 < m_results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+
+    bool ok = true;
+    if (out != stdout) ok = std::fclose(out) == 0;
+    else std::fflush(out);
+    if (!ok) std::cerr << "ERROR: Could not write " << m_options.output << std::endl;
+    return ok;
+}
+
+// Число потоков для прогонов: 1, 2, 4, ... и обязательно все ядра машины
+static std::vector<int> ThreadSweep() {
+    std::vector<int> counts;
+    int hardware = HardwareThreads();
+    for (int t = 1; t < hardware; t *= 2) counts.push_back(t);
+    counts.push_back(hardware);
+    return counts;
+}
+
+// --- Математика ---
+
+static void BenchMath(BenchRunner& bench) {
+    const int count = 1024;
+    std::vector<Mat4> a(count), b(count), product(count);
+    for (int i = 0; i < count; i++) {
+        a[i] = Mat4::RotateX(i * 0.01f) * Mat4::Translate(0.0f, 0.0f, (float)i);
+        b[i] = Mat4::RotateY(i * 0.02f);
+    }
+    bench.Run("mat4_multiply", {{"count", count}}, count, "products", [&] {
+        for (int i = 0; i < count; i++) product[i] = a[i] * b[i];
+        Consume((uint64_t)product[count / 2].m[3][2]);
+    });
+
+    std::vector<Affine3x4> affineA(count), affineB(count), affineProduct(count);
+    for (int i = 0; i < count; i++) {
+        affineA[i] = Affine3x4::RotateX(i * 0.01f) * Affine3x4::Translate(0.0f, 0.0f, (float)i);
+        affineB[i] = Affine3x4::RotateY(i * 0.02f);
+    }
+    bench.Run("affine_multiply", {{"count", count}}, count, "products", [&] {
+        for (int i = 0; i < count; i++) affineProduct[i] = affineA[i] * affineB[i];
+        Consume((uint64_t)affineProduct[count / 2].m[2][3]);
+    });
+    bench.Run("affine_inverse_rigid", {{"count", count}}, count, "inverses", [&] {
+        for (int i = 0; i < count; i++) affineProduct[i] = affineA[i].InverseRigid();
+        Consume((uint64_t)affineProduct[count / 2].m[2][3]);
+    });
+
+    Mat4 matWorld = Mat4::Translate(0.0f, 0.0f, 5.0f) * Mat4::RotateY(0.7f) * Mat4::RotateX(0.3f);
+    std::vector<int> sizes = bench.Quick() ? std::vector<int>{1 << 10, 1 << 16}
+                                           : std::vector<int>{1 << 10, 1 << 14, 1 << 18, 1 << 20};
+    for (int size : sizes) {
+        std::vector<Vec3> input(size), output(size);
+        for (int i = 0; i < size; i++) input[i] = Vec3((float)(i % 97), (float)(i % 89), (float)(i % 83));
+
+        for (int threads : ThreadSweep()) {
+            bench.Run("transform_vertices", {{"vertices", size}, {"threads", threads}}, size, "vertices", [&] {
+                ParallelFor(0, size, [&](int first, int last) {
+                    for (int i = first; i < last; i++) output[i] = MultiplyMatrixVector(input[i], matWorld);
+                }, threads);
+                Consume(Hash(output[size / 2]));
+            });
+        }
+    }
+}
+
+// --- Растеризация ---
+
+static void BenchRaster(BenchRunner& bench) {
+    const int width = 1920;
+    const int height = 1080;
+    Renderer renderer(width, height);
+    renderer.Clear(MakeColor(40, 40, 40));
+
+    // Прямоугольные треугольники с катетом size в случайных местах экрана
+    const int trianglesPerIter = 256;
+    for (int size : {4, 16, 64, 256, 1024}) {
+        uint32_t state = 12345;
+        bench.Run("draw_triangle", {{"size", size}}, trianglesPerIter, "triangles", [&] {
+            for (int i = 0; i < trianglesPerIter; i++) {
+                int x = (int)(NextRandom(state) % (uint32_t)(width - size));
+                int y = (int)(NextRandom(state) % (uint32_t)(height - size));
+                renderer.DrawTriangle(x, y, x, y + size, x + size, y, MakeColor(255, 165, 0));
+            }
+        });
+    }
+
+    const int linesPerIter = 256;
+    for (int length : {16, 256, 1024}) {
+        uint32_t state = 777;
+        bench.Run("draw_line", {{"length", length}}, linesPerIter, "lines", [&] {
+            for (int i = 0; i < linesPerIter; i++) {
+                int x = (int)(NextRandom(state) % (uint32_t)(width - length));
+                int y = (int)(NextRandom(state) % (uint32_t)(height - length / 2));
+                renderer.DrawLine(x, y, x + length, y + length / 2, MakeColor(255, 255, 255));
+            }
+        });
+    }
+
+    // Очистка с чередованием цвета: каждый раз заливается весь кадр.
+    // С 4K буфер сравнивается в обычных и огромных страницах; вертикальные узкие треугольники
+    // на каждой строке попадают в новую страницу памяти — худший случай для TLB
+    struct Size { int width, height; };
+    for (Size size : {Size{800, 600}, Size{1920, 1080}, Size{3840, 2160}, Size{7680, 4320}}) {
+        bool large = size.width >= 3840;
+        if (large && bench.Quick() && size.width > 3840) continue;
+        for (int hugePages = large ? 0 : 1; hugePages <= 1; hugePages++) {
+            AlignedMemory::SetHugePages(hugePages != 0);
+            Renderer target(size.width, size.height);
+            AlignedMemory::SetHugePages(true);
+
+            bool odd = false;
+            double pixels = (double)size.width * size.height;
+            std::vector<BenchParam> params = {{"width", size.width}, {"height", size.height}};
+            if (large) params.push_back({"huge_pages", hugePages});
+            bench.Run("clear", params, pixels, "pixels", [&] {
+                odd = !odd;
+                target.Clear(odd ? MakeColor(40, 40, 40) : MakeColor(10, 10, 10));
+                target.Resolve();
+                Consume(target.GetPixels()[0]);
+            });
+            if (!large) continue;
+
+            const int columnsPerIter = 16;
+            uint32_t state = 4242;
+            target.Clear(MakeColor(40, 40, 40));
+            bench.Run("draw_tall_triangle", params, columnsPerIter, "triangles", [&] {
+                for (int i = 0; i < columnsPerIter; i++) {
+                    int x = (int)(NextRandom(state) % (uint32_t)(size.width - 8));
+                    target.DrawTriangle(x, 0, x + 8, 0, x + 4, size.height - 1, MakeColor(255, 165, 0));
+                }
+            });
+        }
+    }
+}
+
+// --- Ядра SIMD ---
+
+static void BenchKernels(BenchRunner& bench) {
+    const int vertexCount = 1 << 14;
+    AlignedVector<Vec3> input(vertexCount), output(vertexCount);
+    for (int i = 0; i < vertexCount; i++) input[i] = Vec3((float)(i % 97), (float)(i % 89), (float)(i % 83));
+    Mat4 matWorld = Mat4::Translate(0.0f, 0.0f, 5.0f) * Mat4::RotateY(0.7f) * Mat4::RotateX(0.3f);
+    Affine3x4 affineWorld = Affine3x4::Translate(0.0f, 0.0f, 5.0f) * Affine3x4::RotateY(0.7f) * Affine3x4::RotateX(0.3f);
+
+    // Строки треугольника длиной 1920, пересечение с треугольником примерно на половине
+    const int spanWidth = 1920;
+    const int spanRows = 64;
+    AlignedVector<uint32_t> pixels((size_t)spanWidth * spanRows);
+
+    // Углы одного оборота и квадраты длин в типичном для нормалей диапазоне
+    const int mathCount = 4096;
+    std::vector<float> angles(mathCount), lengths(mathCount), sines(mathCount), cosines(mathCount);
+    for (int k = 0; k < mathCount; k++) {
+        angles[k] = (float)k / mathCount * 6.2831853f;
+        lengths[k] = 0.01f + (float)(k % 1000);
+    }
+
+    for (int i = CpuFeatures::Scalar; i <= CpuFeatures::Detected(); i++) {
+        const SimdKernels& kernels = GetKernels((CpuFeatures::Level)i);
+        bench.Run("kernel_transform_points", {{"cpu_level", i}}, vertexCount, "vertices", [&] {
+            kernels.transformPoints(input.data(), output.data(), vertexCount, matWorld);
+            Consume(Hash(output[vertexCount / 2]));
+        });
+        bench.Run("kernel_transform_affine", {{"cpu_level", i}}, vertexCount, "vertices", [&] {
+            kernels.transformAffine(input.data(), output.data(), vertexCount, affineWorld);
+            Consume(Hash(output[vertexCount / 2]));
+        });
+        bench.Run("kernel_raster_span", {{"cpu_level", i}}, (double)spanWidth * spanRows, "pixels", [&] {
+            uint64_t written = 0;
+            for (int y = 0; y < spanRows; y++) {
+                written += kernels.rasterSpan(pixels.data() + (size_t)y * spanWidth, spanWidth, 1000 + y, 50000, -500 + y * 8,
+                                              -1, 0, 1, MakeColor(255, 165, 0));
+            }
+            Consume(written);
+        });
+        bench.Run("kernel_stream_fill", {{"cpu_level", i}}, (double)pixels.size(), "pixels", [&] {
+            kernels.streamFill(pixels.data(), pixels.data() + pixels.size(), (uint32_t)i);
+            Consume(pixels[pixels.size() / 2]);
+        });
+        bench.Run("kernel_sincos", {{"cpu_level", i}}, mathCount, "angles", [&] {
+            kernels.sinCos(angles.data(), sines.data(), cosines.data(), mathCount);
+            Consume((uint64_t)(sines[mathCount / 2] * 1000.0f));
+        });
+        bench.Run("kernel_rsqrt", {{"cpu_level", i}}, mathCount, "values", [&] {
+            kernels.rsqrt(lengths.data(), sines.data(), mathCount);
+            Consume((uint64_t)(sines[mathCount / 2] * 1000.0f));
+        });
+    }
+
+    // Режимы FastMath на активном уровне
+    FastMath::Mode previous = FastMath::GetMode();
+    AlignedVector<Vec3> vectors(mathCount);
+    for (int fast = 0; fast <= 1; fast++) {
+        FastMath::SetMode(fast ? FastMath::Fast : FastMath::Exact);
+        bench.Run("math_sincos", {{"fast", fast}}, mathCount, "angles", [&] {
+            FastMath::SinCos(angles.data(), sines.data(), cosines.data(), mathCount);
+            Consume((uint64_t)(sines[mathCount / 2] * 1000.0f));
+        });
+        bench.Run("math_normalize", {{"fast", fast}}, mathCount, "vectors", [&] {
+            for (int k = 0; k < mathCount; k++) vectors[k] = input[k];
+            FastMath::Normalize(vectors.data(), mathCount);
+            Consume(Hash(vectors[mathCount / 2]));
+        });
+    }
+    FastMath::SetMode(previous);
+}
+
+// --- Меши ---
+
+static void BenchMeshes(BenchRunner& bench) {
+    // Синтетические .obj: маленький (сетка 16x16) и большой (сетка на сотни тысяч граней)
+    fs::path dir = fs::temp_directory_path() / "engine_bench";
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+
+    struct ObjCase { const char* name; int cells; };
+    std::vector<ObjCase> cases = {{"small", 16}, {"huge", bench.Quick() ? 128 : 512}};
+    for (const ObjCase& c : cases) {
+        if (!bench.Enabled("load_obj")) break;
+        std::string path = (dir / (std::string(c.name) + ".obj")).string();
+        Mesh source = ShapesGenerator::Grid(2.0f, c.cells, c.cells);
+        if (!source.SaveToObj(path)) continue;
+
+        double faces = (double)source.faces.size();
+        bench.Run("load_obj", {{"faces", faces}}, faces, "faces", [&] {
+            Mesh mesh = Mesh::LoadFromObj(path);
+            Consume(mesh.faces.size());
+        });
+        fs::remove(path, ec);
+    }
+    fs::remove(dir, ec);
+
+    // Генераторы: сами по себе и в зависимости от числа потоков
+    std::vector<int> frequencies = bench.Quick() ? std::vector<int>{16, 64} : std::vector<int>{16, 64, 256};
+    for (int frequency : frequencies) {
+        double faces = 20.0 * frequency * frequency;
+        for (int threads : ThreadSweep()) {
+            bench.Run("shapes_icosphere", {{"faces", faces}, {"threads", threads}}, faces, "faces", [&] {
+                Mesh mesh = ShapesGenerator::Icosphere(1.0f, frequency, threads);
+                Consume(mesh.faces.size());
+            });
+        }
+    }
+
+    for (int threads : ThreadSweep()) {
+        double faces = 2.0 * 512 * 256;
+        bench.Run("shapes_stress_torus", {{"faces", faces}, {"threads", threads}}, faces, "faces", [&] {
+            Mesh mesh = ShapesGenerator::StressTorus(1.0f, 0.4f, 512, 256, threads);
+            Consume(mesh.faces.size());
+        });
+    }
+
+    Mesh base = ShapesGenerator::Icosphere(1.0f, 8, 1);
+    for (int count : {16, 400}) {
+        double faces = (double)base.faces.size() * count;
+        for (int threads : ThreadSweep()) {
+            bench.Run("shapes_instance_field", {{"faces", faces}, {"threads", threads}}, faces, "faces", [&] {
+                Mesh mesh = ShapesGenerator::InstanceField(base, count, 2.5f, 1, threads);
+                Consume(mesh.faces.size());
+            });
+        }
+    }
+}
+
+static void PrintUsage() {
+    std::cerr <<
+        "Usage: engine_bench [options]\n"
+        "  --filter <text>     run only benchmarks whose name contains text\n"
+        "  --output <file>     write the JSON report to a file instead of stdout\n"
+        "  --min-time <sec>    approximate measuring time per benchmark point (default 0.5)\n"
+        "  --quick             smaller sweeps and 0.1 s per point, for a fast sanity run\n"
+        "  --cpu <level>       limit SIMD to scalar, sse2, sse4.1, avx2 or avx512 outside the kernel_* sets\n";
+}
+
+static bool ParseOptions(int argc, char** argv, BenchOptions& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") return false;
+        if (arg == "--quick") {
+            opt.quick = true;
+            opt.minTime = 0.1;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--filter") opt.filter = value;
+        else if (arg == "--output") opt.output = value;
+        else if (arg == "--min-time") opt.minTime = std::atof(value.c_str());
+        else if (arg == "--cpu") {
+            CpuFeatures::Level level;
+            if (!CpuFeatures::Parse(value, level) || !CpuFeatures::Force(level)) {
+                std::cerr << "Unknown or unsupported CPU level " << value << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    if (opt.minTime <= 0.0) {
+        std::cerr << "--min-time must be positive" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    if (!ParseOptions(argc, argv, opt)) {
+        PrintUsage();
+        return 1;
+    }
+
+#ifndef NDEBUG
+    std::cerr << "WARNING: engine_bench built without optimizations, configure with -DCMAKE_BUILD_TYPE=Release" << std::endl;
+#endif
+
+    // Загрузчики мешей пишут о каждом файле в std::cout; отчёт идёт через stdout отдельно
+    std::cout.setstate(std::ios::failbit);
+
+    BenchRunner bench(opt);
+    BenchMath(bench);
+    BenchRaster(bench);
+    BenchKernels(bench);
+    BenchMeshes(bench);
+    return bench.WriteJson() ? 0 : 1;
+}
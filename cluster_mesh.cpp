@@ -0,0 +1,418 @@
+#include "cluster_mesh.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+static const char CLUSTER_MAGIC[4] = {'C', 'M', 'S', 'H'};
+static const uint32_t CLUSTER_VERSION = 1;
+
+// Раскладывает 10 бит по каждой третьей позиции (для 30-битного кода Мортона)
+static uint32_t ExpandBits(uint32_t v) {
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+static uint32_t MortonCode(float x, float y, float z) {
+    auto quantize = [](float f) { return (uint32_t)std::min(std::max(f * 1024.0f, 0.0f), 1023.0f); };
+    return (ExpandBits(quantize(x)) << 2) | (ExpandBits(quantize(y)) << 1) | ExpandBits(quantize(z));
+}
+
+static float Length(const Vec3& v) {
+    return std::sqrt(DotProduct(v, v));
+}
+
+// Упрощение кластера кластеризацией вершин: все вершины одной ячейки сетки сливаются в одну,
+// вырожденные после этого треугольники выбрасываются.
+static void SimplifyCluster(const std::vector<Vec3>& srcVerts, const std::vector<Mesh::Face>& srcFaces,
+                            const Vec3& boxMin, float cellSize, int resolution,
+                            std::vector<Vec3>& outVerts, std::vector<Mesh::Face>& outFaces) {
+    outVerts.clear();
+    outFaces.clear();
+
+    std::unordered_map<uint32_t, int> cellToVertex;
+    std::vector<int> remap(srcVerts.size());
+    std::vector<int> counts;
+
+    for (size_t i = 0; i < srcVerts.size(); i++) {
+        const Vec3& v = srcVerts[i];
+        auto cell = [&](float f) { return (uint32_t)std::min((int)(f / cellSize), resolution - 1); };
+        uint32_t key = (cell(v.x - boxMin.x) * (uint32_t)resolution + cell(v.y - boxMin.y)) * (uint32_t)resolution + cell(v.z - boxMin.z);
+
+        auto it = cellToVertex.find(key);
+        if (it == cellToVertex.end()) {
+            it = cellToVertex.emplace(key, (int)outVerts.size()).first;
+            outVerts.push_back(Vec3());
+            counts.push_back(0);
+        }
+        remap[i] = it->second;
+        outVerts[it->second] = outVerts[it->second] + v;
+        counts[it->second]++;
+    }
+
+    // Представитель ячейки — среднее положение её вершин
+    for (size_t i = 0; i < outVerts.size(); i++) outVerts[i] = outVerts[i] * (1.0f / counts[i]);
+
+    for (const auto& f : srcFaces) {
+        Mesh::Face nf = {{remap[f.v[0]], remap[f.v[1]], remap[f.v[2]]}};
+        if (nf.v[0] == nf.v[1] || nf.v[1] == nf.v[2] || nf.v[0] == nf.v[2]) continue;
+        outFaces.push_back(nf);
+    }
+}
+
+namespace ClusterFile {
+
+bool Write(const Mesh& mesh, const std::string& filename, int facesPerCluster) {
+    if (mesh.faces.empty() || facesPerCluster <= 0) {
+        std::cerr << "Nothing to write into " << filename << std::endl;
+        return false;
+    }
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Failed to create " << filename << std::endl;
+        return false;
+    }
+
+    // 1. Границы меша для нормализации центров граней
+    Vec3 boxMin = mesh.vertices.empty() ? Vec3() : mesh.vertices[0];
+    Vec3 boxMax = boxMin;
+    for (const auto& v : mesh.vertices) {
+        boxMin = Vec3(std::min(boxMin.x, v.x), std::min(boxMin.y, v.y), std::min(boxMin.z, v.z));
+        boxMax = Vec3(std::max(boxMax.x, v.x), std::max(boxMax.y, v.y), std::max(boxMax.z, v.z));
+    }
+    Vec3 extent = boxMax - boxMin;
+    float maxExtent = std::max({extent.x, extent.y, extent.z, 1e-6f});
+
+    // 2. Сортируем грани по коду Мортона центра: соседние в массиве грани оказываются рядом в пространстве
+    std::vector<std::pair<uint32_t, int>> order;
+    order.reserve(mesh.faces.size());
+    for (size_t i = 0; i < mesh.faces.size(); i++) {
+        const Mesh::Face& f = mesh.faces[i];
+        if (f.v[0] < 0 || f.v[1] < 0 || f.v[2] < 0 ||
+            f.v[0] >= (int)mesh.vertices.size() ||
+            f.v[1] >= (int)mesh.vertices.size() ||
+            f.v[2] >= (int)mesh.vertices.size()) continue;
+        Vec3 c = (mesh.vertices[f.v[0]] + mesh.vertices[f.v[1]] + mesh.vertices[f.v[2]]) * (1.0f / 3.0f) - boxMin;
+        order.push_back({MortonCode(c.x / maxExtent, c.y / maxExtent, c.z / maxExtent), (int)i});
+    }
+    std::sort(order.begin(), order.end());
+
+    ClusterFileHeader header{};
+    std::memcpy(header.magic, CLUSTER_MAGIC, 4);
+    header.version = CLUSTER_VERSION;
+    header.clusterCount = (uint32_t)((order.size() + facesPerCluster - 1) / facesPerCluster);
+    header.lodCount = CLUSTER_MAX_LODS;
+    Vec3 center = (boxMin + boxMax) * 0.5f;
+    header.boundsCenter[0] = center.x; header.boundsCenter[1] = center.y; header.boundsCenter[2] = center.z;
+    header.boundsRadius = Length(extent) * 0.5f;
+
+    // Таблицу пишем заглушкой и перезаписываем в конце, когда станут известны смещения блоков
+    std::vector<ClusterRecord> records(header.clusterCount);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(ClusterRecord));
+
+    std::vector<int> remap(mesh.vertices.size(), -1);
+    std::vector<Vec3> lodVerts[CLUSTER_MAX_LODS];
+    std::vector<Mesh::Face> lodFaces[CLUSTER_MAX_LODS];
+
+    for (uint32_t c = 0; c < header.clusterCount; c++) {
+        size_t first = (size_t)c * facesPerCluster;
+        size_t last = std::min(first + facesPerCluster, order.size());
+
+        // 3. LOD0: локальная нумерация вершин кластера
+        lodVerts[0].clear();
+        lodFaces[0].clear();
+        for (size_t i = first; i < last; i++) {
+            const Mesh::Face& f = mesh.faces[order[i].second];
+            Mesh::Face local;
+            for (int k = 0; k < 3; k++) {
+                int& idx = remap[f.v[k]];
+                if (idx < 0) {
+                    idx = (int)lodVerts[0].size();
+                    lodVerts[0].push_back(mesh.vertices[f.v[k]]);
+                }
+                local.v[k] = idx;
+            }
+            lodFaces[0].push_back(local);
+        }
+        // Сбрасываем только тронутые элементы, чтобы не чистить весь массив на каждый кластер
+        for (size_t i = first; i < last; i++)
+            for (int k = 0; k < 3; k++) remap[mesh.faces[order[i].second].v[k]] = -1;
+
+        Vec3 cMin = lodVerts[0][0], cMax = cMin;
+        for (const auto& v : lodVerts[0]) {
+            cMin = Vec3(std::min(cMin.x, v.x), std::min(cMin.y, v.y), std::min(cMin.z, v.z));
+            cMax = Vec3(std::max(cMax.x, v.x), std::max(cMax.y, v.y), std::max(cMax.z, v.z));
+        }
+        Vec3 cCenter = (cMin + cMax) * 0.5f;
+        float cRadius = 0.0f;
+        for (const auto& v : lodVerts[0]) cRadius = std::max(cRadius, Length(v - cCenter));
+        Vec3 cExtent = cMax - cMin;
+        float cMaxExtent = std::max({cExtent.x, cExtent.y, cExtent.z, 1e-6f});
+
+        ClusterRecord& rec = records[c];
+        rec.center[0] = cCenter.x; rec.center[1] = cCenter.y; rec.center[2] = cCenter.z;
+        rec.radius = cRadius;
+
+        // 4. Грубые уровни: сетка 16^3, 8^3, 4^3 ячеек по кластеру
+        for (int lod = 1; lod < CLUSTER_MAX_LODS; lod++) {
+            int resolution = 16 >> (lod - 1);
+            float cellSize = cMaxExtent / resolution;
+            SimplifyCluster(lodVerts[0], lodFaces[0], cMin, cellSize, resolution, lodVerts[lod], lodFaces[lod]);
+            rec.lods[lod].error = cellSize * 0.87f; // Половина диагонали ячейки
+        }
+
+        // 5. Блоки данных, выровненные по 16 байт
+        size_t prevFaces = 0;
+        for (int lod = 0; lod < CLUSTER_MAX_LODS; lod++) {
+            // Пустой уровень или уровень без выигрыша не записываем
+            if (lodFaces[lod].empty() || (lod > 0 && lodFaces[lod].size() >= prevFaces)) continue;
+            prevFaces = lodFaces[lod].size();
+
+            std::streamoff pos = out.tellp();
+            static const char zeros[16] = {};
+            if (pos % 16) out.write(zeros, 16 - pos % 16);
+
+            rec.lods[lod].offset = (uint64_t)out.tellp();
+            rec.lods[lod].vertexCount = (uint32_t)lodVerts[lod].size();
+            rec.lods[lod].faceCount = (uint32_t)lodFaces[lod].size();
+            out.write(reinterpret_cast<const char*>(lodVerts[lod].data()), lodVerts[lod].size() * sizeof(Vec3));
+            out.write(reinterpret_cast<const char*>(lodFaces[lod].data()), lodFaces[lod].size() * sizeof(Mesh::Face));
+        }
+    }
+
+    out.seekp(sizeof(header));
+    out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(ClusterRecord));
+    out.close();
+
+    if (!out) {
+        std::cerr << "Failed to write " << filename << std::endl;
+        return false;
+    }
+    std::cout << "Wrote " << filename << ": " << header.clusterCount << " clusters." << std::endl;
+    return true;
+}
+
+}
+
+// --- ClusterStream ---
+
+bool ClusterStream::Open(const std::string& filename) {
+    Close();
+    if (!m_file.Open(filename)) return false;
+
+    if (m_file.Size() < sizeof(ClusterFileHeader)) {
+        std::cerr << "ERROR: " << filename << " is too small for a cluster file" << std::endl;
+        Close();
+        return false;
+    }
+
+    std::memcpy(&m_header, m_file.Data(), sizeof(m_header));
+    size_t tableEnd = sizeof(ClusterFileHeader) + (size_t)m_header.clusterCount * sizeof(ClusterRecord);
+    if (std::memcmp(m_header.magic, CLUSTER_MAGIC, 4) != 0 || m_header.version != CLUSTER_VERSION ||
+        m_header.lodCount != CLUSTER_MAX_LODS || tableEnd > m_file.Size()) {
+        std::cerr << "ERROR: " << filename << " is not a valid cluster file" << std::endl;
+        Close();
+        return false;
+    }
+
+    // Таблица лежит сразу за заголовком и читается прямо из отображения
+    m_clusters = reinterpret_cast<const ClusterRecord*>(m_file.Data() + sizeof(ClusterFileHeader));
+    m_stats.clusters = (int)m_header.clusterCount;
+
+    std::cout << "Streaming " << filename << ": " << m_header.clusterCount << " clusters." << std::endl;
+    return true;
+}
+
+void ClusterStream::Close() {
+    m_resident.clear();
+    m_lru.clear();
+    m_residentBytes = 0;
+    m_drawList.clear();
+    m_requests.clear();
+    m_failed.clear();
+    m_clusters = nullptr;
+    m_header = ClusterFileHeader{};
+    m_stats = Stats();
+    m_file.Close();
+}
+
+const ClusterStream::Page* ClusterStream::Touch(uint32_t key) {
+    auto it = m_resident.find(key);
+    if (it == m_resident.end()) return nullptr;
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lruPos);
+    it->second.lastUsedFrame = m_frame;
+    return &it->second.page;
+}
+
+bool ClusterStream::MakeRoom(size_t bytes) {
+    if (bytes > settings.budgetBytes) return false;
+
+    while (m_residentBytes + bytes > settings.budgetBytes) {
+        if (m_lru.empty()) return false;
+        uint32_t victim = m_lru.back();
+        auto it = m_resident.find(victim);
+        // Страницы, нужные в текущем кадре, не вытесняем: лучше догрузить их позже
+        if (it->second.lastUsedFrame == m_frame) return false;
+        m_residentBytes -= it->second.bytes;
+        m_resident.erase(it);
+        m_lru.pop_back();
+        m_stats.evicted++;
+    }
+    return true;
+}
+
+ClusterStream::LoadResult ClusterStream::Load(uint32_t key) {
+    const ClusterLodRecord& lod = m_clusters[key / CLUSTER_MAX_LODS].lods[key % CLUSTER_MAX_LODS];
+    size_t vertexBytes = (size_t)lod.vertexCount * sizeof(Vec3);
+    size_t faceBytes = (size_t)lod.faceCount * sizeof(Mesh::Face);
+    size_t bytes = vertexBytes + faceBytes;
+
+    // Всё проверяется до MakeRoom, чтобы испорченная страница не вытесняла исправные.
+    // Данные пришли с диска: индексы проверяем один раз здесь, а не в горячем цикле
+    const char* problem = nullptr;
+    if (lod.offset == 0 || lod.offset % alignof(Vec3) != 0 || lod.offset > m_file.Size() || bytes > m_file.Size() - lod.offset) {
+        problem = "bad offset or size";
+    } else if (bytes > settings.budgetBytes) {
+        problem = "larger than the memory budget";
+    } else {
+        const uint8_t* faces = m_file.Data() + lod.offset + vertexBytes;
+        for (uint32_t i = 0; i < lod.faceCount && !problem; i++) {
+            Mesh::Face f;
+            std::memcpy(&f, faces + (size_t)i * sizeof(Mesh::Face), sizeof(f));
+            for (int k = 0; k < 3; k++)
+                if (f.v[k] < 0 || f.v[k] >= (int)lod.vertexCount) problem = "vertex index out of range";
+        }
+    }
+    if (problem) {
+        std::cerr << "ERROR: Corrupted cluster " << key / CLUSTER_MAX_LODS << " LOD " << key % CLUSTER_MAX_LODS << ": "
+                  << problem << std::endl;
+        m_failed.insert(key);
+        return Failed;
+    }
+    if (!MakeRoom(bytes)) return NoRoom;
+
+    const uint8_t* src = m_file.Data() + lod.offset;
+    Resident res;
+    res.page.vertices.resize(lod.vertexCount);
+    res.page.faces.resize(lod.faceCount);
+    std::memcpy(res.page.vertices.data(), src, vertexBytes);
+    std::memcpy(res.page.faces.data(), src + vertexBytes, faceBytes);
+
+    // Копия сделана — исходные страницы отображения больше не нужны
+    m_file.Release((size_t)lod.offset, bytes);
+
+    res.bytes = bytes;
+    res.lastUsedFrame = m_frame;
+    m_lru.push_front(key);
+    res.lruPos = m_lru.begin();
+    m_resident.emplace(key, std::move(res));
+    m_residentBytes += bytes;
+    m_stats.loaded++;
+    return Loaded;
+}
+
+const std::vector<const ClusterStream::Page*>& ClusterStream::Update(const Affine3x4& matWorld, const Mat4& matProj, int screenHeight) {
+    m_frame++;
+    m_drawList.clear();
+    m_requests.clear();
+
+    int clusters = m_stats.clusters;
+    m_stats = Stats();
+    m_stats.clusters = clusters;
+
+    if (!IsOpen()) return m_drawList;
+
+    // Плоскости пирамиды видимости из матрицы clip = Proj * World (метод Gribb/Hartmann).
+    // Глубина после проекции лежит в [0, w], поэтому ближняя плоскость — просто третья строка.
+    Mat4 clip = matProj * matWorld.ToMat4();
+    float planes[6][4];
+    for (int i = 0; i < 4; i++) {
+        planes[0][i] = clip.m[3][i] + clip.m[0][i]; // Левая
+        planes[1][i] = clip.m[3][i] - clip.m[0][i]; // Правая
+        planes[2][i] = clip.m[3][i] + clip.m[1][i]; // Нижняя
+        planes[3][i] = clip.m[3][i] - clip.m[1][i]; // Верхняя
+        planes[4][i] = clip.m[2][i];                // Ближняя
+        planes[5][i] = clip.m[3][i] - clip.m[2][i]; // Дальняя
+    }
+    for (auto& p : planes) {
+        float len = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        if (len > 0.0f) for (float& f : p) f /= len;
+    }
+
+    // Сколько пикселей по вертикали занимает единица длины на расстоянии 1
+    float pixelScale = matProj.m[1][1] * screenHeight * 0.5f;
+
+    for (uint32_t c = 0; c < m_header.clusterCount; c++) {
+        const ClusterRecord& rec = m_clusters[c];
+
+        bool inside = true;
+        for (const auto& p : planes) {
+            if (p[0] * rec.center[0] + p[1] * rec.center[1] + p[2] * rec.center[2] + p[3] < -rec.radius) {
+                inside = false;
+                break;
+            }
+        }
+        if (!inside) continue;
+        m_stats.visible++;
+
+        // Выбираем самый грубый уровень, ошибка которого на экране не превышает порог
+        Vec3 viewCenter = matWorld.TransformPoint(Vec3(rec.center[0], rec.center[1], rec.center[2]));
+        float distance = std::max(Length(viewCenter) - rec.radius, 0.1f);
+        float pixelsPerUnit = pixelScale / distance;
+
+        int want = 0;
+        int coarsest = 0;
+        for (int lod = CLUSTER_MAX_LODS - 1; lod > 0; lod--) {
+            if (rec.lods[lod].offset == 0) continue;
+            if (coarsest == 0) coarsest = lod;
+            if (rec.lods[lod].error * pixelsPerUnit <= settings.errorPixels) {
+                want = lod;
+                break;
+            }
+        }
+
+        const Page* page = Touch(Key(c, want));
+        if (!page) {
+            // Пока нужный уровень не загружен, рисуем любой резидентный — сначала ближайший более грубый
+            int fallback = -1;
+            for (int lod = want + 1; lod < CLUSTER_MAX_LODS && !page; lod++)
+                if ((page = Touch(Key(c, lod)))) fallback = lod;
+            for (int lod = want - 1; lod >= 0 && !page; lod--)
+                if ((page = Touch(Key(c, lod)))) fallback = lod;
+
+            // Если у кластера нет ничего — сначала подтягиваем самый грубый уровень, он самый лёгкий
+            int request = (fallback < 0 && rec.lods[coarsest].offset != 0) ? coarsest : want;
+            if (m_failed.count(Key(c, request))) request = want;
+
+            // Испорченный уровень не ждём: иначе кадр никогда не станет окончательным
+            if (!m_failed.count(Key(c, request))) {
+                m_stats.missing++;
+                m_requests.push_back({Key(c, request), rec.radius * pixelsPerUnit});
+            }
+        }
+
+        if (page) {
+            m_drawList.push_back(page);
+            m_stats.drawn++;
+        }
+    }
+
+    // Подгружаем недостающее, начиная с крупных на экране кластеров. Загруженное появится со следующего кадра.
+    std::sort(m_requests.begin(), m_requests.end(), [](const Request& a, const Request& b) { return a.priority > b.priority; });
+    int budget = settings.maxLoadsPerFrame;
+    for (const Request& r : m_requests) {
+        if (budget-- <= 0) break;
+        // Испорченную страницу пропускаем, а без места дальше грузить бессмысленно
+        if (Load(r.key) == NoRoom) break;
+    }
+
+    m_stats.residentBytes = m_residentBytes;
+    m_stats.failed = (int)m_failed.size();
+    return m_drawList;
+}
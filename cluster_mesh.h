@@ -0,0 +1,122 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstddef>
+#include <cstdint>
+#include "math_3d.h"
+#include "mesh.h"
+#include "mapped_file.h"
+
+// Кластерный формат .cmsh для out-of-core рендеринга.
+// Меш режется на небольшие пространственно компактные кластеры (порядок Мортона по центрам граней),
+// для каждого кластера хранятся ограничивающая сфера и до CLUSTER_MAX_LODS уровней детализации.
+// Раскладка файла: заголовок, таблица кластеров, затем блоки данных (вершины + локальные индексы),
+// выровненные так, чтобы их можно было читать прямо из отображённого в память файла.
+const int CLUSTER_MAX_LODS = 4;
+
+struct ClusterFileHeader {
+    char magic[4];          // "CMSH"
+    uint32_t version;
+    uint32_t clusterCount;
+    uint32_t lodCount;
+    float boundsCenter[3];
+    float boundsRadius;
+};
+
+struct ClusterLodRecord {
+    uint64_t offset;        // Смещение блока данных от начала файла (0 — уровня нет)
+    uint32_t vertexCount;
+    uint32_t faceCount;
+    float error;            // Геометрическая ошибка уровня в единицах модели
+    uint32_t reserved;
+};
+
+struct ClusterRecord {
+    float center[3];
+    float radius;
+    ClusterLodRecord lods[CLUSTER_MAX_LODS];
+};
+
+namespace ClusterFile {
+    // Нарезает меш на кластеры и записывает .cmsh. Данные пишутся по одному кластеру,
+    // поэтому в памяти одновременно находится только исходный меш и один кластер.
+    bool Write(const Mesh& mesh, const std::string& filename, int facesPerCluster = 512);
+}
+
+// Потоковый рендеринг .cmsh: в памяти держатся только кластеры, прошедшие тест пирамиды видимости,
+// на нужном уровне детализации. Резидентные страницы живут в LRU-кэше с фиксированным бюджетом,
+// поэтому потребление памяти не зависит от размера набора данных.
+class ClusterStream {
+public:
+    struct Settings {
+        size_t budgetBytes = 64 * 1024 * 1024; // Бюджет резидентных страниц
+        int maxLoadsPerFrame = 16;             // Сколько страниц подгружать за кадр
+        float errorPixels = 1.0f;              // Допустимая ошибка LOD на экране в пикселях
+    };
+
+    struct Page {
+        AlignedVector<Vec3> vertices;
+        std::vector<Mesh::Face> faces;
+    };
+
+    struct Stats {
+        int clusters = 0;
+        int visible = 0;      // Прошли тест пирамиды видимости
+        int drawn = 0;        // Отрисованы (нужным или запасным уровнем)
+        int missing = 0;      // Нужный уровень ещё не загружен
+        int loaded = 0;       // Подгружено за кадр
+        int evicted = 0;      // Вытеснено за кадр
+        int failed = 0;       // Испорченные страницы: не загружаются и больше не запрашиваются
+        size_t residentBytes = 0;
+    };
+
+    Settings settings;
+
+    bool Open(const std::string& filename);
+    void Close();
+    bool IsOpen() const { return m_file.IsOpen(); }
+
+    // Отбирает видимые кластеры, подгружает недостающие страницы и возвращает список для отрисовки
+    const std::vector<const Page*>& Update(const Affine3x4& matWorld, const Mat4& matProj, int screenHeight);
+
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    struct Resident {
+        Page page;
+        size_t bytes = 0;
+        uint64_t lastUsedFrame = 0;
+        std::list<uint32_t>::iterator lruPos;
+    };
+
+    struct Request {
+        uint32_t key;
+        float priority; // Размер кластера на экране: крупные подгружаем первыми
+    };
+
+    MappedFile m_file;
+    ClusterFileHeader m_header{};
+    const ClusterRecord* m_clusters = nullptr;
+
+    std::unordered_map<uint32_t, Resident> m_resident;
+    std::list<uint32_t> m_lru; // Спереди — недавно использованные
+    size_t m_residentBytes = 0;
+    uint64_t m_frame = 0;
+
+    std::vector<const Page*> m_drawList;
+    std::vector<Request> m_requests;
+    std::unordered_set<uint32_t> m_failed; // Страницы, не прошедшие проверку при загрузке
+    Stats m_stats;
+
+    // Failed — страница испорчена (или одна больше бюджета), NoRoom — бюджет занят страницами текущего кадра
+    enum LoadResult { Loaded, NoRoom, Failed };
+
+    static uint32_t Key(uint32_t cluster, int lod) { return cluster * CLUSTER_MAX_LODS + (uint32_t)lod; }
+
+    const Page* Touch(uint32_t key);
+    LoadResult Load(uint32_t key);
+    bool MakeRoom(size_t bytes);
+};
@@ -0,0 +1,126 @@
+#include "cpu_features.h"
+#include <iostream>
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define ENGINE_HAS_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace {
+
+const char* LEVEL_NAMES[] = {"scalar", "sse2", "sse4.1", "avx2", "avx512"};
+
+#ifdef ENGINE_HAS_X86
+void Cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#ifdef _MSC_VER
+    int out[4];
+    __cpuidex(out, (int)leaf, (int)subleaf);
+    for (int i = 0; i < 4; i++) regs[i] = (unsigned)out[i];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Какие регистры ОС сохраняет при переключении потоков (XCR0)
+uint64_t ReadXcr0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+}
+#endif
+
+CpuFeatures::Level DetectLevel() {
+#ifdef ENGINE_HAS_X86
+    unsigned regs[4];
+    Cpuid(0, 0, regs);
+    unsigned maxLeaf = regs[0];
+
+    Cpuid(1, 0, regs);
+    bool sse2 = (regs[3] >> 26) & 1;
+    bool sse41 = (regs[2] >> 19) & 1;
+    bool osxsave = (regs[2] >> 27) & 1;
+    bool avx = (regs[2] >> 28) & 1;
+    if (!sse2) return CpuFeatures::Scalar;
+    if (!sse41) return CpuFeatures::SSE2;
+
+    // AVX годится, только если ОС сохраняет регистры YMM (биты 1-2), а AVX-512 — ещё и ZMM с масками (5-7)
+    uint64_t xcr0 = osxsave ? ReadXcr0() : 0;
+    bool ymm = (xcr0 & 0x6) == 0x6;
+    bool zmm = (xcr0 & 0xE6) == 0xE6;
+    if (!avx || !ymm || maxLeaf < 7) return CpuFeatures::SSE41;
+
+    Cpuid(7, 0, regs);
+    bool avx2 = (regs[1] >> 5) & 1;
+    bool avx512f = (regs[1] >> 16) & 1;
+    if (!avx2) return CpuFeatures::SSE41;
+    if (!avx512f || !zmm) return CpuFeatures::AVX2;
+    return CpuFeatures::AVX512;
+#else
+    return CpuFeatures::Scalar;
+#endif
+}
+
+CpuFeatures::Level InitialLevel() {
+    CpuFeatures::Level detected = CpuFeatures::Detected();
+    const char* value = std::getenv("ENGINE_CPU_LEVEL");
+    if (!value) return detected;
+
+    CpuFeatures::Level requested;
+    if (!CpuFeatures::Parse(value, requested)) {
+        std::cerr << "WARNING: Unknown ENGINE_CPU_LEVEL " << value << ", using " << CpuFeatures::Name(detected) << std::endl;
+        return detected;
+    }
+    if (requested > detected) {
+        std::cerr << "WARNING: ENGINE_CPU_LEVEL " << value << " is not supported here, using "
+                  << CpuFeatures::Name(detected) << std::endl;
+        return detected;
+    }
+    return requested;
+}
+
+std::atomic<int>& ActiveLevel() {
+    static std::atomic<int> level{(int)InitialLevel()};
+    return level;
+}
+
+} // namespace
+
+CpuFeatures::Level CpuFeatures::Detected() {
+    static const Level level = DetectLevel();
+    return level;
+}
+
+CpuFeatures::Level CpuFeatures::Active() {
+    return (Level)ActiveLevel().load(std::memory_order_relaxed);
+}
+
+bool CpuFeatures::Force(Level level) {
+    if (level > Detected()) return false;
+    ActiveLevel().store((int)level, std::memory_order_relaxed);
+    return true;
+}
+
+const char* CpuFeatures::Name(Level level) {
+    return LEVEL_NAMES[level];
+}
+
+bool CpuFeatures::Parse(const std::string& name, Level& level) {
+    for (int i = 0; i <= AVX512; i++) {
+        if (name == LEVEL_NAMES[i]) {
+            level = (Level)i;
+            return true;
+        }
+    }
+    return false;
+}
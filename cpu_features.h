@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+
+// Уровень SIMD, доступный процессору и ОС. Определяется через CPUID один раз при первом обращении;
+// от него зависит выбор вариантов горячих функций (simd_kernels.h).
+//
+// Уровень можно принудительно понизить для проверки: Force() или переменная окружения
+// ENGINE_CPU_LEVEL=scalar|sse2|sse4.1|avx2|avx512. Выше того, что умеет машина, поднять нельзя.
+namespace CpuFeatures {
+    enum Level { Scalar, SSE2, SSE41, AVX2, AVX512 };
+
+    // Что умеет машина
+    Level Detected();
+
+    // Выбранный уровень (по умолчанию Detected, с учётом ENGINE_CPU_LEVEL)
+    Level Active();
+
+    // false, если машина этот уровень не поддерживает. Вызывать до запуска рабочих потоков
+    bool Force(Level level);
+
+    const char* Name(Level level);
+    bool Parse(const std::string& name, Level& level);
+}
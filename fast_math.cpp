@@ -0,0 +1,70 @@
+#include "fast_math.h"
+#include "simd_kernels.h"
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+FastMath::Mode ReadModeEnv() {
+    const char* value = std::getenv("ENGINE_FAST_MATH");
+    return value && std::strcmp(value, "0") != 0 ? FastMath::Fast : FastMath::Exact;
+}
+
+std::atomic<int> g_mode{ReadModeEnv()};
+
+} // namespace
+
+void FastMath::SetMode(Mode mode) {
+    g_mode.store(mode, std::memory_order_relaxed);
+}
+
+FastMath::Mode FastMath::GetMode() {
+    return (Mode)g_mode.load(std::memory_order_relaxed);
+}
+
+void FastMath::SinCos(const float* angles, float* sines, float* cosines, size_t count) {
+    if (GetMode() == Fast) {
+        GetKernels().sinCos(angles, sines, cosines, count);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        float angle = angles[i];
+        sines[i] = sinf(angle);
+        cosines[i] = cosf(angle);
+    }
+}
+
+void FastMath::SinCos(float angle, float& sine, float& cosine) {
+    SinCos(&angle, &sine, &cosine, 1);
+}
+
+void FastMath::RSqrt(const float* values, float* out, size_t count) {
+    if (GetMode() == Fast) {
+        GetKernels().rsqrt(values, out, count);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) out[i] = 1.0f / std::sqrt(values[i]);
+}
+
+float FastMath::RSqrt(float value) {
+    float out;
+    RSqrt(&value, &out, 1);
+    return out;
+}
+
+void FastMath::Normalize(Vec3* vectors, size_t count) {
+    if (GetMode() == Exact) {
+        for (size_t i = 0; i < count; i++) vectors[i] = vectors[i].Normalize();
+        return;
+    }
+
+    GetKernels().normalize(vectors, count);
+}
+
+Vec3 FastMath::Normalize(const Vec3& v) {
+    Vec3 out = v;
+    Normalize(&out, 1);
+    return out;
+}
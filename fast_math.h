@@ -0,0 +1,33 @@
+#pragma once
+#include "math_3d.h"
+#include <cstddef>
+
+// Синусы, косинусы и обратный корень пачками по массивам — для генерации сеток, нормалей и освещения.
+// Два режима:
+//   Exact — sinf/cosf и деление на sqrtf; результат побитно тот же, что у Vec3::Normalize и libm.
+//   Fast  — приближения из SimdKernels (SIMD по уровню CpuFeatures), одинаковые на всех уровнях.
+// Режим задаётся SetMode или переменной окружения ENGINE_FAST_MATH=1; по умолчанию Exact.
+// Кэш фигур ShapesGenerator хранит сетки каждого режима отдельно.
+//
+// Погрешность Fast (проверено перебором против double):
+//   SinCos — абсолютная не больше 8e-8 при |x| <= 8192 и 1e-6 при |x| <= 1e5;
+//            дальше приведение аргумента теряет точность, при |x| >= 2^31 результат не определён.
+//   RSqrt  — относительная не больше 4.8e-6 для нормальных положительных чисел;
+//            для 0 — большое конечное число (нулевой вектор нормализуется в нулевой), для x < 0 — мусор.
+namespace FastMath {
+    enum Mode { Exact, Fast };
+
+    void SetMode(Mode mode);
+    Mode GetMode();
+
+    // Выход может совпадать со входом
+    void SinCos(const float* angles, float* sines, float* cosines, size_t count);
+    void SinCos(float angle, float& sine, float& cosine);
+
+    void RSqrt(const float* values, float* out, size_t count);
+    float RSqrt(float value);
+
+    // Нормализация на месте: в Exact — Vec3::Normalize, в Fast — умножение на RSqrt квадрата длины
+    void Normalize(Vec3* vectors, size_t count);
+    Vec3 Normalize(const Vec3& v);
+}
@@ -0,0 +1,67 @@
+#include "frame_arena.h"
+#include <algorithm>
+
+LinearArena::LinearArena(size_t blockSize) : m_blockSize(blockSize) {}
+
+void* LinearArena::Allocate(size_t size, size_t align) {
+    // Блоки используются по порядку: сначала уже выделенные, новый — только если не хватило
+    for (;;) {
+        if (m_block < m_blocks.size()) {
+            Block& block = m_blocks[m_block];
+            uintptr_t base = (uintptr_t)block.data.get();
+            size_t start = ((base + m_offset + align - 1) & ~(uintptr_t)(align - 1)) - base;
+            if (start + size <= block.size) {
+                m_used += start + size - m_offset;
+                m_offset = start + size;
+                return block.data.get() + start;
+            }
+            if (m_block + 1 < m_blocks.size() && m_blocks[m_block + 1].size >= size + align) {
+                m_block++;
+                m_offset = 0;
+                continue;
+            }
+        }
+
+        // Новый блок встаёт сразу за текущим; размер растёт, чтобы после прогрева кадр умещался в немного блоков
+        size_t lastSize = m_blocks.empty() ? 0 : m_blocks.back().size;
+        size_t blockSize = std::max({m_blockSize, size + align, lastSize * 2});
+        Block block{std::unique_ptr<uint8_t[]>(new uint8_t[blockSize]), blockSize};
+        size_t position = m_blocks.empty() ? 0 : m_block + 1;
+        m_blocks.insert(m_blocks.begin() + position, std::move(block));
+        m_block = position;
+        m_offset = 0;
+    }
+}
+
+void LinearArena::Rewind(const Marker& marker) {
+    m_block = marker.block;
+    m_offset = marker.offset;
+    m_used = marker.used;
+}
+
+void LinearArena::Reset() {
+    m_block = 0;
+    m_offset = 0;
+    m_used = 0;
+}
+
+size_t LinearArena::GetCapacity() const {
+    size_t capacity = 0;
+    for (const Block& block : m_blocks) capacity += block.size;
+    return capacity;
+}
+
+void FrameArena::SetWorkerCount(int count) {
+    while ((int)m_workers.size() < count) m_workers.push_back(std::make_unique<LinearArena>());
+}
+
+void FrameArena::Reset() {
+    m_main.Reset();
+    for (auto& worker : m_workers) worker->Reset();
+}
+
+size_t FrameArena::GetUsed() const {
+    size_t used = m_main.GetUsed();
+    for (const auto& worker : m_workers) used += worker->GetUsed();
+    return used;
+}
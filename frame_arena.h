@@ -0,0 +1,73 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+// Линейный распределитель: память выдаётся подряд из крупных блоков, освобождается только вся сразу.
+// Reset не возвращает блоки системе, а лишь переводит указатель в начало, поэтому стоит O(1),
+// а в установившемся режиме (каждый кадр примерно одно и то же) куча не трогается вовсе.
+// Деструкторы не вызываются: размещать можно только тривиально разрушаемые типы.
+class LinearArena {
+public:
+    explicit LinearArena(size_t blockSize = 1 << 20);
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    void* Allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    // Массив без инициализации
+    template <class T>
+    T* AllocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "LinearArena does not run destructors");
+        return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Откат к отметке освобождает всё, что выделено после неё (вложенные временные данные)
+    struct Marker {
+        size_t block;
+        size_t offset;
+        size_t used;
+    };
+    Marker GetMarker() const { return {m_block, m_offset, m_used}; }
+    void Rewind(const Marker& marker);
+
+    void Reset();
+
+    size_t GetUsed() const { return m_used; }
+    size_t GetCapacity() const;
+
+private:
+    struct Block {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> m_blocks;
+    size_t m_blockSize;
+    size_t m_block = 0;   // Текущий блок
+    size_t m_offset = 0;  // Занято в текущем блоке
+    size_t m_used = 0;    // Занято всего, с потерями на выравнивание
+};
+
+// Память одного кадра: основная арена и по арене на рабочий поток, чтобы параллельные стадии
+// не делили один указатель. Всё выделенное живёт до Reset (начало следующего кадра).
+class FrameArena {
+public:
+    LinearArena& Main() { return m_main; }
+
+    // Число рабочих арен задаётся до параллельной части; Worker(i) вызывает только i-й поток
+    void SetWorkerCount(int count);
+    int GetWorkerCount() const { return (int)m_workers.size(); }
+    LinearArena& Worker(int index) { return *m_workers[index]; }
+
+    void Reset();
+
+    size_t GetUsed() const;
+
+private:
+    LinearArena m_main;
+    std::vector<std::unique_ptr<LinearArena>> m_workers;
+};
@@ -0,0 +1,254 @@
+#include "gl_presenter.h"
+#include <cstring>
+
+// Константы и функция ARB_buffer_storage (в glad только GL 3.3)
+#define ENGINE_GL_MAP_PERSISTENT_BIT 0x0040
+#define ENGINE_GL_MAP_COHERENT_BIT 0x0080
+typedef void (APIENTRYP PFN_glBufferStorage)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+// Простейшие шейдеры. Вершинный просто передает координаты, 
+// Фрагментный берет цвет из нашей текстуры.
+const char* vertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aPos;
+    layout (location = 1) in vec2 aTexCoord;
+    out vec2 TexCoord;
+    void main() {
+        gl_Position = vec4(aPos, 0.0, 1.0);
+        TexCoord = aTexCoord;
+    }
+)";
+
+const char* fragmentShaderSource = R"(
+    #version 330 core
+    out vec4 FragColor;
+    in vec2 TexCoord;
+    uniform sampler2D screenTexture;
+    void main() {
+        FragColor = texture(screenTexture, TexCoord);
+    }
+)";
+
+GLPresenter::GLPresenter(int width, int height, ProcLoader loader)
+    : m_windowWidth(width), m_windowHeight(height), m_width(width), m_height(height) {
+    InitOpenGL();
+    InitPixelBuffers(loader);
+}
+
+GLPresenter::~GLPresenter() {
+    DestroyPixelBuffers();
+
+    glDeleteVertexArrays(1, &m_VAO);
+    glDeleteBuffers(1, &m_VBO);
+    glDeleteTextures(1, &m_textureID);
+    glDeleteProgram(m_shaderProgram);
+}
+
+void GLPresenter::InitPixelBuffers(ProcLoader loader) {
+    // Постоянное отображение: GL 4.4+ или расширение ARB_buffer_storage
+    PFN_glBufferStorage bufferStorage = nullptr;
+    if (loader) {
+        GLint major = 0, minor = 0, extensions = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        bool supported = major > 4 || (major == 4 && minor >= 4);
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+        for (GLint i = 0; i < extensions && !supported; i++) {
+            const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            supported = name && std::strcmp(name, "GL_ARB_buffer_storage") == 0;
+        }
+        if (supported) bufferStorage = reinterpret_cast<PFN_glBufferStorage>(loader("glBufferStorage"));
+    }
+    m_bufferStorage = reinterpret_cast<void*>(bufferStorage);
+    CreatePixelBuffers();
+}
+
+void GLPresenter::CreatePixelBuffers() {
+    const GLsizeiptr size = (GLsizeiptr)m_width * m_height * sizeof(uint32_t);
+    PFN_glBufferStorage bufferStorage = reinterpret_cast<PFN_glBufferStorage>(m_bufferStorage);
+
+    for (Slot& slot : m_slots) {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+        if (bufferStorage) {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | ENGINE_GL_MAP_PERSISTENT_BIT | ENGINE_GL_MAP_COHERENT_BIT;
+            bufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+            slot.mapped = static_cast<uint32_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+        } else {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    m_persistent = bufferStorage != nullptr;
+    for (const Slot& slot : m_slots) m_persistent = m_persistent && slot.mapped;
+}
+
+void GLPresenter::DestroyPixelBuffers() {
+    for (Slot& slot : m_slots) {
+        // Буфер нельзя удалять, пока из него копирует GPU
+        WaitForSlot(slot);
+        if (slot.mapped) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            slot.mapped = nullptr;
+        }
+        glDeleteBuffers(1, &slot.pbo);
+        slot.pbo = 0;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    m_slot = -1;
+}
+
+void GLPresenter::Resize(int width, int height) {
+    DestroyPixelBuffers();
+    m_width = width;
+    m_height = height;
+
+    glBindTexture(GL_TEXTURE_2D, m_textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL);
+    // Кадр в размер окна показываем пиксель в пиксель, уменьшенный — растягиваем с фильтрацией
+    bool native = m_width == m_windowWidth && m_height == m_windowHeight;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, native ? GL_NEAREST : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, native ? GL_NEAREST : GL_LINEAR);
+
+    CreatePixelBuffers();
+}
+
+void GLPresenter::WaitForSlot(Slot& slot) {
+    if (!slot.fence) return;
+    // Обычно копирование давно закончилось: буфер освобождается через PBO_COUNT - 1 кадров
+    while (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+}
+
+uint32_t* GLPresenter::AcquireTarget(int width, int height, int& stride, int& index) {
+    // Буферы рассчитаны на размер текстуры
+    if (width != m_width || height != m_height) Resize(width, height);
+
+    m_slot = (m_slot + 1) % PBO_COUNT;
+    Slot& slot = m_slots[m_slot];
+    WaitForSlot(slot);
+
+    if (!m_persistent) {
+        // Без INVALIDATE: содержимое буфера с прошлого раза сохраняется.
+        // UNSYNCHRONIZED — синхронизацию мы уже сделали забором
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+        slot.mapped = static_cast<uint32_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+            (GLsizeiptr)m_width * m_height * sizeof(uint32_t), GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    stride = m_width;
+    index = m_slot;
+    return slot.mapped;
+}
+
+void GLPresenter::Present(const uint32_t* pixels, int width, int height, int stride,
+                          const PresentRect* rects, int rectCount) {
+    if (width != m_width || height != m_height) Resize(width, height);
+    glBindTexture(GL_TEXTURE_2D, m_textureID);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
+
+    Slot* slot = m_slot >= 0 ? &m_slots[m_slot] : nullptr;
+    bool fromPbo = slot && slot->mapped && pixels == slot->mapped;
+    if (fromPbo) {
+        // Кадр уже лежит в PBO: копирование в текстуру идёт на стороне GPU, без ожидания
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->pbo);
+        if (!m_persistent) {
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            slot->mapped = nullptr;
+        }
+    }
+
+    PresentRect full = {0, 0, width, height};
+    if (!rects) {
+        rects = &full;
+        rectCount = 1;
+    }
+    for (int r = 0; r < rectCount; r++) {
+        const PresentRect& rect = rects[r];
+        size_t offset = (size_t)rect.y * stride + rect.x;
+        // Для PBO «указатель» — смещение в байтах от начала буфера
+        const void* data = fromPbo ? reinterpret_cast<const void*>(offset * sizeof(uint32_t)) : pixels + offset;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, data);
+    }
+
+    if (fromPbo) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    Redraw();
+}
+
+void GLPresenter::Redraw() {
+    glBindTexture(GL_TEXTURE_2D, m_textureID);
+    glUseProgram(m_shaderProgram);
+    glBindVertexArray(m_VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+}
+
+void GLPresenter::InitOpenGL() {
+    // Создаем шейдерную программу
+    m_shaderProgram = CreateShader(vertexShaderSource, fragmentShaderSource);
+
+    // Координаты квадрата на весь экран (2 треугольника)
+    // Format: X, Y, U, V
+    float vertices[] = {
+        // Первый треугольник
+        -1.0f,  1.0f,  0.0f, 0.0f, // Top-left
+        -1.0f, -1.0f,  0.0f, 1.0f, // Bottom-left
+         1.0f, -1.0f,  1.0f, 1.0f, // Bottom-right
+        // Второй треугольник
+        -1.0f,  1.0f,  0.0f, 0.0f, // Top-left
+         1.0f, -1.0f,  1.0f, 1.0f, // Bottom-right
+         1.0f,  1.0f,  1.0f, 0.0f  // Top-right
+    };
+
+    glGenVertexArrays(1, &m_VAO);
+    glGenBuffers(1, &m_VBO);
+
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    // Атрибут координат (X, Y)
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    // Атрибут текстурных координат (U, V)
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    // Создаем текстуру
+    glGenTextures(1, &m_textureID);
+    glBindTexture(GL_TEXTURE_2D, m_textureID);
+    // Параметры: не размывать пиксели (GL_NEAREST), чтобы видеть каждый пиксель четко
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    
+    // Выделяем память на GPU под текстуру (пока пустую)
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL);
+}
+
+GLuint GLPresenter::CreateShader(const char* vertexSrc, const char* fragmentSrc) {
+    // Стандартная компиляция шейдеров (сокращенно для экономии места)
+    GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertex, 1, &vertexSrc, NULL);
+    glCompileShader(vertex);
+    
+    GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragment, 1, &fragmentSrc, NULL);
+    glCompileShader(fragment);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+    
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    return program;
+}
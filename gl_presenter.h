@@ -0,0 +1,67 @@
+#pragma once
+#include <glad/glad.h>
+#include "present_backend.h"
+
+// Вывод кадра в окно: буфер загружается в текстуру OpenGL
+// и рисуется двумя треугольниками на весь экран.
+//
+// Загрузка асинхронная: кольцо из PBO_COUNT буферов распаковки (GL_PIXEL_UNPACK_BUFFER).
+// Renderer рисует кадр N прямо в отображённую память одного буфера, пока кадр N-1 копируется
+// видеокартой из другого; забор (fence) не даёт писать в буфер, который ещё читает GPU.
+// Если контекст поддерживает ARB_buffer_storage (GL 4.4), буферы отображаются один раз
+// навсегда (persistent mapping), иначе отображаются заново на каждый кадр.
+// В текстуру копируются только изменившиеся прямоугольники кадра.
+//
+// Кадр может быть меньше окна (динамическое разрешение): тогда текстура и буферы пересоздаются
+// под новый размер, а квадрат на весь экран растягивает её с билинейной фильтрацией.
+class GLPresenter : public PresentBackend {
+public:
+    // Функция получения адресов GL-функций (например, glfwGetProcAddress): нужна для
+    // glBufferStorage, которой нет в загрузчике GL 3.3. nullptr — без постоянного отображения
+    typedef void* (*ProcLoader)(const char* name);
+
+    static const int PBO_COUNT = 3;
+
+    // width, height — размер окна и начальный размер кадра
+    GLPresenter(int width, int height, ProcLoader loader = nullptr);
+    ~GLPresenter() override;
+
+    uint32_t* AcquireTarget(int width, int height, int& stride, int& index) override;
+    void Present(const uint32_t* pixels, int width, int height, int stride,
+                 const PresentRect* rects, int rectCount) override;
+
+    // Повторный вывод последнего кадра без загрузки (сцена не менялась)
+    void Redraw();
+
+    bool IsPersistent() const { return m_persistent; }
+
+private:
+    struct Slot {
+        GLuint pbo = 0;
+        uint32_t* mapped = nullptr;
+        GLsync fence = nullptr;
+    };
+
+    int m_windowWidth;
+    int m_windowHeight;
+    int m_width;            // Размер текстуры и буферов
+    int m_height;
+
+    // OpenGL идентификаторы
+    GLuint m_textureID;
+    GLuint m_shaderProgram;
+    GLuint m_VAO, m_VBO;
+
+    Slot m_slots[PBO_COUNT];
+    int m_slot = -1;        // Буфер, отданный Renderer под текущий кадр
+    bool m_persistent = false;
+    void* m_bufferStorage = nullptr; // glBufferStorage, если доступна
+
+    void InitOpenGL();
+    void InitPixelBuffers(ProcLoader loader);
+    void CreatePixelBuffers();
+    void DestroyPixelBuffers();
+    void Resize(int width, int height);
+    void WaitForSlot(Slot& slot);
+    GLuint CreateShader(const char* vertexSrc, const char* fragmentSrc);
+};
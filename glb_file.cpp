@@ -0,0 +1,353 @@
+#include "glb_file.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <utility>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+// Магические числа формата GLB
+static const uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+static const uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+static const uint32_t GLB_CHUNK_BIN = 0x004E4942;  // "BIN\0"
+
+static uint32_t ReadU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static size_t ComponentSize(int componentType) {
+    switch (componentType) {
+        case GlbFile::Byte:
+        case GlbFile::UnsignedByte: return 1;
+        case GlbFile::Short:
+        case GlbFile::UnsignedShort: return 2;
+        case GlbFile::UnsignedInt:
+        case GlbFile::Float: return 4;
+        default: return 0;
+    }
+}
+
+static int ComponentCount(const std::string& type) {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    if (type == "MAT2") return 4;
+    if (type == "MAT3") return 9;
+    if (type == "MAT4") return 16;
+    return 0;
+}
+
+// --- Минимальный JSON-парсер ---
+// Нам нужны только bufferViews, accessors и meshes, поэтому хватает простого DOM без изысков.
+
+struct JsonValue {
+    enum Type { Null, Bool, Number, String, Array, Object } type = Null;
+    double number = 0.0;
+    bool boolean = false;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    const JsonValue* Find(const char* key) const {
+        if (type != Object) return nullptr;
+        for (const auto& kv : object)
+            if (kv.first == key) return &kv.second;
+        return nullptr;
+    }
+
+    // Целые поля glTF: число должно быть конечным, целым и в пределах [0, max], иначе false —
+    // приводить к int или size_t NaN, 1e30 или -1 нельзя. Нет ключа — fallback
+    bool GetInteger(const char* key, double fallback, double max, double& out) const {
+        const JsonValue* v = Find(key);
+        if (!v || v->type != Number) {
+            out = fallback;
+            return true;
+        }
+        out = v->number;
+        return std::isfinite(out) && out >= 0.0 && out <= max && std::floor(out) == out;
+    }
+
+    bool GetInt(const char* key, int fallback, int& out) const {
+        double value;
+        bool ok = GetInteger(key, fallback, INT_MAX, value);
+        out = ok ? (int)value : fallback;
+        return ok;
+    }
+
+    bool GetSize(const char* key, size_t fallback, size_t max, size_t& out) const {
+        double value;
+        bool ok = GetInteger(key, (double)fallback, (double)max, value);
+        out = ok ? (size_t)value : fallback;
+        return ok;
+    }
+};
+
+struct JsonParser {
+    const char* p;
+    const char* end;
+
+    void SkipSpaces() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+    }
+
+    bool Match(char c) {
+        SkipSpaces();
+        if (p < end && *p == c) { p++; return true; }
+        return false;
+    }
+
+    bool ParseString(std::string& out) {
+        if (!Match('"')) return false;
+        while (p < end && *p != '"') {
+            if (*p == '\\') {
+                if (++p >= end) return false;
+                switch (*p) {
+                    case 'n': out += '\n'; break;
+                    case 't': out += '\t'; break;
+                    case 'r': out += '\r'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'u':
+                        // Юникодные escape-последовательности в ключах glTF не встречаются, пропускаем
+                        if (end - p < 5) return false;
+                        p += 4;
+                        out += '?';
+                        break;
+                    default: out += *p; break;
+                }
+                p++;
+            } else {
+                out += *p++;
+            }
+        }
+        if (p >= end) return false;
+        p++; // Закрывающая кавычка
+        return true;
+    }
+
+    bool ParseValue(JsonValue& v, int depth) {
+        if (depth > 64) return false;
+        SkipSpaces();
+        if (p >= end) return false;
+
+        if (*p == '{') {
+            p++;
+            v.type = JsonValue::Object;
+            if (Match('}')) return true;
+            do {
+                std::pair<std::string, JsonValue> kv;
+                if (!ParseString(kv.first) || !Match(':') || !ParseValue(kv.second, depth + 1)) return false;
+                v.object.push_back(std::move(kv));
+            } while (Match(','));
+            return Match('}');
+        }
+        if (*p == '[') {
+            p++;
+            v.type = JsonValue::Array;
+            if (Match(']')) return true;
+            do {
+                v.array.emplace_back();
+                if (!ParseValue(v.array.back(), depth + 1)) return false;
+            } while (Match(','));
+            return Match(']');
+        }
+        if (*p == '"') {
+            v.type = JsonValue::String;
+            return ParseString(v.string);
+        }
+        if (end - p >= 4 && std::strncmp(p, "true", 4) == 0) { v.type = JsonValue::Bool; v.boolean = true; p += 4; return true; }
+        if (end - p >= 5 && std::strncmp(p, "false", 5) == 0) { v.type = JsonValue::Bool; p += 5; return true; }
+        if (end - p >= 4 && std::strncmp(p, "null", 4) == 0) { p += 4; return true; }
+
+        // Число: копируем во временную строку, т.к. JSON-чанк не обязан заканчиваться нулём
+        const char* start = p;
+        while (p < end && (std::strchr("+-0123456789.eE", *p) != nullptr)) p++;
+        if (p == start) return false;
+        std::string num(start, p);
+        v.type = JsonValue::Number;
+        v.number = std::strtod(num.c_str(), nullptr);
+        return true;
+    }
+};
+
+// --- GlbFile ---
+
+bool GlbFile::Open(const std::string& filename) {
+    m_bin = nullptr;
+    m_binSize = 0;
+    m_bufferViews.clear();
+    m_accessors.clear();
+    m_primitives.clear();
+
+    if (!m_file.Open(filename)) return false;
+
+    const uint8_t* data = m_file.Data();
+    size_t size = m_file.Size();
+
+    // Заголовок: magic, version, length
+    if (size < 20 || ReadU32(data) != GLB_MAGIC || ReadU32(data + 4) != 2) {
+        std::cerr << "ERROR: " << filename << " is not a glTF 2.0 binary file" << std::endl;
+        return false;
+    }
+    size_t totalLength = std::min((size_t)ReadU32(data + 8), size);
+
+    const char* json = nullptr;
+    size_t jsonSize = 0;
+
+    // Чанки: length, type, данные (выровнены по 4 байта)
+    size_t offset = 12;
+    while (offset + 8 <= totalLength) {
+        size_t chunkLength = ReadU32(data + offset);
+        uint32_t chunkType = ReadU32(data + offset + 4);
+        offset += 8;
+        if (chunkLength > totalLength - offset) {
+            std::cerr << "ERROR: Truncated chunk in " << filename << std::endl;
+            return false;
+        }
+
+        if (chunkType == GLB_CHUNK_JSON && !json) {
+            json = reinterpret_cast<const char*>(data + offset);
+            jsonSize = chunkLength;
+        } else if (chunkType == GLB_CHUNK_BIN && !m_bin) {
+            m_bin = data + offset;
+            m_binSize = chunkLength;
+        }
+        offset += (chunkLength + 3) & ~(size_t)3;
+    }
+
+    if (!json) {
+        std::cerr << "ERROR: No JSON chunk in " << filename << std::endl;
+        return false;
+    }
+
+    JsonValue root;
+    JsonParser parser{json, json + jsonSize};
+    if (!parser.ParseValue(root, 0) || root.type != JsonValue::Object) {
+        std::cerr << "ERROR: Malformed JSON chunk in " << filename << std::endl;
+        return false;
+    }
+
+    // Смещения, длины и число элементов не могут превышать BIN-чанк, шаг — 252 байта (спецификация).
+    // Число вне пределов — испорченный или враждебный файл, его не открываем
+    bool numbersOk = true;
+    if (const JsonValue* views = root.Find("bufferViews")) {
+        for (const auto& v : views->array) {
+            int buffer;
+            BufferView bv;
+            numbersOk &= v.GetInt("buffer", 0, buffer);
+            numbersOk &= v.GetSize("byteOffset", 0, m_binSize, bv.offset);
+            numbersOk &= v.GetSize("byteLength", 0, m_binSize, bv.length);
+            numbersOk &= v.GetSize("byteStride", 0, 252, bv.stride);
+            if (buffer != 0) {
+                // Внешние буферы (uri) не поддерживаем: всё должно лежать в BIN-чанке
+                std::cerr << "WARNING: External buffers are not supported in " << filename << std::endl;
+            }
+            if (buffer != 0 || bv.length > m_binSize - bv.offset) {
+                bv.length = 0; // Помечаем как недоступный
+            }
+            m_bufferViews.push_back(bv);
+        }
+    }
+
+    if (const JsonValue* accessors = root.Find("accessors")) {
+        for (const auto& a : accessors->array) {
+            Accessor acc;
+            numbersOk &= a.GetInt("bufferView", -1, acc.bufferView);
+            numbersOk &= a.GetSize("byteOffset", 0, m_binSize, acc.offset);
+            numbersOk &= a.GetSize("count", 0, m_binSize, acc.count);
+            numbersOk &= a.GetInt("componentType", 0, acc.componentType);
+            const JsonValue* type = a.Find("type");
+            acc.components = type ? ComponentCount(type->string) : 0;
+            const JsonValue* norm = a.Find("normalized");
+            acc.normalized = norm && norm->boolean;
+            m_accessors.push_back(acc);
+        }
+    }
+
+    // Узлы и их трансформации не учитываются: все примитивы всех мешей сливаются в одну модель
+    if (const JsonValue* meshes = root.Find("meshes")) {
+        for (const auto& m : meshes->array) {
+            const JsonValue* prims = m.Find("primitives");
+            if (!prims) continue;
+            for (const auto& pr : prims->array) {
+                Primitive prim;
+                if (const JsonValue* attrs = pr.Find("attributes")) numbersOk &= attrs->GetInt("POSITION", -1, prim.position);
+                numbersOk &= pr.GetInt("indices", -1, prim.indices);
+                numbersOk &= pr.GetInt("mode", 4, prim.mode);
+                m_primitives.push_back(prim);
+            }
+        }
+    }
+
+    if (!numbersOk) {
+        std::cerr << "ERROR: Invalid index, offset or count in JSON chunk of " << filename << std::endl;
+        m_bufferViews.clear();
+        m_accessors.clear();
+        m_primitives.clear();
+        return false;
+    }
+    return true;
+}
+
+GlbFile::AccessorView GlbFile::GetAccessor(int index) const {
+    AccessorView view;
+    if (index < 0 || index >= (int)m_accessors.size()) return view;
+
+    const Accessor& acc = m_accessors[index];
+    if (acc.bufferView < 0 || acc.bufferView >= (int)m_bufferViews.size()) return view;
+    const BufferView& bv = m_bufferViews[acc.bufferView];
+
+    size_t elementSize = ComponentSize(acc.componentType) * acc.components;
+    if (elementSize == 0 || acc.count == 0) return view;
+    size_t stride = bv.stride ? bv.stride : elementSize;
+
+    // Последний элемент должен целиком помещаться в bufferView (проверка без переполнения)
+    if (stride < elementSize || acc.offset > bv.length || bv.length - acc.offset < elementSize) return view;
+    if (acc.count - 1 > (bv.length - acc.offset - elementSize) / stride) return view;
+
+    view.data = m_bin + bv.offset + acc.offset;
+    view.count = acc.count;
+    view.stride = stride;
+    view.componentType = acc.componentType;
+    view.components = acc.components;
+    view.normalized = acc.normalized;
+    return view;
+}
+
+const Vec3* GlbFile::AccessorView::AsVec3() const {
+    static_assert(sizeof(Vec3) == 3 * sizeof(float), "Vec3 must be tightly packed");
+    if (componentType != Float || components != 3 || stride != sizeof(Vec3)) return nullptr;
+    if (reinterpret_cast<uintptr_t>(data) % alignof(Vec3) != 0) return nullptr;
+    return reinterpret_cast<const Vec3*>(data);
+}
+
+const uint32_t* GlbFile::AccessorView::AsUint32() const {
+    if (componentType != UnsignedInt || components != 1 || stride != sizeof(uint32_t)) return nullptr;
+    if (reinterpret_cast<uintptr_t>(data) % alignof(uint32_t) != 0) return nullptr;
+    return reinterpret_cast<const uint32_t*>(data);
+}
+
+float GlbFile::AccessorView::ReadFloat(size_t element, int component) const {
+    const uint8_t* p = data + element * stride + component * ComponentSize(componentType);
+    switch (componentType) {
+        case Float: { float f; std::memcpy(&f, p, 4); return f; }
+        case Byte: { float f = (float)(int8_t)p[0]; return normalized ? std::max(f / 127.0f, -1.0f) : f; }
+        case UnsignedByte: { float f = (float)p[0]; return normalized ? f / 255.0f : f; }
+        case Short: { int16_t s; std::memcpy(&s, p, 2); float f = (float)s; return normalized ? std::max(f / 32767.0f, -1.0f) : f; }
+        case UnsignedShort: { uint16_t s; std::memcpy(&s, p, 2); float f = (float)s; return normalized ? f / 65535.0f : f; }
+        case UnsignedInt: { uint32_t u; std::memcpy(&u, p, 4); return (float)u; }
+        default: return 0.0f;
+    }
+}
+
+uint32_t GlbFile::AccessorView::ReadIndex(size_t element) const {
+    const uint8_t* p = data + element * stride;
+    switch (componentType) {
+        case UnsignedByte: return p[0];
+        case UnsignedShort: { uint16_t s; std::memcpy(&s, p, 2); return s; }
+        case UnsignedInt: { uint32_t u; std::memcpy(&u, p, 4); return u; }
+        default: return 0;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "mapped_file.h"
+#include "math_3d.h"
+
+// Контейнер glTF 2.0 в бинарном виде (.glb): JSON-чанк с описанием сцены и BIN-чанк с данными.
+// Файл отображается в память, а аксессоры отдаются как представления прямо поверх BIN-чанка —
+// если формат компонентов совпадает с нашим, данные можно использовать на месте, без конвертации.
+class GlbFile {
+public:
+    // Типы компонентов из спецификации glTF
+    enum ComponentType {
+        Byte = 5120,
+        UnsignedByte = 5121,
+        Short = 5122,
+        UnsignedShort = 5123,
+        UnsignedInt = 5125,
+        Float = 5126
+    };
+
+    struct AccessorView {
+        const uint8_t* data = nullptr; // Первый элемент внутри BIN-чанка
+        size_t count = 0;
+        size_t stride = 0;             // Расстояние между элементами в байтах
+        int componentType = 0;
+        int components = 0;            // 1 для SCALAR, 3 для VEC3 и т.д.
+        bool normalized = false;
+
+        bool Valid() const { return data != nullptr; }
+
+        // Указатель на данные "как есть", если они плотно упакованы в нужном формате, иначе nullptr
+        const Vec3* AsVec3() const;
+        const uint32_t* AsUint32() const;
+
+        // Медленный путь: чтение одного компонента с конвертацией во float / индекс
+        float ReadFloat(size_t element, int component) const;
+        uint32_t ReadIndex(size_t element) const;
+    };
+
+    struct Primitive {
+        int position = -1; // Индекс аксессора POSITION
+        int indices = -1;  // Индекс аксессора индексов (-1 — неиндексированная геометрия)
+        int mode = 4;      // 4 = TRIANGLES
+    };
+
+    bool Open(const std::string& filename);
+
+    AccessorView GetAccessor(int index) const;
+    const std::vector<Primitive>& GetPrimitives() const { return m_primitives; }
+
+private:
+    struct BufferView {
+        size_t offset = 0;
+        size_t length = 0;
+        size_t stride = 0;
+    };
+
+    struct Accessor {
+        int bufferView = -1;
+        size_t offset = 0;
+        size_t count = 0;
+        int componentType = 0;
+        int components = 0;
+        bool normalized = false;
+    };
+
+    MappedFile m_file;
+    const uint8_t* m_bin = nullptr;
+    size_t m_binSize = 0;
+
+    std::vector<BufferView> m_bufferViews;
+    std::vector<Accessor> m_accessors;
+    std::vector<Primitive> m_primitives;
+};
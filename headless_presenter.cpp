@@ -0,0 +1,38 @@
+#include "headless_presenter.h"
+#include "image_io.h"
+#include <cstring>
+#include <iostream>
+
+HeadlessPresenter::HeadlessPresenter(const std::string& pathPattern) : m_pathPattern(pathPattern) {
+    if (!m_pathPattern.empty() && !IsFramePathPattern(m_pathPattern)) {
+        std::cerr << "ERROR: Bad frame path pattern " << m_pathPattern << ", expected one %d for the frame index"
+                  << std::endl;
+        m_pathPattern.clear();
+    }
+}
+
+void HeadlessPresenter::Present(const uint32_t* pixels, int width, int height, int stride,
+                                const PresentRect* rects, int rectCount) {
+    // Копия кадра обновляется только в изменившихся областях
+    PresentRect full = {0, 0, width, height};
+    if (!rects || width != m_width || height != m_height) {
+        rects = &full;
+        rectCount = 1;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_frame.resize((size_t)width * height);
+    for (int r = 0; r < rectCount; r++) {
+        const PresentRect& rect = rects[r];
+        for (int y = rect.y; y < rect.y + rect.height; y++) {
+            std::memcpy(&m_frame[(size_t)y * width + rect.x], pixels + (size_t)y * stride + rect.x,
+                        (size_t)rect.width * sizeof(uint32_t));
+        }
+    }
+
+    if (!m_pathPattern.empty()) {
+        WriteImage(FormatFramePath(m_pathPattern, m_frameCount), m_frame.data(), width, height, width);
+    }
+    m_frameCount++;
+}
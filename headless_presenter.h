@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "present_backend.h"
+
+// Бэкенд без окна и видеокарты: кадр копируется в память и, если задан шаблон пути,
+// записывается в файл. Шаблон — путь с номером кадра, например "out/frame_%04d.png" (см. IsFramePathPattern);
+// формат выбирается по расширению (.png или .ppm). Неверный шаблон отклоняется, файлы тогда не пишутся.
+class HeadlessPresenter : public PresentBackend {
+public:
+    explicit HeadlessPresenter(const std::string& pathPattern = "");
+
+    void Present(const uint32_t* pixels, int width, int height, int stride,
+                 const PresentRect* rects, int rectCount) override;
+
+    // Последний показанный кадр (плотно упакованный, stride == width)
+    const std::vector<uint32_t>& GetFrame() const { return m_frame; }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    int GetFrameCount() const { return m_frameCount; }
+
+private:
+    std::string m_pathPattern;
+    std::vector<uint32_t> m_frame;
+    int m_width = 0;
+    int m_height = 0;
+    int m_frameCount = 0;
+};
@@ -0,0 +1,149 @@
+#include "image_io.h"
+#include "renderer.h"
+#include "png_writer.h"
+#include "png_reader.h"
+#include <sstream>
+#include <iterator>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+
+// --- PPM ---
+
+std::vector<uint8_t> EncodePPM(const uint32_t* pixels, int width, int height, int stride) {
+    std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    std::vector<uint8_t> out(header.begin(), header.end());
+    out.reserve(header.size() + (size_t)width * height * 3);
+
+    for (int y = 0; y < height; y++) {
+        const uint32_t* row = pixels + (size_t)y * stride;
+        for (int x = 0; x < width; x++) {
+            out.push_back(ColorR(row[x]));
+            out.push_back(ColorG(row[x]));
+            out.push_back(ColorB(row[x]));
+        }
+    }
+    return out;
+}
+
+static bool DecodePPM(const std::vector<uint8_t>& data, std::vector<uint32_t>& pixels, int& width, int& height) {
+    std::string text(data.begin(), data.begin() + std::min(data.size(), (size_t)64));
+    std::istringstream header(text);
+    std::string magic;
+    int maxValue = 0;
+    header >> magic >> width >> height >> maxValue;
+    if (!header || magic != "P6" || maxValue != 255 || width <= 0 || height <= 0) return false;
+
+    // После максимального значения — ровно один пробельный символ, дальше пиксели
+    std::streamoff end = header.tellg();
+    if (end < 0) return false;
+    size_t offset = (size_t)end + 1;
+    if (data.size() < offset + (size_t)width * height * 3) return false;
+
+    pixels.resize((size_t)width * height);
+    const uint8_t* p = data.data() + offset;
+    for (size_t i = 0; i < pixels.size(); i++, p += 3) pixels[i] = MakeColor(p[0], p[1], p[2]);
+    return true;
+}
+
+// --- Запись на диск ---
+
+std::vector<uint8_t> EncodeImage(const std::string& filename, const uint32_t* pixels, int width, int height, int stride,
+                                 const PngSettings& png) {
+    bool isPng = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".png") == 0;
+    return isPng ? EncodePNG(pixels, width, height, stride, png) : EncodePPM(pixels, width, height, stride);
+}
+
+bool WriteImage(const std::string& filename, const uint32_t* pixels, int width, int height, int stride) {
+    std::vector<uint8_t> data = EncodeImage(filename, pixels, width, height, stride);
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Failed to create " << filename << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return (bool)out;
+}
+
+bool ReadImage(const std::string& filename, std::vector<uint32_t>& pixels, int& width, int& height) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "ERROR: Could not open " << filename << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    bool isPng = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".png") == 0;
+    if (isPng) return DecodePNG(data.data(), data.size(), pixels, width, height);
+    if (!DecodePPM(data, pixels, width, height)) {
+        std::cerr << "ERROR: Unsupported or broken PPM file " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Разбор шаблона: позиция и длина единственного преобразования, ширина поля и заполнение нулями
+struct FrameConversion {
+    size_t start = 0;
+    size_t length = 0;
+    int width = 0;
+    bool zeroPad = false;
+};
+
+static bool ParseFramePattern(const std::string& pattern, FrameConversion& conversion) {
+    int conversions = 0;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        if (pattern[i] != '%') continue;
+        if (i + 1 < pattern.size() && pattern[i + 1] == '%') {
+            i++;
+            continue;
+        }
+
+        size_t j = i + 1;
+        bool zeroPad = j < pattern.size() && pattern[j] == '0';
+        if (zeroPad) j++;
+        int width = 0;
+        for (int digits = 0; j < pattern.size() && pattern[j] >= '0' && pattern[j] <= '9'; j++, digits++) {
+            if (digits == 2) return false;
+            width = width * 10 + (pattern[j] - '0');
+        }
+        if (j >= pattern.size() || (pattern[j] != 'd' && pattern[j] != 'i')) return false;
+
+        conversion = {i, j + 1 - i, width, zeroPad};
+        conversions++;
+        i = j;
+    }
+    return conversions == 1;
+}
+
+bool IsFramePathPattern(const std::string& pattern) {
+    FrameConversion conversion;
+    return ParseFramePattern(pattern, conversion);
+}
+
+static void AppendLiteral(std::string& out, const std::string& pattern, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        out += pattern[i];
+        if (pattern[i] == '%') i++; // «%%»
+    }
+}
+
+std::string FormatFramePath(const std::string& pattern, int frame) {
+    FrameConversion conversion;
+    if (!ParseFramePattern(pattern, conversion)) return pattern;
+
+    std::string number = std::to_string(frame < 0 ? -(long long)frame : (long long)frame);
+    int padding = conversion.width - (int)number.size() - (frame < 0 ? 1 : 0);
+    std::string field;
+    if (!conversion.zeroPad && padding > 0) field.append(padding, ' ');
+    if (frame < 0) field += '-';
+    if (conversion.zeroPad && padding > 0) field.append(padding, '0');
+    field += number;
+
+    std::string out;
+    AppendLiteral(out, pattern, 0, conversion.start);
+    out += field;
+    AppendLiteral(out, pattern, conversion.start + conversion.length, pattern.size());
+    return out;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "png_writer.h"
+#include "png_reader.h"
+
+// Запись кадров в файлы. pixels — буфер Renderer (формат MakeColor), stride — пикселей между строками.
+// Изображения сохраняются как RGB: альфа-канал буфера смысловой нагрузки не несёт.
+
+// Кодирование в память (удобно, когда запись на диск идёт отдельно). PNG — см. png_writer.h
+std::vector<uint8_t> EncodePPM(const uint32_t* pixels, int width, int height, int stride);
+
+// Формат выбирается по расширению имени файла: .png или .ppm
+std::vector<uint8_t> EncodeImage(const std::string& filename, const uint32_t* pixels, int width, int height, int stride,
+                                 const PngSettings& png = PngSettings());
+bool WriteImage(const std::string& filename, const uint32_t* pixels, int width, int height, int stride);
+
+// Чтение изображения (.png — см. png_reader.h, .ppm — двоичный P6) в формат буфера Renderer
+bool ReadImage(const std::string& filename, std::vector<uint32_t>& pixels, int& width, int& height);
+
+// Шаблон пути кадра: ровно одно целое преобразование в духе printf (%d, %4d, %04d) под номер кадра,
+// «%%» — знак процента, других «%» нет. Номер подставляется без printf, поэтому шаблон из
+// командной строки безопасен. FormatFramePath ждёт шаблон, прошедший IsFramePathPattern
+bool IsFramePathPattern(const std::string& pattern);
+std::string FormatFramePath(const std::string& pattern, int frame);
@@ -5,15 +5,24 @@
 #include <cmath>
 #include <algorithm>
 #include <filesystem>
+#include <chrono>
 
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
 #include "renderer.h"
+#include "gl_presenter.h"
 #include "mesh.h"
 #include "math_3d.h"
 #include "shapes_generator.h"
+#include "pipeline.h"
+#include "cluster_mesh.h"
+#include "parametric_surface.h"
+#include "resolution_controller.h"
+#include "profiler.h"
+#include "alloc_tracker.h"
+#include "fast_math.h"
 
 namespace fs = std::filesystem;
 
@@ -28,16 +37,85 @@ float rotY = 0.0f;
 bool autoRotate = true;
 char importPathBuffer[512] = "";
 
-uint32_t MakeColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
-    return (a << 24) | (b << 16) | (g << 8) | r;
-}
+// Кластерные модели (.cmsh) не загружаются целиком, а подгружаются по мере необходимости
+ClusterStream clusterStream;
+std::string currentMeshName = "cube";
+
+// Сфера и тор по умолчанию рисуются как параметрические поверхности с адаптивной тесселяцией
+bool adaptiveTessellation = true;
+bool surfaceSelected = false;
+ParametricShape activeSurface;
+TessellationInfo lastTessellation;
+
+// Динамическое разрешение: внутренний кадр уменьшается, чтобы уложиться в бюджет
+bool dynamicResolution = false;
+float targetFrameMs = 16.6f;
+
+// Отладочный вид: сколько раз записан каждый пиксель
+bool overdrawView = false;
+
+// Приближённые sin/cos и 1/sqrt для нормалей и освещения (уже сгенерированные фигуры не пересчитываются)
+bool fastMath = FastMath::GetMode() == FastMath::Fast;
+
+// Номер сцены: меняется при каждой загрузке или выборе модели
+int sceneVersion = 0;
+
+// Всё, от чего зависит картинка сцены. Если между кадрами ничего не изменилось,
+// растеризация пропускается и на экран повторно выводится прошлый кадр
+struct SceneState {
+    float rotX = 0.0f;
+    float rotY = 0.0f;
+    float zoom = 0.0f;
+    int version = -1;
+    bool adaptiveTessellation = false;
+    bool overdrawView = false;
+    bool fastMath = false;
+    int width = 0;
+    int height = 0;
+
+    // Совпадает всё, кроме камеры: кадру не нужны новые буферы
+    bool SameSetup(const SceneState& other) const {
+        return version == other.version && adaptiveTessellation == other.adaptiveTessellation &&
+               overdrawView == other.overdrawView && fastMath == other.fastMath && width == other.width &&
+               height == other.height;
+    }
+
+    bool operator==(const SceneState& other) const {
+        return rotX == other.rotX && rotY == other.rotY && zoom == other.zoom && version == other.version &&
+               adaptiveTessellation == other.adaptiveTessellation && overdrawView == other.overdrawView &&
+               fastMath == other.fastMath && width == other.width && height == other.height;
+    }
+};
+
+// Профилировщик стадий: таймлайн последнего кадра в панели и выгрузка трассы для chrome://tracing
+bool profilerEnabled = false;
+const float PROFILER_PANEL_HEIGHT = 110.0f;
+const char* TRACE_FILE = "profile_trace.json";
+
+// Сколько кадров подряд без изменений, прежде чем ждать событий вместо опроса:
+// ImGui нужен кадр-другой, чтобы отработать ввод (наведение, отпускание кнопки)
+const int IDLE_FRAMES_BEFORE_WAIT = 3;
+// Таймаут ожидания: раз в столько секунд интерфейс всё равно обновляется
+const double IDLE_WAIT_SECONDS = 0.5;
 
 void ReloadMesh(Mesh& mesh, const std::string& filename) {
     std::string fullPath = ASSETS_DIR + filename;
+    if (fs::path(filename).extension() == ".cmsh") {
+        if (clusterStream.Open(fullPath)) {
+            currentMeshName = fs::path(filename).stem().string();
+            surfaceSelected = false;
+            sceneVersion++;
+        }
+        return;
+    }
     if (fs::exists(fullPath)) {
-        Mesh temp = Mesh::LoadFromObj(fullPath);
-        if (!temp.faces.empty()) {
+        Mesh temp = Mesh::LoadFromFile(fullPath);
+        if (!temp.faces.empty() && temp.validated) {
             mesh = temp;
+            clusterStream.Close();
+            surfaceSelected = false;
+            currentMeshName = fs::path(filename).stem().string();
+            sceneVersion++;
             std::cout << "Loaded: " << filename << std::endl;
         }
     } else {
@@ -45,6 +123,21 @@ void ReloadMesh(Mesh& mesh, const std::string& filename) {
     }
 }
 
+void SelectGenerated(Mesh& mesh, const Mesh& generated, const std::string& name) {
+    mesh = generated;
+    clusterStream.Close();
+    currentMeshName = name;
+    surfaceSelected = false;
+    sceneVersion++;
+}
+
+void SelectSurface(Mesh& mesh, const Mesh& generated, const std::string& name, const ParametricShape& shape) {
+    // Меш тоже сохраняем: он нужен при выключенной адаптивной тесселяции и для экспорта
+    SelectGenerated(mesh, generated, name);
+    activeSurface = shape;
+    surfaceSelected = true;
+}
+
 void ImportAndLoad(Mesh& mesh, const std::string& sourcePath) {
     if (!fs::exists(sourcePath)) {
         std::cerr << "Import failed: Source file doesn't exist." << std::endl;
@@ -68,6 +161,142 @@ void ImportAndLoad(Mesh& mesh, const std::string& sourcePath) {
     }
 }
 
+// Таймлайн последнего кадра: по потоку на блок, вложенные замеры — строками ниже
+void DrawProfilerTimeline() {
+    int64_t frameStart = 0, frameEnd = 0;
+    if (!Profiler::GetLastFrame(frameStart, frameEnd) || frameEnd <= frameStart) {
+        ImGui::Text("Waiting for frames...");
+        return;
+    }
+    const double frameNs = (double)(frameEnd - frameStart);
+    ImGui::SameLine();
+    ImGui::Text("Last frame: %.2f ms", frameNs / 1e6);
+
+    const float rowHeight = 16.0f;
+    const float width = ImGui::GetContentRegionAvail().x;
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+    for (const ProfileThreadEvents& thread : Profiler::Collect(frameStart, frameEnd)) {
+        int rows = 1;
+        for (const ProfileEvent& event : thread.events) rows = std::max(rows, event.depth + 1);
+
+        ImGui::TextDisabled("%s", thread.name.c_str());
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        ImGui::Dummy(ImVec2(width, rows * rowHeight));
+
+        for (const ProfileEvent& event : thread.events) {
+            // События на границах кадра обрезаются по кадру
+            double start = (double)(std::max(event.start, frameStart) - frameStart) / frameNs;
+            double end = (double)(std::min(event.end, frameEnd) - frameStart) / frameNs;
+            ImVec2 a(origin.x + (float)(start * width), origin.y + event.depth * rowHeight);
+            ImVec2 b(std::max(origin.x + (float)(end * width), a.x + 1.0f), a.y + rowHeight - 1.0f);
+
+            // Цвет постоянен для имени, чтобы стадии узнавались от кадра к кадру
+            unsigned hash = 2166136261u;
+            for (const char* c = event.name; *c; c++) hash = (hash ^ (unsigned char)*c) * 16777619u;
+            drawList->AddRectFilled(a, b, ImColor::HSV((hash % 360) / 360.0f, 0.5f, 0.75f));
+
+            drawList->PushClipRect(a, b, true);
+            drawList->AddText(ImVec2(a.x + 2.0f, a.y + 1.0f), IM_COL32(0, 0, 0, 255), event.name);
+            drawList->PopClipRect();
+
+            if (ImGui::IsMouseHoveringRect(a, b)) {
+                ImGui::SetTooltip("%s: %.3f ms", event.name, (event.end - event.start) / 1e6);
+            }
+        }
+    }
+}
+
+// Панель управления внизу окна
+void BuildControlPanel(Mesh& myMesh, const Renderer& renderer, const ResolutionController& resolution) {
+    PROFILE_SCOPE("UI");
+    // С профилировщиком панель выше: под ней таймлайн кадра
+    const float panelHeight = profilerEnabled ? 140.0f + PROFILER_PANEL_HEIGHT : 140.0f;
+    ImGui::SetNextWindowPos(ImVec2(0, WINDOW_HEIGHT - panelHeight));
+    ImGui::SetNextWindowSize(ImVec2(WINDOW_WIDTH, panelHeight));
+    ImGui::Begin("Control Panel", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoTitleBar);
+
+    ImGui::Text("Models:");
+    if (ImGui::Button("Cube")) ReloadMesh(myMesh, "cube.obj");
+    ImGui::SameLine();
+    if (ImGui::Button("Pyramid")) ReloadMesh(myMesh, "pyramid.obj");
+    ImGui::SameLine();
+    if (ImGui::Button("Sphere")) {
+        SelectSurface(myMesh, ShapesGenerator::SmoothSphere(1.0f, 50, 50), "sphere", {ParametricShape::Sphere, 1.0f, 0.0f});
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Torus")) {
+        SelectSurface(myMesh, ShapesGenerator::SmoothTorus(1.0f, 0.4f, 60, 30), "torus", {ParametricShape::Torus, 1.0f, 0.4f});
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Stress")) {
+        // ~500 тыс. треугольников: 400 геосфер по 1280 граней
+        SelectGenerated(myMesh, ShapesGenerator::InstanceField(ShapesGenerator::Icosphere(1.0f, 8), 400, 2.5f, 1), "stress");
+    }
+    if (clusterStream.IsOpen()) {
+        const ClusterStream::Stats& st = clusterStream.GetStats();
+        ImGui::SameLine();
+        ImGui::Text("Clusters: %d/%d visible, %d missing, %d corrupted | %.1f MB resident",
+                    st.visible, st.clusters, st.missing, st.failed, st.residentBytes / (1024.0 * 1024.0));
+    }
+
+    ImGui::Separator();
+    
+    ImGui::Text("Camera:");
+    ImGui::SliderFloat("Zoom", &cameraZoom, 2.0f, 20.0f);
+    ImGui::Checkbox("Auto Rotate", &autoRotate);
+    ImGui::SameLine();
+    ImGui::Checkbox("Adaptive Tessellation", &adaptiveTessellation);
+    if (surfaceSelected && adaptiveTessellation) {
+        ImGui::SameLine();
+        ImGui::Text("%dx%d (%d tris)", lastTessellation.rows, lastTessellation.columns, lastTessellation.triangles);
+    }
+    ImGui::Text("Tiles: %d+%d cleared, %d uploaded of %d", renderer.GetTouchClearedTiles(),
+                renderer.GetResolvedTiles(), renderer.GetPresentedTiles(), renderer.GetTileCount());
+    const RenderStats& stats = renderer.GetStats();
+    ImGui::Text("Faces: %llu submitted, %llu back, %llu off-screen, %llu clipped | Pixels: %.2fM tested, %.2fM written (%.2fx)",
+                (unsigned long long)stats.facesSubmitted, (unsigned long long)stats.facesBackCulled,
+                (unsigned long long)stats.facesFrustumCulled, (unsigned long long)stats.trianglesClipped,
+                stats.pixelsTested / 1e6, stats.pixelsWritten / 1e6,
+                (double)stats.pixelsWritten / ((double)renderer.GetWidth() * renderer.GetHeight()));
+    ImGui::Checkbox("Overdraw View", &overdrawView);
+    ImGui::SameLine();
+    if (ImGui::Checkbox("Fast Math", &fastMath)) FastMath::SetMode(fastMath ? FastMath::Fast : FastMath::Exact);
+    ImGui::SameLine();
+    ImGui::Checkbox("Dynamic Resolution", &dynamicResolution);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120);
+    ImGui::SliderFloat("Budget ms", &targetFrameMs, 4.0f, 50.0f, "%.1f");
+    ImGui::SameLine();
+    ImGui::Text("%dx%d (%.0f%%), %.1f ms", renderer.GetWidth(), renderer.GetHeight(),
+                resolution.GetScale() * 100.0f, resolution.GetAverageMs());
+
+    if (ImGui::Checkbox("Profiler", &profilerEnabled)) Profiler::SetEnabled(profilerEnabled);
+    ImGui::SameLine();
+    if (ImGui::Button("Export Trace")) Profiler::WriteChromeTrace(TRACE_FILE);
+    if (profilerEnabled) DrawProfilerTimeline();
+    
+    ImGui::Separator();
+    ImGui::Text("Import Custom .OBJ / .GLB:");
+    ImGui::PushItemWidth(400);
+    ImGui::InputText("##path", importPathBuffer, sizeof(importPathBuffer));
+    ImGui::PopItemWidth();
+    ImGui::SameLine();
+    if (ImGui::Button("Load File")) {
+        ImportAndLoad(myMesh, std::string(importPathBuffer));
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Export .obj") && !clusterStream.IsOpen()) {
+        myMesh.SaveToObj(ASSETS_DIR + currentMeshName + ".obj");
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Export .cmsh") && !clusterStream.IsOpen()) {
+        ClusterFile::Write(myMesh, ASSETS_DIR + currentMeshName + ".cmsh");
+    }
+
+    ImGui::End();
+}
+
 int main() {
     if (!glfwInit()) return -1;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -87,147 +316,130 @@ int main() {
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
 
-    Renderer renderer(WINDOW_WIDTH, WINDOW_HEIGHT);
-    ShapesGenerator::CreateSmoothSphere("../assets/sphere.obj", 1.0f, 50, 50);
-    ShapesGenerator::CreateSmoothTorus("../assets/torus.obj", 1.0f, 0.4f, 60, 30);
+    GLPresenter presenter(WINDOW_WIDTH, WINDOW_HEIGHT, (GLPresenter::ProcLoader)glfwGetProcAddress);
+    Renderer renderer(WINDOW_WIDTH, WINDOW_HEIGHT, &presenter);
+    ResolutionController resolution(WINDOW_WIDTH, WINDOW_HEIGHT);
     Mesh myMesh;
     ReloadMesh(myMesh, "cube.obj");
     
     if (myMesh.faces.empty()) {
          myMesh.vertices = {{-1,-1,0}, {0,1,0}, {1,-1,0}};
          myMesh.faces = {{0, 1, 2}};
+         myMesh.Sanitize();
     }
 
-    while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
+    SceneState lastScene;
+    int idleFrames = 0;
+    int steadyFrames = 0; // Кадров подряд с той же настройкой сцены
 
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+    Profiler::SetThreadName("main");
 
-        //обрабатываем вращение мыши через imGUI
-        if (!io.WantCaptureMouse && !autoRotate) {
-            if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
-                rotY += io.MouseDelta.x * 0.01f;
-                rotX += io.MouseDelta.y * 0.01f;
-            }
+    while (!glfwWindowShouldClose(window)) {
+        Profiler::BeginFrame();
+
+        // В простое не крутим цикл впустую, а спим до ввода или таймаута
+        if (idleFrames >= IDLE_FRAMES_BEFORE_WAIT) {
+            PROFILE_SCOPE("Wait Events");
+            glfwWaitEventsTimeout(IDLE_WAIT_SECONDS);
+        } else {
+            PROFILE_SCOPE("Poll Events");
+            glfwPollEvents();
         }
-        
 
-        if (autoRotate) {
-            rotX += 0.01f;
-            rotY += 0.02f;
+        {
+            PROFILE_SCOPE("Input");
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+
+            //обрабатываем вращение мыши через imGUI
+            if (!io.WantCaptureMouse && !autoRotate) {
+                if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+                    rotY += io.MouseDelta.x * 0.01f;
+                    rotX += io.MouseDelta.y * 0.01f;
+                }
+            }
+
+            if (autoRotate) {
+                rotX += 0.01f;
+                rotY += 0.02f;
+            }
         }
 
         // --- UI ---
-        ImGui::SetNextWindowPos(ImVec2(0, WINDOW_HEIGHT - 140));
-        ImGui::SetNextWindowSize(ImVec2(WINDOW_WIDTH, 140));
-        ImGui::Begin("Control Panel", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoTitleBar);
+        BuildControlPanel(myMesh, renderer, resolution);
 
-        ImGui::Text("Models:");
-        if (ImGui::Button("Cube")) ReloadMesh(myMesh, "cube.obj");
-        ImGui::SameLine();
-        if (ImGui::Button("Pyramid")) ReloadMesh(myMesh, "pyramid.obj");
-        ImGui::SameLine();
-        if (ImGui::Button("Sphere")) ReloadMesh(myMesh, "sphere.obj");
-        ImGui::SameLine();
-        if (ImGui::Button("Torus")) ReloadMesh(myMesh, "torus.obj");
-
-        ImGui::Separator();
-        
-        ImGui::Text("Camera:");
-        ImGui::SliderFloat("Zoom", &cameraZoom, 2.0f, 20.0f);
-        ImGui::Checkbox("Auto Rotate", &autoRotate);
-        
-        ImGui::Separator();
-        ImGui::Text("Import Custom .OBJ:");
-        ImGui::PushItemWidth(400);
-        ImGui::InputText("##path", importPathBuffer, sizeof(importPathBuffer));
-        ImGui::PopItemWidth();
-        ImGui::SameLine();
-        if (ImGui::Button("Load File")) {
-            ImportAndLoad(myMesh, std::string(importPathBuffer));
+        resolution.settings.targetMs = targetFrameMs;
+        if (!dynamicResolution) {
+            resolution.Reset();
+            renderer.Resize(WINDOW_WIDTH, WINDOW_HEIGHT);
         }
 
-        ImGui::End();
-        // --- END IMGUI UPDATE ---
-
-        renderer.Clear(MakeColor(40, 40, 40));
-
+        SceneState scene;
+        scene.rotX = rotX;
+        scene.rotY = rotY;
+        scene.zoom = cameraZoom;
+        scene.version = sceneVersion;
+        scene.adaptiveTessellation = adaptiveTessellation;
+        scene.overdrawView = overdrawView;
+        scene.fastMath = fastMath;
+        scene.width = renderer.GetWidth();
+        scene.height = renderer.GetHeight();
+
+        // Кластерная модель может меняться и без ввода, пока догружаются страницы
+        const ClusterStream::Stats& streamStats = clusterStream.GetStats();
+        bool streaming = clusterStream.IsOpen() && (streamStats.missing > 0 || streamStats.loaded > 0);
+
+        if (scene == lastScene && !streaming) {
+            PROFILE_SCOPE("Redraw");
+            presenter.Redraw();
+            idleFrames++;
+        } else {
+            PROFILE_SCOPE("Render");
+            steadyFrames = scene.SameSetup(lastScene) ? steadyFrames + 1 : 0;
+            lastScene = scene;
+            idleFrames = 0;
+            renderer.SetViewMode(overdrawView ? Renderer::Overdraw : Renderer::Shaded);
+
+            // Замеряется только работа рендера: ожидание vsync в glfwSwapBuffers от разрешения не зависит
+            auto frameStart = std::chrono::steady_clock::now();
+
+            // После пары кадров с той же настройкой рендер не должен обращаться к куче.
+            // Подгрузка страниц кластерной модели выделяет память по определению и не проверяется
+            {
+                NoAllocScope noAlloc("frame render", steadyFrames >= 2 && !clusterStream.IsOpen());
+                renderer.Clear(MakeColor(40, 40, 40));
+
+                Affine3x4 matWorld = MakeWorldMatrix(rotX, rotY, cameraZoom);
+                Mat4 matProj = MakeProjection(renderer.GetWidth(), renderer.GetHeight());
+
+                if (clusterStream.IsOpen()) {
+                    for (const ClusterStream::Page* page : clusterStream.Update(matWorld, matProj, renderer.GetHeight())) {
+                        RenderFaces(renderer, page->vertices, page->faces, matWorld, matProj);
+                    }
+                } else if (surfaceSelected && adaptiveTessellation) {
+                    lastTessellation = RenderParametric(renderer, activeSurface, matWorld, matProj);
+                } else {
+                    RenderFaces(renderer, myMesh.vertices, myMesh.faces, matWorld, matProj);
+                }
+
+                renderer.DrawBuffer();
+            }
 
-        Mat4 matRotY = Mat4::RotateY(rotY);
-        Mat4 matRotX = Mat4::RotateX(rotX); 
-        
-        Mat4 matTrans = Mat4::Translate(0.0f, 0.0f, cameraZoom); 
-
-        float aspect = (float)WINDOW_HEIGHT / (float)WINDOW_WIDTH;
-        Mat4 matProj = Mat4::Projection(1.57f, aspect, 0.1f, 100.0f);
-
-        Mat4 matWorld = Mat4::Identity();
-        matWorld = matRotY * matWorld;
-        matWorld = matRotX * matWorld;
-        matWorld = matTrans * matWorld;
-
-        for (const auto& face : myMesh.faces) {
-            if (face.v[0] >= myMesh.vertices.size() || 
-                face.v[1] >= myMesh.vertices.size() || 
-                face.v[2] >= myMesh.vertices.size()) continue;
-
-            // 1. Transform
-            Vec3 v0 = MultiplyMatrixVector(myMesh.vertices[face.v[0]], matWorld);
-            Vec3 v1 = MultiplyMatrixVector(myMesh.vertices[face.v[1]], matWorld);
-            Vec3 v2 = MultiplyMatrixVector(myMesh.vertices[face.v[2]], matWorld);
-
-            // 2. Calculate Normal
-            Vec3 edge1 = v1 - v0;
-            Vec3 edge2 = v2 - v0;
-            Vec3 normal = CrossProduct(edge1, edge2).Normalize();
-
-            // 3. Backface Culling
-            Vec3 viewDir = (v0 * -1.0f).Normalize();
-
-            if (DotProduct(normal, viewDir) > 0.0f) {
-                
-                // 4. Lighting
-                Vec3 lightDir = Vec3(0.5f, 1.0f, -1.0f).Normalize(); 
-                float dot = DotProduct(normal, lightDir);
-                float intensity = std::max(0.0f, dot);
-                intensity = 0.1f + (0.9f * intensity);
-                if (intensity > 1.0f) intensity = 1.0f;
-
-                uint8_t r = (uint8_t)(255 * intensity);
-                uint8_t g = (uint8_t)(165 * intensity);
-                uint8_t b = (uint8_t)(0   * intensity);
-
-                uint32_t color = MakeColor(r, g, b);
-
-                // 5. Projection & Viewport
-                Vec3 p0 = MultiplyMatrixVector(v0, matProj);
-                Vec3 p1 = MultiplyMatrixVector(v1, matProj);
-                Vec3 p2 = MultiplyMatrixVector(v2, matProj);
-                
-                auto ToScreen = [&](Vec3& p) {
-                    p.x = (p.x + 1.0f) * 0.5f * WINDOW_WIDTH;
-                    p.y = (p.y + 1.0f) * 0.5f * WINDOW_HEIGHT;
-                };
-                ToScreen(p0); ToScreen(p1); ToScreen(p2);
-
-                // 6. Draw
-                renderer.DrawTriangle(
-                    (int)p0.x, (int)p0.y, 
-                    (int)p1.x, (int)p1.y, 
-                    (int)p2.x, (int)p2.y, 
-                    color
-                );
+            float frameMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+            if (dynamicResolution && resolution.Update(frameMs)) {
+                renderer.Resize(resolution.GetWidth(), resolution.GetHeight());
             }
         }
 
-        renderer.DrawBuffer();
-
         // Рендерим интерфейс поверх всего
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            PROFILE_SCOPE("ImGui Render");
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
+        PROFILE_SCOPE("Swap");
         glfwSwapBuffers(window);
     }
 
@@ -0,0 +1,146 @@
+#include "mapped_file.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ENGINE_HAS_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::string& filename) {
+    Close();
+
+#ifdef ENGINE_HAS_MMAP
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "ERROR: Could not open file " << filename << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        std::cerr << "ERROR: Empty or unreadable file " << filename << std::endl;
+        close(fd);
+        return false;
+    }
+
+    void* ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // Отображение остаётся валидным и после закрытия дескриптора
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        std::cerr << "ERROR: mmap failed for " << filename << std::endl;
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*>(ptr);
+    m_size = (size_t)st.st_size;
+    m_mapped = true;
+    return true;
+#elif defined(_WIN32)
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "ERROR: Could not open file " << filename << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+        std::cerr << "ERROR: Empty or unreadable file " << filename << std::endl;
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    // Отображение удерживает файл открытым, дескриптор файла больше не нужен
+    CloseHandle(file);
+    if (!mapping) {
+        std::cerr << "ERROR: CreateFileMapping failed for " << filename << std::endl;
+        return false;
+    }
+
+    void* ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!ptr) {
+        std::cerr << "ERROR: MapViewOfFile failed for " << filename << std::endl;
+        CloseHandle(mapping);
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*>(ptr);
+    m_size = (size_t)size.QuadPart;
+    m_mapping = mapping;
+    m_mapped = true;
+    return true;
+#else
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        std::cerr << "ERROR: Could not open file " << filename << std::endl;
+        return false;
+    }
+
+    std::streamsize size = file.tellg();
+    if (size <= 0) {
+        std::cerr << "ERROR: Empty or unreadable file " << filename << std::endl;
+        return false;
+    }
+
+    m_fallback.resize((size_t)size);
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(m_fallback.data()), size)) {
+        std::cerr << "ERROR: Could not read file " << filename << std::endl;
+        m_fallback.clear();
+        return false;
+    }
+
+    m_data = m_fallback.data();
+    m_size = m_fallback.size();
+    return true;
+#endif
+}
+
+void MappedFile::Release(size_t offset, size_t length) const {
+#ifdef ENGINE_HAS_MMAP
+    if (!m_mapped || offset >= m_size) return;
+    length = std::min(length, m_size - offset);
+
+    // madvise работает только с целыми страницами: сужаем диапазон внутрь
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t begin = reinterpret_cast<uintptr_t>(m_data) + offset;
+    uintptr_t end = begin + length;
+    begin = (begin + page - 1) & ~(uintptr_t)(page - 1);
+    end &= ~(uintptr_t)(page - 1);
+    if (begin < end) madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+#else
+    // Файловые страницы Windows вытесняются из рабочего набора самой ОС
+    (void)offset;
+    (void)length;
+#endif
+}
+
+void MappedFile::Close() {
+#ifdef ENGINE_HAS_MMAP
+    if (m_mapped) munmap(const_cast<uint8_t*>(m_data), m_size);
+#elif defined(_WIN32)
+    if (m_mapped) {
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+#endif
+    m_fallback.clear();
+    m_fallback.shrink_to_fit();
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+}
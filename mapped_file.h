@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Файл, отображённый в память только для чтения (mmap / MapViewOfFile).
+// Данные не копируются: страницы подгружает ОС по мере обращения.
+// На платформах без отображения файл просто читается в буфер целиком.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    const uint8_t* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+    bool IsOpen() const { return m_data != nullptr; }
+
+    // Подсказка ОС, что диапазон больше не нужен и его страницы можно выгрузить.
+    // Данные остаются доступными: при следующем обращении они будут прочитаны с диска заново.
+    void Release(size_t offset, size_t length) const;
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_mapped = false;
+#ifdef _WIN32
+    void* m_mapping = nullptr;
+#endif
+
+    // Запасной вариант без mmap
+    std::vector<uint8_t> m_fallback;
+};
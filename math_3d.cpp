@@ -1,24 +1,37 @@
 #include "math_3d.h"
+#include "fast_math.h"
 #include <cmath>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINE_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Синус и косинус угла считаются один раз, в режиме FastMath
 Mat4 Mat4::RotateX(float theta) {
+    float s, c;
+    FastMath::SinCos(theta, s, c);
     Mat4 mat = Mat4::Identity();
-    mat.m[1][1] = cosf(theta); mat.m[1][2] = -sinf(theta);
-    mat.m[2][1] = sinf(theta); mat.m[2][2] = cosf(theta);
+    mat.m[1][1] = c; mat.m[1][2] = -s;
+    mat.m[2][1] = s; mat.m[2][2] = c;
     return mat;
 }
 
 Mat4 Mat4::RotateY(float theta) {
+    float s, c;
+    FastMath::SinCos(theta, s, c);
     Mat4 mat = Mat4::Identity();
-    mat.m[0][0] = cosf(theta); mat.m[0][2] = sinf(theta);
-    mat.m[2][0] = -sinf(theta); mat.m[2][2] = cosf(theta);
+    mat.m[0][0] = c; mat.m[0][2] = s;
+    mat.m[2][0] = -s; mat.m[2][2] = c;
     return mat;
 }
 
 Mat4 Mat4::RotateZ(float theta) {
+    float s, c;
+    FastMath::SinCos(theta, s, c);
     Mat4 mat = Mat4::Identity();
-    mat.m[0][0] = cosf(theta); mat.m[0][1] = -sinf(theta);
-    mat.m[1][0] = sinf(theta); mat.m[1][1] = cosf(theta);
+    mat.m[0][0] = c; mat.m[0][1] = -s;
+    mat.m[1][0] = s; mat.m[1][1] = c;
     return mat;
 }
 
@@ -43,16 +56,97 @@ Mat4 Mat4::Projection(float fov, float aspectRatio, float zNear, float zFar) {
     return mat;
 }
 
+// Строка результата i = сумма a[i][k] * (строка k второй матрицы): четыре умножения строк целиком.
+// Скалярный вариант складывает в том же порядке, чтобы результат не зависел от сборки
 Mat4 Mat4::operator*(const Mat4& other) const {
-    Mat4 res;
+    Mat4 res(Uninitialized);
+#ifdef ENGINE_HAS_SSE2
+    const __m128 b0 = _mm_load_ps(other.m[0]);
+    const __m128 b1 = _mm_load_ps(other.m[1]);
+    const __m128 b2 = _mm_load_ps(other.m[2]);
+    const __m128 b3 = _mm_load_ps(other.m[3]);
+    for (int i = 0; i < 4; i++) {
+        __m128 row = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[i][0]), b0), _mm_mul_ps(_mm_set1_ps(m[i][1]), b1)),
+                                           _mm_mul_ps(_mm_set1_ps(m[i][2]), b2)),
+                                _mm_mul_ps(_mm_set1_ps(m[i][3]), b3));
+        _mm_store_ps(res.m[i], row);
+    }
+#else
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 4; j++) {
-            res.m[i][j] = 0;
-            for (int k = 0; k < 4; k++) {
-                res.m[i][j] += m[i][k] * other.m[k][j];
-            }
+            res.m[i][j] = m[i][0] * other.m[0][j] + m[i][1] * other.m[1][j] + m[i][2] * other.m[2][j] +
+                          m[i][3] * other.m[3][j];
+        }
+    }
+#endif
+    return res;
+}
+
+// Верхние три строки: повороты и перенос собираются теми же формулами, что и в Mat4
+static Affine3x4 TopRows(const Mat4& mat) {
+    Affine3x4 res(Mat4::Uninitialized);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++) res.m[i][j] = mat.m[i][j];
+    return res;
+}
+
+Affine3x4 Affine3x4::Identity() {
+    Affine3x4 res;
+    res.m[0][0] = 1.0f; res.m[1][1] = 1.0f; res.m[2][2] = 1.0f;
+    return res;
+}
+
+Affine3x4 Affine3x4::RotateX(float theta) { return TopRows(Mat4::RotateX(theta)); }
+Affine3x4 Affine3x4::RotateY(float theta) { return TopRows(Mat4::RotateY(theta)); }
+Affine3x4 Affine3x4::RotateZ(float theta) { return TopRows(Mat4::RotateZ(theta)); }
+Affine3x4 Affine3x4::Translate(float x, float y, float z) { return TopRows(Mat4::Translate(x, y, z)); }
+
+// Как Mat4::operator* с нижней строкой (0, 0, 0, 1) у второго множителя, включая прибавление a[i][3] * 0
+Affine3x4 Affine3x4::operator*(const Affine3x4& other) const {
+    Affine3x4 res(Mat4::Uninitialized);
+#ifdef ENGINE_HAS_SSE2
+    const __m128 b0 = _mm_load_ps(other.m[0]);
+    const __m128 b1 = _mm_load_ps(other.m[1]);
+    const __m128 b2 = _mm_load_ps(other.m[2]);
+    const __m128 b3 = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+    for (int i = 0; i < 3; i++) {
+        __m128 row = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[i][0]), b0), _mm_mul_ps(_mm_set1_ps(m[i][1]), b1)),
+                                           _mm_mul_ps(_mm_set1_ps(m[i][2]), b2)),
+                                _mm_mul_ps(_mm_set1_ps(m[i][3]), b3));
+        _mm_store_ps(res.m[i], row);
+    }
+#else
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 4; j++) {
+            res.m[i][j] = m[i][0] * other.m[0][j] + m[i][1] * other.m[1][j] + m[i][2] * other.m[2][j] +
+                          m[i][3] * (j == 3 ? 1.0f : 0.0f);
         }
     }
+#endif
+    return res;
+}
+
+Vec3 Affine3x4::TransformPoint(const Vec3& p) const {
+    return Vec3(p.x * m[0][0] + p.y * m[0][1] + p.z * m[0][2] + m[0][3],
+                p.x * m[1][0] + p.y * m[1][1] + p.z * m[1][2] + m[1][3],
+                p.x * m[2][0] + p.y * m[2][1] + p.z * m[2][2] + m[2][3]);
+}
+
+// (R | t)^-1 = (R^T | -R^T t), если R ортонормирована
+Affine3x4 Affine3x4::InverseRigid() const {
+    Affine3x4 res(Mat4::Uninitialized);
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) res.m[i][j] = m[j][i];
+        res.m[i][3] = -(m[0][i] * m[0][3] + m[1][i] * m[1][3] + m[2][i] * m[2][3]);
+    }
+    return res;
+}
+
+Mat4 Affine3x4::ToMat4() const {
+    Mat4 res(Mat4::Uninitialized);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++) res.m[i][j] = m[i][j];
+    res.m[3][0] = 0.0f; res.m[3][1] = 0.0f; res.m[3][2] = 0.0f; res.m[3][3] = 1.0f;
     return res;
 }
 
@@ -16,14 +16,15 @@ struct Vec3 {
     }
 };
 
+// Строки выровнены по 16 байт: каждая целиком грузится в регистр SSE
 struct Mat4 {
-    float m[4][4];
+    // Mat4(Mat4::Uninitialized) — без обнуления, для матриц, которые сразу заполняются целиком
+    enum Init { Uninitialized };
 
-    Mat4() {
-        for(int i=0; i<4; i++)
-            for(int j=0; j<4; j++)
-                m[i][j] = 0.0f;
-    }
+    alignas(16) float m[4][4];
+
+    Mat4() : m{} {}
+    explicit Mat4(Init) {}
 
     static Mat4 Identity() {
         Mat4 res;
@@ -41,6 +42,32 @@ struct Mat4 {
     Mat4 operator*(const Mat4& other) const;
 };
 
+// Аффинное преобразование (поворот, масштаб, перенос): верхние три строки Mat4,
+// нижняя всегда (0, 0, 0, 1). Точка переводится без строки w и без деления —
+// для мировых матриц, где проекции нет. Результаты побитно совпадают с тем же преобразованием в Mat4
+struct Affine3x4 {
+    alignas(16) float m[3][4];
+
+    Affine3x4() : m{} {}
+    explicit Affine3x4(Mat4::Init) {}
+
+    static Affine3x4 Identity();
+    static Affine3x4 RotateX(float angleRadians);
+    static Affine3x4 RotateY(float angleRadians);
+    static Affine3x4 RotateZ(float angleRadians);
+    static Affine3x4 Translate(float x, float y, float z);
+
+    Affine3x4 operator*(const Affine3x4& other) const;
+
+    Vec3 TransformPoint(const Vec3& p) const;
+
+    // Обратное для поворота с переносом: транспонированный поворот и повёрнутый назад перенос.
+    // С масштабом или сдвигом результат неверен
+    Affine3x4 InverseRigid() const;
+
+    Mat4 ToMat4() const;
+};
+
 Vec3 MultiplyMatrixVector(const Vec3& i, const Mat4& m);
 
 float DotProduct(const Vec3& a, const Vec3& b);
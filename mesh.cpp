@@ -1,7 +1,16 @@
 #include "mesh.h"
+#include "glb_file.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cstring>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <charconv>
 
 Mesh Mesh::LoadFromObj(const std::string& filename) {
     Mesh mesh;
@@ -63,5 +72,302 @@ Mesh Mesh::LoadFromObj(const std::string& filename) {
     }
     
     std::cout << "Loaded " << filename << ": " << mesh.vertices.size() << " verts, " << mesh.faces.size() << " faces." << std::endl;
+    mesh.Sanitize();
     return mesh;
 }
+
+
+Mesh Mesh::LoadFromGlb(const std::string& filename) {
+    Mesh mesh;
+    GlbFile glb;
+    if (!glb.Open(filename)) return mesh;
+
+    for (const GlbFile::Primitive& prim : glb.GetPrimitives()) {
+        if (prim.mode != 4) {
+            std::cerr << "WARNING: Skipping non-triangle primitive (mode " << prim.mode << ") in " << filename << std::endl;
+            continue;
+        }
+
+        GlbFile::AccessorView positions = glb.GetAccessor(prim.position);
+        if (!positions.Valid() || positions.components != 3) continue;
+        if (positions.count > (size_t)INT_MAX - mesh.vertices.size()) {
+            std::cerr << "WARNING: Too many vertices, skipping primitive in " << filename << std::endl;
+            continue;
+        }
+
+        // Индексы проверяются до того, как что-то добавлено: каждый должен указывать на вершину
+        // примитива, тогда base + индекс заведомо помещается в int
+        GlbFile::AccessorView indices;
+        const uint32_t* indexData = nullptr;
+        if (prim.indices >= 0) {
+            indices = glb.GetAccessor(prim.indices);
+            if (!indices.Valid() || indices.components != 1) continue;
+            indexData = indices.AsUint32();
+            uint32_t maxIndex = 0;
+            for (size_t i = 0; i < indices.count / 3 * 3; i++)
+                maxIndex = std::max(maxIndex, indexData ? indexData[i] : indices.ReadIndex(i));
+            if (maxIndex >= positions.count) {
+                std::cerr << "WARNING: Vertex index out of range, skipping primitive in " << filename << std::endl;
+                continue;
+            }
+        }
+
+        int base = (int)mesh.vertices.size();
+
+        // Быстрый путь: float VEC3 без промежутков совпадает с Vec3 и копируется одним блоком
+        if (const Vec3* positionData = positions.AsVec3()) {
+            mesh.vertices.insert(mesh.vertices.end(), positionData, positionData + positions.count);
+        } else {
+            for (size_t i = 0; i < positions.count; i++) {
+                mesh.vertices.push_back(Vec3(positions.ReadFloat(i, 0), positions.ReadFloat(i, 1), positions.ReadFloat(i, 2)));
+            }
+        }
+
+        if (prim.indices < 0) {
+            // Неиндексированная геометрия: каждые три вершины — треугольник
+            for (size_t i = 0; i + 2 < positions.count; i += 3) {
+                mesh.faces.push_back({{base + (int)i, base + (int)i + 1, base + (int)i + 2}});
+            }
+            continue;
+        }
+
+        size_t triCount = indices.count / 3;
+        if (indexData && base == 0) {
+            // uint32 индексы по три подряд совпадают с раскладкой Face
+            static_assert(sizeof(Mesh::Face) == 3 * sizeof(uint32_t), "Face must be three packed indices");
+            size_t first = mesh.faces.size();
+            mesh.faces.resize(first + triCount);
+            std::memcpy(&mesh.faces[first], indexData, triCount * sizeof(Mesh::Face));
+        } else {
+            for (size_t t = 0; t < triCount; t++) {
+                Mesh::Face f;
+                for (int k = 0; k < 3; k++) f.v[k] = base + (int)indices.ReadIndex(t * 3 + k);
+                mesh.faces.push_back(f);
+            }
+        }
+    }
+
+    std::cout << "Loaded " << filename << ": " << mesh.vertices.size() << " verts, " << mesh.faces.size() << " faces." << std::endl;
+    mesh.Sanitize();
+    return mesh;
+}
+
+Mesh Mesh::LoadFromFile(const std::string& filename) {
+    std::string ext;
+    size_t dot = filename.find_last_of('.');
+    if (dot != std::string::npos) ext = filename.substr(dot + 1);
+    for (char& c : ext) c = (char)std::tolower((unsigned char)c);
+
+    if (ext == "glb") return LoadFromGlb(filename);
+    return LoadFromObj(filename);
+}
+
+bool Mesh::SaveToObj(const std::string& filename) const {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Failed to create " << filename << std::endl;
+        return false;
+    }
+
+    // Одна строка занимает меньше 64 байт, поэтому сбрасываем буфер, когда места осталось меньше этого
+    static const size_t BUFFER_SIZE = 1 << 16;
+    static const size_t MAX_LINE = 128;
+    std::vector<char> buffer(BUFFER_SIZE);
+    char* p = buffer.data();
+    char* const end = buffer.data() + BUFFER_SIZE;
+
+    auto flush = [&]() {
+        out.write(buffer.data(), p - buffer.data());
+        p = buffer.data();
+    };
+
+    for (const Vec3& v : vertices) {
+        if (end - p < (std::ptrdiff_t)MAX_LINE) flush();
+        *p++ = 'v';
+        for (float c : {v.x, v.y, v.z}) {
+            *p++ = ' ';
+            p = std::to_chars(p, end, c).ptr;
+        }
+        *p++ = '\n';
+    }
+
+    for (const Face& f : faces) {
+        if (end - p < (std::ptrdiff_t)MAX_LINE) flush();
+        *p++ = 'f';
+        for (int idx : f.v) {
+            *p++ = ' ';
+            p = std::to_chars(p, end, idx + 1).ptr; // В OBJ индексы начинаются с 1
+        }
+        *p++ = '\n';
+    }
+
+    flush();
+    out.close();
+    if (!out) {
+        std::cerr << "Failed to write " << filename << std::endl;
+        return false;
+    }
+    std::cout << "Saved " << filename << ": " << vertices.size() << " verts, " << faces.size() << " faces." << std::endl;
+    return true;
+}
+
+// Ключ ячейки пространственного хэша. Коллизии допустимы: вершины всё равно сравниваются по расстоянию.
+static uint64_t CellKey(int64_t x, int64_t y, int64_t z) {
+    return (uint64_t)(x * 73856093) ^ (uint64_t)(y * 19349663) ^ (uint64_t)(z * 83492791);
+}
+
+struct FaceKeyHash {
+    size_t operator()(const Mesh::Face& f) const {
+        uint64_t h = (uint64_t)(uint32_t)f.v[0] * 0x9E3779B97F4A7C15ull;
+        h ^= (uint64_t)(uint32_t)f.v[1] * 0xC2B2AE3D27D4EB4Full + (h >> 29);
+        h ^= (uint64_t)(uint32_t)f.v[2] * 0x165667B19E3779F9ull + (h >> 32);
+        return (size_t)h;
+    }
+};
+
+struct FaceKeyEqual {
+    bool operator()(const Mesh::Face& a, const Mesh::Face& b) const {
+        return a.v[0] == b.v[0] && a.v[1] == b.v[1] && a.v[2] == b.v[2];
+    }
+};
+
+// Номер ячейки хэша по одной оси. При крошечном допуске на огромной модели частное может
+// не влезть в int64_t, поэтому оно ограничивается ±2^62 (соседние ячейки тогда тоже в диапазоне)
+static int64_t CellCoord(float v, float cellSize) {
+    const float limit = 4611686018427387904.0f; // 2^62
+    return (int64_t)std::clamp(std::floor(v / cellSize), -limit, limit);
+}
+
+static bool IsFinite(const Vec3& v) {
+    return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+}
+
+void Mesh::Sanitize(float weldEpsilon) {
+    const int vertexCount = (int)vertices.size();
+
+    // 1. Вершины с NaN или бесконечностью (испорченный файл) не свариваются и не участвуют в габаритах,
+    // грани с ними отбрасываются. Допуск сварки считаем от размера модели
+    std::vector<uint8_t> finite(vertexCount);
+    Vec3 boxMin, boxMax;
+    bool first = true;
+    for (int i = 0; i < vertexCount; i++) {
+        const Vec3& v = vertices[i];
+        finite[i] = IsFinite(v);
+        if (!finite[i]) continue;
+        boxMin = first ? v : Vec3(std::min(boxMin.x, v.x), std::min(boxMin.y, v.y), std::min(boxMin.z, v.z));
+        boxMax = first ? v : Vec3(std::max(boxMax.x, v.x), std::max(boxMax.y, v.y), std::max(boxMax.z, v.z));
+        first = false;
+    }
+    Vec3 diag = boxMax - boxMin;
+    float eps = weldEpsilon * std::sqrt(DotProduct(diag, diag));
+    if (!(eps > 0.0f) || !std::isfinite(eps)) eps = weldEpsilon;
+    const float eps2 = eps * eps;
+    const float cellSize = eps;
+
+    // 2. Сварка: каждая вершина ищет представителя в своей и соседних ячейках
+    std::vector<int> weld(vertexCount);
+    std::vector<int> next(vertexCount, -1);     // Цепочки представителей внутри ячейки хэша
+    std::unordered_map<uint64_t, int> cells;
+    cells.reserve(vertexCount);
+    int welded = 0;
+
+    for (int i = 0; i < vertexCount; i++) {
+        const Vec3& v = vertices[i];
+        if (!finite[i]) {
+            weld[i] = i;
+            continue;
+        }
+        int64_t cx = CellCoord(v.x, cellSize);
+        int64_t cy = CellCoord(v.y, cellSize);
+        int64_t cz = CellCoord(v.z, cellSize);
+
+        int found = -1;
+        for (int dz = -1; dz <= 1 && found < 0; dz++) {
+            for (int dy = -1; dy <= 1 && found < 0; dy++) {
+                for (int dx = -1; dx <= 1 && found < 0; dx++) {
+                    auto it = cells.find(CellKey(cx + dx, cy + dy, cz + dz));
+                    if (it == cells.end()) continue;
+                    for (int j = it->second; j >= 0; j = next[j]) {
+                        Vec3 d = vertices[j] - v;
+                        if (DotProduct(d, d) <= eps2) { found = j; break; }
+                    }
+                }
+            }
+        }
+
+        if (found >= 0) {
+            weld[i] = found;
+            welded++;
+        } else {
+            weld[i] = i;
+            auto it = cells.find(CellKey(cx, cy, cz));
+            if (it == cells.end()) {
+                cells.emplace(CellKey(cx, cy, cz), i);
+            } else {
+                next[i] = it->second;
+                it->second = i;
+            }
+        }
+    }
+
+    // 3. Грани: диапазон индексов, конечность вершин, вырожденность, повторы
+    int outOfRange = 0, nonFinite = 0, degenerate = 0, duplicate = 0;
+    std::unordered_set<Face, FaceKeyHash, FaceKeyEqual> seen;
+    seen.reserve(faces.size());
+    std::vector<Face> clean;
+    clean.reserve(faces.size());
+
+    for (const Face& f : faces) {
+        if (f.v[0] < 0 || f.v[0] >= vertexCount ||
+            f.v[1] < 0 || f.v[1] >= vertexCount ||
+            f.v[2] < 0 || f.v[2] >= vertexCount) {
+            outOfRange++;
+            continue;
+        }
+        if (!finite[f.v[0]] || !finite[f.v[1]] || !finite[f.v[2]]) {
+            nonFinite++;
+            continue;
+        }
+
+        Face w = {{weld[f.v[0]], weld[f.v[1]], weld[f.v[2]]}};
+        Vec3 cross = CrossProduct(vertices[w.v[1]] - vertices[w.v[0]], vertices[w.v[2]] - vertices[w.v[0]]);
+        if (w.v[0] == w.v[1] || w.v[1] == w.v[2] || w.v[0] == w.v[2] || DotProduct(cross, cross) <= eps2 * eps2) {
+            degenerate++;
+            continue;
+        }
+
+        // Поворачиваем так, чтобы первым шёл меньший индекс: порядок обхода (и нормаль) сохраняется
+        Face key = w;
+        while (key.v[0] > key.v[1] || key.v[0] > key.v[2]) key = {{key.v[1], key.v[2], key.v[0]}};
+        if (!seen.insert(key).second) {
+            duplicate++;
+            continue;
+        }
+        clean.push_back(w);
+    }
+
+    // 4. Уплотняем массив вершин: остаются только используемые
+    std::vector<int> remap(vertexCount, -1);
+    AlignedVector<Vec3> used;
+    used.reserve(vertexCount - welded);
+    for (Face& f : clean) {
+        for (int k = 0; k < 3; k++) {
+            int& idx = remap[f.v[k]];
+            if (idx < 0) {
+                idx = (int)used.size();
+                used.push_back(vertices[f.v[k]]);
+            }
+            f.v[k] = idx;
+        }
+    }
+
+    if (welded || outOfRange || nonFinite || degenerate || duplicate) {
+        std::cout << "Sanitized: welded " << welded << " verts, dropped " << outOfRange << " out-of-range, "
+                  << nonFinite << " non-finite, " << degenerate << " degenerate, " << duplicate << " duplicate faces."
+                  << std::endl;
+    }
+
+    vertices = std::move(used);
+    faces = std::move(clean);
+    validated = true;
+}
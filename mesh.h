@@ -2,14 +2,33 @@
 #include <vector>
 #include <string>
 #include "math_3d.h" // Убедись, что Vec3 доступен
+#include "aligned_memory.h"
 
 struct Mesh {
-    std::vector<Vec3> vertices;
+    // Массив вершин выровнен на кэш-линию и для больших моделей лежит в огромных страницах
+    AlignedVector<Vec3> vertices;
     struct Face {
         int v[3]; // Индексы вершин
     };
     std::vector<Face> faces;
 
-    // Функция загрузки
+    // true после Sanitize: все индексы в диапазоне, вырожденных и повторяющихся граней нет
+    bool validated = false;
+
+    // Функции загрузки
     static Mesh LoadFromObj(const std::string& filename);
+    static Mesh LoadFromGlb(const std::string& filename);
+
+    // Выбирает загрузчик по расширению файла (.glb или .obj)
+    static Mesh LoadFromFile(const std::string& filename);
+
+    // Экспорт в .obj. Числа форматируются через std::to_chars в собственный буфер,
+    // который сбрасывается в файл крупными блоками.
+    bool SaveToObj(const std::string& filename) const;
+
+    // Однократная чистка после загрузки: отбрасывает грани с индексами вне диапазона и с вершинами NaN/inf,
+    // сваривает совпадающие вершины (ближе weldEpsilon от диагонали модели) через пространственный хэш,
+    // удаляет треугольники нулевой площади и повторы, выкидывает неиспользуемые вершины.
+    // После неё горячий цикл может обращаться к вершинам без проверок.
+    void Sanitize(float weldEpsilon = 1e-5f);
 };
\ No newline at end of file
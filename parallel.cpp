@@ -0,0 +1,35 @@
+#include "parallel.h"
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+int HardwareThreads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? (int)n : 1;
+}
+
+void ParallelFor(int begin, int end, const std::function<void(int, int)>& body, int threads) {
+    int count = end - begin;
+    if (count <= 0) return;
+
+    if (threads <= 0) threads = HardwareThreads();
+    threads = std::min(threads, count);
+    if (threads == 1) {
+        body(begin, end);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (int t = 0; t < threads; t++) {
+        // Размеры кусков отличаются не больше чем на единицу
+        int first = begin + (int)((long long)count * t / threads);
+        int last = begin + (int)((long long)count * (t + 1) / threads);
+        if (t == threads - 1) {
+            body(first, last);
+        } else {
+            workers.emplace_back(body, first, last);
+        }
+    }
+    for (auto& w : workers) w.join();
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <functional>
+
+// Число потоков по умолчанию: аппаратные потоки машины (минимум 1)
+int HardwareThreads();
+
+// Делит диапазон [begin, end) на непрерывные куски и обрабатывает их параллельно.
+// body(first, last) вызывается один раз для каждого куска, последний кусок выполняет вызывающий поток.
+// threads <= 0 — использовать все ядра.
+void ParallelFor(int begin, int end, const std::function<void(int, int)>& body, int threads = 0);
@@ -0,0 +1,105 @@
+#include "parametric_surface.h"
+#include "pipeline.h"
+#include "fast_math.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static const float TWO_PI = 2.0f * (float)M_PI;
+
+TessellationInfo ChooseTessellation(const ParametricShape& shape, const Affine3x4& matWorld, const Mat4& matProj,
+                                    int screenHeight, float pixelsPerEdge) {
+    // Расстояние до ближайшей точки ограничивающей сферы; изнутри — максимальная плотность
+    Vec3 center = matWorld.TransformPoint(Vec3(0, 0, 0));
+    float distance = std::sqrt(DotProduct(center, center)) - shape.BoundingRadius();
+    distance = std::max(distance, 0.1f);
+
+    // Пикселей на единицу длины на этом расстоянии
+    float pixelsPerUnit = matProj.m[1][1] * screenHeight * 0.5f / distance;
+
+    auto segments = [&](float length, int minimum) {
+        int n = (int)std::ceil(length * pixelsPerUnit / pixelsPerEdge);
+        return std::min(std::max(n, minimum), PARAMETRIC_MAX_SEGMENTS);
+    };
+
+    TessellationInfo info;
+    if (shape.kind == ParametricShape::Sphere) {
+        // Меридиан вдвое короче экватора
+        info.columns = segments(TWO_PI * shape.radius, 6);
+        info.rows = segments((float)M_PI * shape.radius, 3);
+        info.triangles = 2 * info.columns * (info.rows - 1);
+    } else {
+        info.rows = segments(TWO_PI * (shape.radius + shape.minorRadius), 6);
+        info.columns = segments(TWO_PI * shape.minorRadius, 3);
+        info.triangles = 2 * info.rows * info.columns;
+    }
+    return info;
+}
+
+TessellationInfo RenderParametric(Renderer& renderer, const ParametricShape& shape,
+                                  const Affine3x4& matWorld, const Mat4& matProj, float pixelsPerEdge) {
+    TessellationInfo info = ChooseTessellation(shape, matWorld, matProj, renderer.GetHeight(), pixelsPerEdge);
+    const int rows = info.rows;
+    const int columns = info.columns;
+    const bool sphere = shape.kind == ParametricShape::Sphere;
+
+    // Синусы и косинусы столбцов считаются один раз на кадр; последний столбец совпадает с первым,
+    // чтобы шов замыкался без щелей
+    float colCos[PARAMETRIC_MAX_SEGMENTS + 1];
+    float colSin[PARAMETRIC_MAX_SEGMENTS + 1];
+    for (int c = 0; c < columns; c++) colSin[c] = (float)c / columns * TWO_PI;
+    FastMath::SinCos(colSin, colSin, colCos, columns);
+    colCos[columns] = colCos[0];
+    colSin[columns] = colSin[0];
+
+    // Две строки вершин (уже в мировых координатах): предыдущая и текущая
+    Vec3 rowBuffer[2][PARAMETRIC_MAX_SEGMENTS + 1];
+
+    auto buildRow = [&](int r, Vec3* out) {
+        if (sphere) {
+            float phi = (float)r / rows * (float)M_PI;
+            float sp, cp;
+            FastMath::SinCos(phi, sp, cp);
+            if (r == 0) sp = 0.0f, cp = 1.0f;          // Полюса — точно в одной точке
+            if (r == rows) sp = 0.0f, cp = -1.0f;
+            for (int c = 0; c <= columns; c++) {
+                Vec3 p(shape.radius * sp * colCos[c], shape.radius * sp * colSin[c], shape.radius * cp);
+                out[c] = matWorld.TransformPoint(p);
+            }
+        } else {
+            float theta = (float)(r % rows) / rows * TWO_PI; // Строка rows совпадает со строкой 0
+            float st, ct;
+            FastMath::SinCos(theta, st, ct);
+            for (int c = 0; c <= columns; c++) {
+                float ring = shape.radius + shape.minorRadius * colCos[c];
+                Vec3 p(ring * ct, ring * st, shape.minorRadius * colSin[c]);
+                out[c] = matWorld.TransformPoint(p);
+            }
+        }
+    };
+
+    buildRow(0, rowBuffer[0]);
+    for (int r = 0; r < rows; r++) {
+        const Vec3* top = rowBuffer[r & 1];
+        Vec3* bottom = rowBuffer[(r + 1) & 1];
+        buildRow(r + 1, bottom);
+
+        // Та же разбивка квадов, что и в ShapesGenerator: (p1, p3, p2) и (p1, p4, p3).
+        // У полюсов сферы один из двух треугольников вырожден и пропускается.
+        for (int c = 0; c < columns; c++) {
+            const Vec3& p1 = top[c];
+            const Vec3& p2 = top[c + 1];
+            const Vec3& p3 = bottom[c + 1];
+            const Vec3& p4 = bottom[c];
+
+            if (!(sphere && r == 0)) RenderTriangle(renderer, p1, p3, p2, matProj);
+            if (!(sphere && r == rows - 1)) RenderTriangle(renderer, p1, p4, p3, matProj);
+        }
+    }
+    renderer.GetStats().verticesTransformed += (uint64_t)(rows + 1) * (columns + 1);
+
+    return info;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "math_3d.h"
+#include "renderer.h"
+
+// Параметрическая поверхность, которая не хранится как меш, а тесселируется заново в каждом кадре
+// с плотностью, подобранной по её размеру на экране: вблизи — гладкий силуэт,
+// вдали — несколько десятков треугольников. Память не зависит от плотности.
+struct ParametricShape {
+    enum Kind { Sphere, Torus };
+
+    Kind kind = Sphere;
+    float radius = 1.0f;        // Радиус сферы / большой радиус тора
+    float minorRadius = 0.4f;   // Малый радиус тора
+
+    float BoundingRadius() const { return kind == Sphere ? radius : radius + minorRadius; }
+};
+
+// Предел плотности по каждому направлению: под него заранее выделены буферы строк на стеке
+const int PARAMETRIC_MAX_SEGMENTS = 256;
+
+struct TessellationInfo {
+    int rows = 0;
+    int columns = 0;
+    int triangles = 0;
+};
+
+// Подбирает плотность по проекции ограничивающей сферы: ребро сетки должно занимать
+// на экране примерно pixelsPerEdge пикселей.
+TessellationInfo ChooseTessellation(const ParametricShape& shape, const Affine3x4& matWorld, const Mat4& matProj,
+                                    int screenHeight, float pixelsPerEdge = 8.0f);
+
+// Тесселирует поверхность построчно и сразу отдаёт треугольники в RenderTriangle.
+// Строки — широта сферы / большой угол тора, столбцы — долгота / малый угол, как в ShapesGenerator.
+// В памяти одновременно живут только две строки вершин.
+TessellationInfo RenderParametric(Renderer& renderer, const ParametricShape& shape,
+                                  const Affine3x4& matWorld, const Mat4& matProj, float pixelsPerEdge = 8.0f);
@@ -0,0 +1,143 @@
+#include "pipeline.h"
+#include "profiler.h"
+#include "simd_kernels.h"
+#include "fast_math.h"
+#include <algorithm>
+
+Affine3x4 MakeWorldMatrix(float rotX, float rotY, float zoom) {
+    return Affine3x4::Translate(0.0f, 0.0f, zoom) * (Affine3x4::RotateX(rotX) * Affine3x4::RotateY(rotY));
+}
+
+Mat4 MakeProjection(int width, int height) {
+    float aspect = (float)height / (float)width;
+    return Mat4::Projection(1.57f, aspect, 0.1f, 100.0f);
+}
+
+// Треугольник после геометрической стадии: экранные координаты и цвет
+struct ScreenTriangle {
+    int x0, y0;
+    int x1, y1;
+    int x2, y2;
+    uint32_t color;
+};
+
+// Ненормированные нормаль грани и направление на камеру; нормализуются пачкой через FastMath
+static void FaceVectors(const Vec3& v0, const Vec3& v1, const Vec3& v2, Vec3& normal, Vec3& viewDir) {
+    Vec3 edge1 = v1 - v0;
+    Vec3 edge2 = v2 - v0;
+    normal = CrossProduct(edge1, edge2);
+    viewDir = v0 * -1.0f;
+}
+
+// Освещение, отсечение задних граней и проекция по нормированным normal и viewDir.
+// false — треугольник не виден
+static bool SetupTriangle(const Vec3& v0, const Vec3& v1, const Vec3& v2, const Vec3& normal, const Vec3& viewDir,
+                          const Mat4& matProj, int width, int height, ScreenTriangle& out, RenderStats& stats) {
+    // 3. Backface Culling
+    if (DotProduct(normal, viewDir) <= 0.0f) {
+        stats.facesBackCulled++;
+        return false;
+    }
+
+    // 4. Lighting
+    static const Vec3 lightDir = Vec3(0.5f, 1.0f, -1.0f).Normalize();
+    float dot = DotProduct(normal, lightDir);
+    float intensity = std::max(0.0f, dot);
+    intensity = 0.1f + (0.9f * intensity);
+    if (intensity > 1.0f) intensity = 1.0f;
+
+    uint8_t r = (uint8_t)(255 * intensity);
+    uint8_t g = (uint8_t)(165 * intensity);
+    uint8_t b = (uint8_t)(0   * intensity);
+
+    // 5. Projection & Viewport
+    Vec3 p0 = MultiplyMatrixVector(v0, matProj);
+    Vec3 p1 = MultiplyMatrixVector(v1, matProj);
+    Vec3 p2 = MultiplyMatrixVector(v2, matProj);
+
+    auto ToScreen = [&](Vec3& p) {
+        p.x = (p.x + 1.0f) * 0.5f * (float)width;
+        p.y = (p.y + 1.0f) * 0.5f * (float)height;
+    };
+    ToScreen(p0); ToScreen(p1); ToScreen(p2);
+
+    out = {(int)p0.x, (int)p0.y, (int)p1.x, (int)p1.y, (int)p2.x, (int)p2.y, MakeColor(r, g, b)};
+
+    // Целиком за краем экрана: растеризатор всё равно ничего бы не нарисовал.
+    // Проверка по тем же целым координатам, что и обрезка в DrawTriangle
+    if (std::max({out.x0, out.x1, out.x2}) < 0 || std::min({out.x0, out.x1, out.x2}) >= width ||
+        std::max({out.y0, out.y1, out.y2}) < 0 || std::min({out.y0, out.y1, out.y2}) >= height) {
+        stats.facesFrustumCulled++;
+        return false;
+    }
+    return true;
+}
+
+void RenderFaces(Renderer& renderer, const AlignedVector<Vec3>& vertices, const std::vector<Mesh::Face>& faces,
+                 const Affine3x4& matWorld, const Mat4& matProj) {
+    RenderStats& stats = renderer.GetStats();
+    stats.verticesTransformed += vertices.size();
+    stats.facesSubmitted += faces.size();
+
+    // Промежуточные буферы проходов — из арены кадра. После вызова они не нужны, поэтому
+    // память возвращается сразу: кластерная модель вызывает RenderFaces на каждую страницу
+    LinearArena& arena = renderer.GetFrameArena().Main();
+    LinearArena::Marker marker = arena.GetMarker();
+    Vec3* worldVertices = arena.AllocateArray<Vec3>(vertices.size());
+    ScreenTriangle* screenTriangles = arena.AllocateArray<ScreenTriangle>(faces.size());
+    size_t triangleCount = 0;
+
+    // 1. Transform: каждая вершина один раз, а не в каждой из соседних граней
+    {
+        PROFILE_SCOPE("Transform");
+        GetKernels().transformAffine(vertices.data(), worldVertices, vertices.size(), matWorld);
+    }
+
+    // 2. Нормали граней и направления на камеру: корни считаются пачкой
+    Vec3* normals = arena.AllocateArray<Vec3>(faces.size());
+    Vec3* viewDirs = arena.AllocateArray<Vec3>(faces.size());
+    {
+        PROFILE_SCOPE("Normals");
+        for (size_t i = 0; i < faces.size(); i++) {
+            const Mesh::Face& face = faces[i];
+            FaceVectors(worldVertices[face.v[0]], worldVertices[face.v[1]], worldVertices[face.v[2]], normals[i], viewDirs[i]);
+        }
+        FastMath::Normalize(normals, faces.size());
+        FastMath::Normalize(viewDirs, faces.size());
+    }
+
+    // 3-5. Отсечение, освещение и проекция
+    {
+        PROFILE_SCOPE("Cull");
+        const int width = renderer.GetWidth();
+        const int height = renderer.GetHeight();
+        for (size_t i = 0; i < faces.size(); i++) {
+            const Mesh::Face& face = faces[i];
+            if (SetupTriangle(worldVertices[face.v[0]], worldVertices[face.v[1]], worldVertices[face.v[2]], normals[i],
+                              viewDirs[i], matProj, width, height, screenTriangles[triangleCount], stats)) {
+                triangleCount++;
+            }
+        }
+    }
+
+    // 6. Draw
+    {
+        PROFILE_SCOPE("Raster");
+        for (size_t i = 0; i < triangleCount; i++) {
+            const ScreenTriangle& t = screenTriangles[i];
+            renderer.DrawTriangle(t.x0, t.y0, t.x1, t.y1, t.x2, t.y2, t.color);
+        }
+    }
+    arena.Rewind(marker);
+}
+
+void RenderTriangle(Renderer& renderer, const Vec3& v0, const Vec3& v1, const Vec3& v2, const Mat4& matProj) {
+    ScreenTriangle t;
+    renderer.GetStats().facesSubmitted++;
+    Vec3 normal, viewDir;
+    FaceVectors(v0, v1, v2, normal, viewDir);
+    if (SetupTriangle(v0, v1, v2, FastMath::Normalize(normal), FastMath::Normalize(viewDir), matProj,
+                      renderer.GetWidth(), renderer.GetHeight(), t, renderer.GetStats())) {
+        renderer.DrawTriangle(t.x0, t.y0, t.x1, t.y1, t.x2, t.y2, t.color);
+    }
+}
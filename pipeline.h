@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+#include "math_3d.h"
+#include "mesh.h"
+#include "renderer.h"
+
+// Камера движка: модель вращается вокруг своего центра и отодвигается на zoom вдоль +z.
+// Общие для окна и пакетного рендера, чтобы кадры совпадали.
+Affine3x4 MakeWorldMatrix(float rotX, float rotY, float zoom);
+Mat4 MakeProjection(int width, int height);
+
+// Геометрическая стадия конвейера для набора граней, тремя проходами:
+// трансформация вершин в мировые координаты; отсечение задних граней, освещение по Ламберту,
+// проекция и перевод в экранные координаты; растеризация.
+// Используется и для обычного меша, и для подгружаемых кластеров.
+// Индексы граней не проверяются: они должны быть проверены при загрузке (Mesh::Sanitize, ClusterStream).
+void RenderFaces(Renderer& renderer, const AlignedVector<Vec3>& vertices, const std::vector<Mesh::Face>& faces,
+                 const Affine3x4& matWorld, const Mat4& matProj);
+
+// Та же стадия для одного треугольника, уже переведённого в мировые координаты.
+// Через неё идут поверхности, которые тесселируются прямо в кадре и не хранятся как меш.
+void RenderTriangle(Renderer& renderer, const Vec3& v0, const Vec3& v1, const Vec3& v2, const Mat4& matProj);
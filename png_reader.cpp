@@ -0,0 +1,327 @@
+#include "png_reader.h"
+#include "renderer.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+
+// --- Inflate ---
+// Классический разбор deflate по RFC 1951: канонические коды Хаффмана декодируются по длинам,
+// без таблиц быстрого поиска (эталоны маленькие, скорость здесь не важна)
+
+namespace {
+
+struct BitReader {
+    const uint8_t* data;
+    size_t size;
+    size_t pos = 0;
+    uint32_t bitBuffer = 0;
+    int bitCount = 0;
+    bool overflow = false;
+
+    BitReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    // Биты идут младшими вперёд
+    uint32_t Bits(int count) {
+        while (bitCount < count) {
+            if (pos >= size) {
+                overflow = true;
+                return 0;
+            }
+            bitBuffer |= (uint32_t)data[pos++] << bitCount;
+            bitCount += 8;
+        }
+        uint32_t value = bitBuffer & ((1u << count) - 1);
+        bitBuffer >>= count;
+        bitCount -= count;
+        return value;
+    }
+
+    void AlignToByte() {
+        bitBuffer = 0;
+        bitCount = 0;
+    }
+};
+
+const int MAX_BITS = 15;
+
+struct Huffman {
+    uint16_t counts[MAX_BITS + 1];
+    uint16_t symbols[288];
+
+    // false, если длины не образуют корректный код (неполный код допустим, как в zlib)
+    bool Build(const uint8_t* lengths, int n) {
+        std::memset(counts, 0, sizeof(counts));
+        for (int i = 0; i < n; i++) counts[lengths[i]]++;
+        if (counts[0] == n) return true;
+
+        int left = 1;
+        for (int len = 1; len <= MAX_BITS; len++) {
+            left = (left << 1) - counts[len];
+            if (left < 0) return false;
+        }
+
+        uint16_t offsets[MAX_BITS + 1];
+        offsets[1] = 0;
+        for (int len = 1; len < MAX_BITS; len++) offsets[len + 1] = offsets[len] + counts[len];
+        for (int i = 0; i < n; i++) {
+            if (lengths[i]) symbols[offsets[lengths[i]]++] = (uint16_t)i;
+        }
+        return true;
+    }
+
+    int Decode(BitReader& br) const {
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len <= MAX_BITS; len++) {
+            code |= (int)br.Bits(1);
+            if (br.overflow) return -1;
+            int count = counts[len];
+            if (code - count < first) return symbols[index + (code - first)];
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+};
+
+const uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t DIST_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+bool InflateCodes(BitReader& br, const Huffman& lengthCode, const Huffman& distCode, std::vector<uint8_t>& out) {
+    for (;;) {
+        int symbol = lengthCode.Decode(br);
+        if (symbol < 0) return false;
+        if (symbol < 256) {
+            out.push_back((uint8_t)symbol);
+            continue;
+        }
+        if (symbol == 256) return true;
+
+        symbol -= 257;
+        if (symbol >= 29) return false;
+        size_t length = LENGTH_BASE[symbol] + br.Bits(LENGTH_EXTRA[symbol]);
+
+        int distSymbol = distCode.Decode(br);
+        if (distSymbol < 0 || distSymbol >= 30) return false;
+        size_t distance = DIST_BASE[distSymbol] + br.Bits(DIST_EXTRA[distSymbol]);
+        if (br.overflow || distance > out.size()) return false;
+
+        // Копия может перекрываться сама с собой (distance < length), поэтому побайтно
+        size_t from = out.size() - distance;
+        for (size_t i = 0; i < length; i++) out.push_back(out[from + i]);
+    }
+}
+
+bool InflateStored(BitReader& br, std::vector<uint8_t>& out) {
+    br.AlignToByte();
+    if (br.pos + 4 > br.size) return false;
+    const uint8_t* p = br.data + br.pos;
+    uint32_t len = p[0] | (p[1] << 8);
+    uint32_t nlen = p[2] | (p[3] << 8);
+    if (len != (~nlen & 0xFFFF) || br.pos + 4 + len > br.size) return false;
+
+    out.insert(out.end(), p + 4, p + 4 + len);
+    br.pos += 4 + len;
+    return true;
+}
+
+struct FixedCodes {
+    Huffman lengthCode;
+    Huffman distCode;
+
+    FixedCodes() {
+        uint8_t lengths[288];
+        int i = 0;
+        for (; i < 144; i++) lengths[i] = 8;
+        for (; i < 256; i++) lengths[i] = 9;
+        for (; i < 280; i++) lengths[i] = 7;
+        for (; i < 288; i++) lengths[i] = 8;
+        lengthCode.Build(lengths, 288);
+        for (i = 0; i < 30; i++) lengths[i] = 5;
+        distCode.Build(lengths, 30);
+    }
+};
+
+bool InflateFixed(BitReader& br, std::vector<uint8_t>& out) {
+    static const FixedCodes codes;
+    return InflateCodes(br, codes.lengthCode, codes.distCode, out);
+}
+
+bool InflateDynamic(BitReader& br, std::vector<uint8_t>& out) {
+    static const uint8_t ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    int nlen = (int)br.Bits(5) + 257;
+    int ndist = (int)br.Bits(5) + 1;
+    int ncode = (int)br.Bits(4) + 4;
+    if (br.overflow || nlen > 286 || ndist > 30) return false;
+
+    uint8_t lengths[320] = {};
+    for (int i = 0; i < ncode; i++) lengths[ORDER[i]] = (uint8_t)br.Bits(3);
+    Huffman codeLengths;
+    if (br.overflow || !codeLengths.Build(lengths, 19)) return false;
+
+    // Длины кодов литералов и расстояний идут одним списком с повторами
+    int index = 0;
+    while (index < nlen + ndist) {
+        int symbol = codeLengths.Decode(br);
+        if (symbol < 0) return false;
+        if (symbol < 16) {
+            lengths[index++] = (uint8_t)symbol;
+            continue;
+        }
+
+        uint8_t value = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (index == 0) return false;
+            value = lengths[index - 1];
+            repeat = 3 + (int)br.Bits(2);
+        } else if (symbol == 17) {
+            repeat = 3 + (int)br.Bits(3);
+        } else {
+            repeat = 11 + (int)br.Bits(7);
+        }
+        if (br.overflow || index + repeat > nlen + ndist) return false;
+        while (repeat--) lengths[index++] = value;
+    }
+    if (lengths[256] == 0) return false;
+
+    Huffman lengthCode, distCode;
+    if (!lengthCode.Build(lengths, nlen) || !distCode.Build(lengths + nlen, ndist)) return false;
+    return InflateCodes(br, lengthCode, distCode, out);
+}
+
+// zlib-поток: заголовок, блоки deflate, Adler-32 несжатых данных
+bool Inflate(const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+    if (in.size() < 6) return false;
+    if ((in[0] & 0x0F) != 8 || ((in[0] << 8) | in[1]) % 31 != 0 || (in[1] & 0x20)) return false;
+
+    BitReader br(in.data() + 2, in.size() - 2);
+    bool last = false;
+    while (!last) {
+        last = br.Bits(1) != 0;
+        uint32_t type = br.Bits(2);
+        if (br.overflow) return false;
+
+        bool ok = false;
+        if (type == 0) ok = InflateStored(br, out);
+        else if (type == 1) ok = InflateFixed(br, out);
+        else if (type == 2) ok = InflateDynamic(br, out);
+        if (!ok) return false;
+    }
+
+    size_t end = br.pos + 2;
+    if (end + 4 > in.size()) return false;
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : out) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    const uint8_t* p = in.data() + end;
+    uint32_t stored = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    return stored == ((b << 16) | a);
+}
+
+uint32_t ReadU32BE(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+int Paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+bool Unfilter(uint8_t* data, int width, int height, int bpp) {
+    size_t rowBytes = (size_t)width * bpp;
+    uint8_t* prev = nullptr;
+    for (int y = 0; y < height; y++) {
+        uint8_t filter = data[0];
+        uint8_t* row = data + 1;
+        for (size_t i = 0; i < rowBytes; i++) {
+            int a = i >= (size_t)bpp ? row[i - bpp] : 0;
+            int b = prev ? prev[i] : 0;
+            int c = prev && i >= (size_t)bpp ? prev[i - bpp] : 0;
+            int predictor;
+            switch (filter) {
+                case 0: predictor = 0; break;
+                case 1: predictor = a; break;
+                case 2: predictor = b; break;
+                case 3: predictor = (a + b) / 2; break;
+                case 4: predictor = Paeth(a, b, c); break;
+                default: return false;
+            }
+            row[i] = (uint8_t)(row[i] + predictor);
+        }
+        prev = row;
+        data += rowBytes + 1;
+    }
+    return true;
+}
+
+} // namespace
+
+bool DecodePNG(const uint8_t* data, size_t size, std::vector<uint32_t>& pixels, int& width, int& height) {
+    static const uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (size < 8 || std::memcmp(data, SIGNATURE, 8) != 0) {
+        std::cerr << "ERROR: Not a PNG file" << std::endl;
+        return false;
+    }
+
+    width = height = 0;
+    int channels = 0;
+    std::vector<uint8_t> compressed;
+    size_t pos = 8;
+    bool ended = false;
+    while (!ended && pos + 12 <= size) {
+        uint32_t length = ReadU32BE(data + pos);
+        const uint8_t* type = data + pos + 4;
+        const uint8_t* body = data + pos + 8;
+        if (length > size - pos - 12) break;
+
+        if (std::memcmp(type, "IHDR", 4) == 0 && length >= 13) {
+            width = (int)ReadU32BE(body);
+            height = (int)ReadU32BE(body + 4);
+            int depth = body[8], colorType = body[9], interlace = body[12];
+            channels = colorType == 2 ? 3 : colorType == 6 ? 4 : 0;
+            if (depth != 8 || channels == 0 || interlace != 0) {
+                std::cerr << "ERROR: Unsupported PNG format (only 8-bit RGB/RGBA without interlace)" << std::endl;
+                return false;
+            }
+        } else if (std::memcmp(type, "IDAT", 4) == 0) {
+            compressed.insert(compressed.end(), body, body + length);
+        } else if (std::memcmp(type, "IEND", 4) == 0) {
+            ended = true;
+        }
+        pos += 12 + (size_t)length;
+    }
+
+    if (!ended || width <= 0 || height <= 0 || width > (1 << 16) || height > (1 << 16)) {
+        std::cerr << "ERROR: Broken PNG file" << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> raw;
+    raw.reserve(((size_t)width * channels + 1) * height);
+    if (!Inflate(compressed, raw) || raw.size() != ((size_t)width * channels + 1) * height ||
+        !Unfilter(raw.data(), width, height, channels)) {
+        std::cerr << "ERROR: Broken PNG image data" << std::endl;
+        return false;
+    }
+
+    pixels.resize((size_t)width * height);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = raw.data() + ((size_t)width * channels + 1) * y + 1;
+        for (int x = 0; x < width; x++) {
+            const uint8_t* p = row + (size_t)x * channels;
+            pixels[(size_t)y * width + x] = MakeColor(p[0], p[1], p[2], channels == 4 ? p[3] : 255);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Минимальный декодер PNG — для эталонных изображений регрессионных тестов и похожих служебных задач.
+// Поддерживается то, что пишет EncodePNG и обычные редакторы: 8 бит на канал, RGB или RGBA,
+// без interlace. Распаковка deflate полная (stored, фиксированные и динамические коды Хаффмана).
+// Пиксели возвращаются в формате буфера Renderer (MakeColor), построчно без отступов.
+bool DecodePNG(const uint8_t* data, size_t size, std::vector<uint32_t>& pixels, int& width, int& height);
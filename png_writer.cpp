@@ -0,0 +1,504 @@
+#include "png_writer.h"
+#include "renderer.h"
+#include "parallel.h"
+#include "profiler.h"
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINE_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// --- Контрольные суммы ---
+
+// Таблицы для CRC по 8 байт за шаг (slicing-by-8): на несжатых кадрах CRC — основная работа
+struct Crc32Table {
+    uint32_t entries[8][256];
+
+    Crc32Table() {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[0][n] = c;
+        }
+        for (uint32_t n = 0; n < 256; n++) {
+            for (int t = 1; t < 8; t++) entries[t][n] = (entries[t - 1][n] >> 8) ^ entries[0][entries[t - 1][n] & 0xFF];
+        }
+    }
+};
+
+static uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+    // Локальная статика инициализируется потокобезопасно: кадры кодируются параллельно
+    static const Crc32Table table;
+    const auto& t = table.entries;
+
+    crc = ~crc;
+    for (; size >= 8; size -= 8, data += 8) {
+        uint32_t lo = crc ^ ((uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24));
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+    }
+    for (; size > 0; size--) crc = t[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static const uint32_t ADLER_BASE = 65521;
+
+static uint32_t Adler32(const uint8_t* data, size_t size) {
+    uint32_t a = 1, b = 0;
+    while (size > 0) {
+        // 5552 — максимальная длина блока, при которой сумма не переполняет 32 бита
+        size_t block = std::min(size, (size_t)5552);
+        size -= block;
+        while (block--) {
+            a += *data++;
+            b += a;
+        }
+        a %= ADLER_BASE;
+        b %= ADLER_BASE;
+    }
+    return (b << 16) | a;
+}
+
+// Adler-32 склейки двух кусков по суммам кусков (как adler32_combine в zlib)
+static uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, size_t length2) {
+    uint32_t rem = (uint32_t)(length2 % ADLER_BASE);
+    uint32_t sum1 = adler1 & 0xFFFF;
+    uint32_t sum2 = (uint32_t)(((uint64_t)rem * sum1) % ADLER_BASE);
+    sum1 += (adler2 & 0xFFFF) + ADLER_BASE - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + ADLER_BASE - rem;
+    if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+    if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+    if (sum2 >= 2 * ADLER_BASE) sum2 -= 2 * ADLER_BASE;
+    if (sum2 >= ADLER_BASE) sum2 -= ADLER_BASE;
+    return sum1 | (sum2 << 16);
+}
+
+static void PutU32BE(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back((uint8_t)(v >> 24));
+    out.push_back((uint8_t)(v >> 16));
+    out.push_back((uint8_t)(v >> 8));
+    out.push_back((uint8_t)v);
+}
+
+static void PutChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size) {
+    PutU32BE(out, (uint32_t)size);
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (size) out.insert(out.end(), data, data + size);
+    PutU32BE(out, Crc32(&out[start], size + 4));
+}
+
+// --- Фильтры строк ---
+
+// Строка RGB с 16 нулевыми байтами слева: байты левее первого пикселя читаются как 0
+static const int ROW_PAD = 16;
+
+static void ConvertRow(const uint32_t* src, int width, uint8_t* dst) {
+    for (int x = 0; x < width; x++) {
+        dst[x * 3 + 0] = ColorR(src[x]);
+        dst[x * 3 + 1] = ColorG(src[x]);
+        dst[x * 3 + 2] = ColorB(src[x]);
+    }
+}
+
+static inline uint8_t Paeth(int a, int b, int c) {
+    int pa = std::abs(b - c);
+    int pb = std::abs(a - c);
+    int pc = std::abs(a + b - 2 * c);
+    if (pa <= pb && pa <= pc) return (uint8_t)a;
+    return (uint8_t)(pb <= pc ? b : c);
+}
+
+// Вес байта для эвристики выбора фильтра: модуль как знакового числа
+static inline uint32_t Cost(uint8_t v) {
+    return (uint32_t)std::abs((int)(int8_t)v);
+}
+
+// Фильтрует строку всеми пятью способами в out[0..4] и возвращает номер лучшего.
+// cur и prev указывают на первый байт строки (слева есть ROW_PAD байт нулей)
+static int FilterRow(const uint8_t* cur, const uint8_t* prev, int n, uint8_t* out[5]) {
+    const int bpp = 3;
+    uint32_t cost[5] = {0, 0, 0, 0, 0};
+    int i = 0;
+
+#ifdef ENGINE_HAS_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i acc[5] = {zero, zero, zero, zero, zero};
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i));
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i - bpp));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i - bpp));
+
+        // avg_epu8 округляет вверх, PNG — вниз
+        __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+
+        // Paeth в 16 битах: pa = |b - c|, pb = |a - c|, pc = |a + b - 2c|
+        __m128i predictor[2];
+        for (int half = 0; half < 2; half++) {
+            __m128i a16 = half ? _mm_unpackhi_epi8(a, zero) : _mm_unpacklo_epi8(a, zero);
+            __m128i b16 = half ? _mm_unpackhi_epi8(b, zero) : _mm_unpacklo_epi8(b, zero);
+            __m128i c16 = half ? _mm_unpackhi_epi8(c, zero) : _mm_unpacklo_epi8(c, zero);
+            __m128i bc = _mm_sub_epi16(b16, c16);
+            __m128i ac = _mm_sub_epi16(a16, c16);
+            __m128i pa = _mm_max_epi16(bc, _mm_sub_epi16(zero, bc));
+            __m128i pb = _mm_max_epi16(ac, _mm_sub_epi16(zero, ac));
+            __m128i abc = _mm_add_epi16(ac, bc);
+            __m128i pc = _mm_max_epi16(abc, _mm_sub_epi16(zero, abc));
+
+            __m128i notA = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+            __m128i notB = _mm_cmpgt_epi16(pb, pc);
+            __m128i bOrC = _mm_or_si128(_mm_andnot_si128(notB, b16), _mm_and_si128(notB, c16));
+            predictor[half] = _mm_or_si128(_mm_andnot_si128(notA, a16), _mm_and_si128(notA, bOrC));
+        }
+        __m128i paeth = _mm_packus_epi16(predictor[0], predictor[1]);
+
+        __m128i filtered[5] = {x, _mm_sub_epi8(x, a), _mm_sub_epi8(x, b), _mm_sub_epi8(x, average), _mm_sub_epi8(x, paeth)};
+        for (int f = 0; f < 5; f++) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out[f] + i), filtered[f]);
+            // |v| знакового байта: min(v, -v) как беззнаковые
+            __m128i absolute = _mm_min_epu8(filtered[f], _mm_sub_epi8(zero, filtered[f]));
+            acc[f] = _mm_add_epi64(acc[f], _mm_sad_epu8(absolute, zero));
+        }
+    }
+
+    for (int f = 0; f < 5; f++) {
+        cost[f] = (uint32_t)(_mm_cvtsi128_si32(acc[f]) + _mm_cvtsi128_si32(_mm_srli_si128(acc[f], 8)));
+    }
+#endif
+
+    for (; i < n; i++) {
+        int x = cur[i], a = cur[i - bpp], b = prev[i], c = prev[i - bpp];
+        out[0][i] = (uint8_t)x;
+        out[1][i] = (uint8_t)(x - a);
+        out[2][i] = (uint8_t)(x - b);
+        out[3][i] = (uint8_t)(x - ((a + b) >> 1));
+        out[4][i] = (uint8_t)(x - Paeth(a, b, c));
+        for (int f = 0; f < 5; f++) cost[f] += Cost(out[f][i]);
+    }
+
+    int best = 0;
+    for (int f = 1; f < 5; f++)
+        if (cost[f] < cost[best]) best = f;
+    return best;
+}
+
+// --- Deflate ---
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    // Биты идут младшими вперёд, как того требует deflate
+    void Put(uint32_t value, int count) {
+        m_bits |= (uint64_t)value << m_count;
+        m_count += count;
+        while (m_count >= 8) {
+            m_out.push_back((uint8_t)m_bits);
+            m_bits >>= 8;
+            m_count -= 8;
+        }
+    }
+
+    void AlignToByte() {
+        if (m_count > 0) m_out.push_back((uint8_t)m_bits);
+        m_bits = 0;
+        m_count = 0;
+    }
+
+private:
+    std::vector<uint8_t>& m_out;
+    uint64_t m_bits = 0;
+    int m_count = 0;
+};
+
+// Фиксированные коды Хаффмана (RFC 1951, 3.2.6), заранее развёрнутые для записи младшими битами вперёд
+struct FixedHuffman {
+    uint16_t litCode[288];
+    uint8_t litBits[288];
+    uint8_t distCode[30];
+
+    static uint32_t Reverse(uint32_t code, int bits) {
+        uint32_t r = 0;
+        for (int i = 0; i < bits; i++) r |= ((code >> i) & 1) << (bits - 1 - i);
+        return r;
+    }
+
+    FixedHuffman() {
+        for (int s = 0; s < 288; s++) {
+            uint32_t code;
+            int bits;
+            if (s < 144) { code = 0x30 + s; bits = 8; }
+            else if (s < 256) { code = 0x190 + (s - 144); bits = 9; }
+            else if (s < 280) { code = s - 256; bits = 7; }
+            else { code = 0xC0 + (s - 280); bits = 8; }
+            litCode[s] = (uint16_t)Reverse(code, bits);
+            litBits[s] = (uint8_t)bits;
+        }
+        for (int d = 0; d < 30; d++) distCode[d] = (uint8_t)Reverse(d, 5);
+    }
+};
+
+static inline int FloorLog2(uint32_t v) {
+    int r = 0;
+    while (v >>= 1) r++;
+    return r;
+}
+
+static void PutLength(BitWriter& bw, const FixedHuffman& huff, int length) {
+    int symbol, extraBits = 0;
+    uint32_t extra = 0;
+    uint32_t x = (uint32_t)(length - 3);
+    if (length == 258) {
+        symbol = 285;
+    } else if (x < 8) {
+        symbol = 257 + (int)x;
+    } else {
+        int nb = FloorLog2(x);
+        symbol = 257 + 4 * (nb - 1) + (int)((x >> (nb - 2)) & 3);
+        extraBits = nb - 2;
+        extra = x & ((1u << extraBits) - 1);
+    }
+    bw.Put(huff.litCode[symbol], huff.litBits[symbol]);
+    if (extraBits) bw.Put(extra, extraBits);
+}
+
+static void PutDistance(BitWriter& bw, const FixedHuffman& huff, int distance) {
+    int symbol, extraBits = 0;
+    uint32_t extra = 0;
+    uint32_t x = (uint32_t)(distance - 1);
+    if (x < 4) {
+        symbol = (int)x;
+    } else {
+        int nb = FloorLog2(x);
+        symbol = 2 * nb + (int)((x >> (nb - 1)) & 1);
+        extraBits = nb - 1;
+        extra = x & ((1u << extraBits) - 1);
+    }
+    bw.Put(huff.distCode[symbol], 5);
+    if (extraBits) bw.Put(extra, extraBits);
+}
+
+static void StoreBlocks(const uint8_t* data, size_t size, bool final, std::vector<uint8_t>& out) {
+    size_t pos = 0;
+    do {
+        size_t len = std::min(size - pos, (size_t)65535);
+        bool last = pos + len == size;
+        out.push_back((final && last) ? 1 : 0);
+        out.push_back((uint8_t)len);
+        out.push_back((uint8_t)(len >> 8));
+        out.push_back((uint8_t)~len);
+        out.push_back((uint8_t)(~len >> 8));
+        out.insert(out.end(), data + pos, data + pos + len);
+        pos += len;
+    } while (pos < size);
+}
+
+static const int WINDOW_SIZE = 32768;
+static const int WINDOW_MASK = WINDOW_SIZE - 1;
+static const int HASH_BITS = 15;
+static const int MAX_CHAIN = 8;   // Глубина поиска: быстрый режим, как низкие уровни zlib
+static const int MIN_MATCH = 3;
+static const int MAX_MATCH = 258;
+static const int MAX_INSERT = 16;
+
+static inline uint32_t Hash3(const uint8_t* p) {
+    uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Сжимает кусок одним блоком с фиксированными кодами. Ссылки не выходят за пределы куска,
+// поэтому куски сжимаются независимо. Несжимаемые данные пишутся stored-блоками
+static void DeflateChunk(const uint8_t* data, size_t size, bool final, std::vector<uint8_t>& out) {
+    static const FixedHuffman huff;
+    size_t start = out.size();
+
+    std::vector<int32_t> head((size_t)1 << HASH_BITS, -1);
+    std::vector<int32_t> chain(WINDOW_SIZE, -1);
+
+    BitWriter bw(out);
+    bw.Put(final ? 1 : 0, 1);
+    bw.Put(1, 2); // BTYPE = 01, фиксированные коды
+
+    const int n = (int)size;
+    auto insert = [&](int pos) {
+        uint32_t h = Hash3(data + pos);
+        chain[pos & WINDOW_MASK] = head[h];
+        head[h] = pos;
+    };
+
+    int i = 0;
+    while (i < n) {
+        int bestLength = 0, bestDistance = 0;
+        if (i + MIN_MATCH <= n) {
+            int limit = std::min(MAX_MATCH, n - i);
+            int candidate = head[Hash3(data + i)];
+            for (int depth = 0; depth < MAX_CHAIN && candidate >= 0 && i - candidate <= WINDOW_SIZE; depth++) {
+                const uint8_t* a = data + candidate;
+                const uint8_t* b = data + i;
+                // Быстрый отказ: кандидат не длиннее лучшего, если не совпадает байт за его концом
+                if (a[bestLength] == b[bestLength]) {
+                    int length = 0;
+                    while (length < limit && a[length] == b[length]) length++;
+                    if (length > bestLength) {
+                        bestLength = length;
+                        bestDistance = i - candidate;
+                        if (length == limit) break;
+                    }
+                }
+                int next = chain[candidate & WINDOW_MASK];
+                // Ячейка цепочки могла быть перезаписана более новой позицией
+                if (next >= candidate) break;
+                candidate = next;
+            }
+            insert(i);
+        }
+
+        if (bestLength >= MIN_MATCH) {
+            PutLength(bw, huff, bestLength);
+            PutDistance(bw, huff, bestDistance);
+            // Длинные совпадения (заливка фона) в словарь не добавляем, как deflate_fast в zlib
+            if (bestLength <= MAX_INSERT) {
+                int end = std::min(i + bestLength, n - MIN_MATCH + 1);
+                for (int k = i + 1; k < end; k++) insert(k);
+            }
+            i += bestLength;
+        } else {
+            bw.Put(huff.litCode[data[i]], huff.litBits[data[i]]);
+            i++;
+        }
+    }
+
+    bw.Put(huff.litCode[256], huff.litBits[256]);
+    if (!final) {
+        // Пустой stored-блок выравнивает поток по байту, и следующий кусок можно просто приписать
+        bw.Put(0, 3);
+        bw.AlignToByte();
+        const uint8_t sync[4] = {0x00, 0x00, 0xFF, 0xFF};
+        out.insert(out.end(), sync, sync + 4);
+    } else {
+        bw.AlignToByte();
+    }
+
+    // Сжатие не помогло (шум): переписываем кусок без сжатия
+    if (out.size() - start > size + size / 65535 * 5 + 5) {
+        out.resize(start);
+        StoreBlocks(data, size, final, out);
+    }
+}
+
+// --- Сборка файла ---
+
+struct PngChunkJob {
+    int firstRow = 0;
+    int lastRow = 0;
+    std::vector<uint8_t> idat;  // Готовый чанк IDAT: длина, тип, данные, CRC
+    uint32_t adler = 1;
+    size_t rawSize = 0;
+};
+
+std::vector<uint8_t> EncodePNG(const uint32_t* pixels, int width, int height, int stride, const PngSettings& settings) {
+    PROFILE_SCOPE("PNG encode");
+    const size_t rowBytes = (size_t)width * 3;
+    const size_t rawSize = (rowBytes + 1) * height;
+    const bool store = settings.mode == PngSettings::Store;
+
+    // Куски не мельче ~256 КБ: меньше не окупает потоки и ухудшает сжатие
+    int threads = settings.threads > 0 ? settings.threads : HardwareThreads();
+    int chunkCount = (int)std::min<size_t>({(size_t)threads, (size_t)height, std::max<size_t>(1, rawSize / (256 * 1024))});
+    if (store) chunkCount = 1;
+
+    std::vector<PngChunkJob> jobs(chunkCount);
+    for (int c = 0; c < chunkCount; c++) {
+        jobs[c].firstRow = (int)((long long)height * c / chunkCount);
+        jobs[c].lastRow = (int)((long long)height * (c + 1) / chunkCount);
+    }
+
+    ParallelFor(0, chunkCount, [&](int first, int last) {
+        // Две строки RGB с нулевой подложкой слева (+16 справа для хвоста SIMD)
+        std::vector<uint8_t> rowA(ROW_PAD + rowBytes + 16, 0), rowB(ROW_PAD + rowBytes + 16, 0);
+        std::vector<uint8_t> candidates(5 * rowBytes + 16);
+
+        for (int c = first; c < last; c++) {
+            PngChunkJob& job = jobs[c];
+            std::vector<uint8_t> raw;
+            raw.reserve((rowBytes + 1) * (job.lastRow - job.firstRow));
+
+            uint8_t* cur = rowA.data() + ROW_PAD;
+            uint8_t* prev = rowB.data() + ROW_PAD;
+            if (job.firstRow > 0 && !store) {
+                ConvertRow(pixels + (size_t)(job.firstRow - 1) * stride, width, prev);
+            } else {
+                std::fill(prev, prev + rowBytes, 0);
+            }
+
+            for (int y = job.firstRow; y < job.lastRow; y++) {
+                ConvertRow(pixels + (size_t)y * stride, width, cur);
+                if (store) {
+                    raw.push_back(0);
+                    raw.insert(raw.end(), cur, cur + rowBytes);
+                } else {
+                    uint8_t* out[5];
+                    for (int f = 0; f < 5; f++) out[f] = candidates.data() + f * rowBytes;
+                    int filter = FilterRow(cur, prev, (int)rowBytes, out);
+                    raw.push_back((uint8_t)filter);
+                    raw.insert(raw.end(), out[filter], out[filter] + rowBytes);
+                }
+                std::swap(cur, prev);
+            }
+
+            job.rawSize = raw.size();
+            job.adler = Adler32(raw.data(), raw.size());
+
+            // Заготовка чанка: место под длину, тип, zlib-заголовок у первого куска, данные
+            std::vector<uint8_t>& idat = job.idat;
+            idat = {0, 0, 0, 0, 'I', 'D', 'A', 'T'};
+            if (c == 0) {
+                idat.push_back(0x78);
+                idat.push_back(store ? 0x01 : 0x5E);
+            }
+            bool final = c == chunkCount - 1;
+            if (store) {
+                StoreBlocks(raw.data(), raw.size(), final, idat);
+            } else {
+                DeflateChunk(raw.data(), raw.size(), final, idat);
+            }
+
+            uint32_t length = (uint32_t)(idat.size() - 8);
+            idat[0] = (uint8_t)(length >> 24);
+            idat[1] = (uint8_t)(length >> 16);
+            idat[2] = (uint8_t)(length >> 8);
+            idat[3] = (uint8_t)length;
+            PutU32BE(idat, Crc32(idat.data() + 4, length + 4));
+        }
+    }, threads);
+
+    std::vector<uint8_t> out = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> ihdr;
+    PutU32BE(ihdr, (uint32_t)width);
+    PutU32BE(ihdr, (uint32_t)height);
+    ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0}); // 8 бит на канал, RGB, deflate, адаптивные фильтры, без чересстрочности
+    PutChunk(out, "IHDR", ihdr.data(), ihdr.size());
+
+    size_t total = out.size();
+    for (const auto& job : jobs) total += job.idat.size();
+    out.reserve(total + 32);
+
+    uint32_t adler = 1;
+    for (const auto& job : jobs) {
+        out.insert(out.end(), job.idat.begin(), job.idat.end());
+        adler = Adler32Combine(adler, job.adler, job.rawSize);
+    }
+
+    // Adler-32 всего потока известна только после всех кусков: отдельный маленький IDAT
+    std::vector<uint8_t> trailer;
+    PutU32BE(trailer, adler);
+    PutChunk(out, "IDAT", trailer.data(), trailer.size());
+    PutChunk(out, "IEND", nullptr, 0);
+    return out;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// Собственный кодировщик PNG для кадров Renderer (8 бит на канал, RGB, без альфы).
+//
+// Compressed: для каждой строки выбирается фильтр (None/Sub/Up/Average/Paeth) с минимальной
+// суммой модулей — на x86 через SSE2. Затем строки режутся на куски, и каждый кусок сжимается
+// независимо (LZ77 + фиксированные коды Хаффмана deflate) в своём потоке. Незавершающие куски
+// заканчиваются пустым stored-блоком для выравнивания по байту, поэтому куски просто склеиваются
+// в один корректный zlib-поток; контрольная сумма Adler-32 собирается из сумм кусков.
+// Каждый кусок уходит в свой IDAT, CRC которого тоже считается в потоке куска.
+//
+// Store: без фильтров и без сжатия, только копирование — самый быстрый вариант для больших серий.
+struct PngSettings {
+    enum Mode { Compressed, Store };
+
+    Mode mode = Compressed;
+    int threads = 0; // Потоков на одно изображение, <= 0 — все ядра
+};
+
+std::vector<uint8_t> EncodePNG(const uint32_t* pixels, int width, int height, int stride,
+                               const PngSettings& settings = PngSettings());
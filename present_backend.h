@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+
+// Прямоугольник кадра в пикселях
+struct PresentRect {
+    int x, y, width, height;
+};
+
+// Куда уходит готовый кадр. Ядро движка рисует только в память,
+// а вывод на экран, запись в файлы и т.п. реализуют бэкенды.
+class PresentBackend {
+public:
+    virtual ~PresentBackend() = default;
+
+    // Память для следующего кадра. Бэкенд может отдать свой буфер (например, отображённый
+    // буфер видеокарты), чтобы Renderer рисовал прямо в него и кадр не приходилось копировать.
+    // nullptr — бэкенду нечего предложить, Renderer рисует в собственный буфер.
+    // stride — пикселей между началами строк. Буфер остаётся за Renderer до следующего Present.
+    // index — постоянный номер буфера (0, 1, ...), по нему Renderer помнит, что в буфере уже лежит:
+    // адрес для этого не годится, драйвер может отображать разные буферы по одному адресу.
+    // Номер действует до смены размера; -1 (по умолчанию) — содержимое буфера неизвестно
+    virtual uint32_t* AcquireTarget(int width, int height, int& stride, int& index) {
+        (void)width;
+        (void)height;
+        (void)stride;
+        (void)index;
+        return nullptr;
+    }
+
+    // pixels — width x height пикселей в формате MakeColor, stride — пикселей между началами строк.
+    // rects — области, изменившиеся с прошлого Present (вне них кадр совпадает с предыдущим);
+    // rects == nullptr — изменился весь кадр. Бэкенд вправе обновить больше, чем просят
+    virtual void Present(const uint32_t* pixels, int width, int height, int stride,
+                         const PresentRect* rects, int rectCount) = 0;
+};
@@ -0,0 +1,175 @@
+#include "profiler.h"
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+// Кольцо событий одного потока. Пишет только владелец; мьютекс нужен лишь на время,
+// пока окно или выгрузка копируют события, и в остальное время не занят
+struct ThreadBuffer {
+    std::mutex mutex;
+    std::vector<ProfileEvent> ring;
+    uint64_t count = 0;
+    int id = 0;
+    std::string name;
+    bool alive = false;
+    int depth = 0;
+};
+
+std::mutex g_registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> g_threads;
+
+// Буферы завершившихся потоков достаются новым, так что пул потоков не плодит кольца
+struct ThreadHolder {
+    ThreadBuffer* buffer = nullptr;
+    ~ThreadHolder() {
+        if (!buffer) return;
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        buffer->alive = false;
+    }
+};
+thread_local ThreadHolder t_holder;
+
+ThreadBuffer& CurrentThread() {
+    if (t_holder.buffer) return *t_holder.buffer;
+
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    ThreadBuffer* buffer = nullptr;
+    for (auto& candidate : g_threads) {
+        if (!candidate->alive) {
+            buffer = candidate.get();
+            break;
+        }
+    }
+    if (!buffer) {
+        g_threads.push_back(std::make_unique<ThreadBuffer>());
+        buffer = g_threads.back().get();
+        buffer->id = (int)g_threads.size() - 1;
+        buffer->ring.resize(Profiler::EVENTS_PER_THREAD);
+    }
+    // Кольцо от завершившегося потока начинается заново: его события не смешиваются с новыми.
+    // Collect читает кольца под g_registryMutex, так что сброс ему не виден наполовину
+    buffer->alive = true;
+    buffer->count = 0;
+    buffer->depth = 0;
+    buffer->name = "thread " + std::to_string(buffer->id);
+    t_holder.buffer = buffer;
+    return *buffer;
+}
+
+const int FRAME_HISTORY = 256;
+std::mutex g_frameMutex;
+int64_t g_frames[FRAME_HISTORY];
+uint64_t g_frameCount = 0;
+
+// Имена — строковые литералы из кода, но кавычки и обратные слэши всё равно экранируем
+void WriteJsonString(FILE* file, const std::string& text) {
+    std::fputc('"', file);
+    for (char c : text) {
+        if (c == '"' || c == '\\') std::fputc('\\', file);
+        std::fputc(c, file);
+    }
+    std::fputc('"', file);
+}
+
+} // namespace
+
+std::atomic<bool> Profiler::enabled{false};
+
+void Profiler::SetEnabled(bool value) {
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+int64_t Profiler::NowNs() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::SetThreadName(const std::string& name) {
+    ThreadBuffer& buffer = CurrentThread();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = name;
+}
+
+void Profiler::BeginFrame() {
+    int64_t now = NowNs();
+    std::lock_guard<std::mutex> lock(g_frameMutex);
+    g_frames[g_frameCount % FRAME_HISTORY] = now;
+    g_frameCount++;
+}
+
+bool Profiler::GetLastFrame(int64_t& start, int64_t& end) {
+    std::lock_guard<std::mutex> lock(g_frameMutex);
+    if (g_frameCount < 2) return false;
+    start = g_frames[(g_frameCount - 2) % FRAME_HISTORY];
+    end = g_frames[(g_frameCount - 1) % FRAME_HISTORY];
+    return true;
+}
+
+std::vector<ProfileThreadEvents> Profiler::Collect(int64_t from, int64_t to) {
+    std::vector<ProfileThreadEvents> result;
+    std::lock_guard<std::mutex> registryLock(g_registryMutex);
+    for (auto& buffer : g_threads) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        ProfileThreadEvents thread;
+        thread.thread = buffer->id;
+        thread.name = buffer->name;
+
+        const uint64_t capacity = buffer->ring.size();
+        uint64_t first = buffer->count > capacity ? buffer->count - capacity : 0;
+        for (uint64_t i = first; i < buffer->count; i++) {
+            const ProfileEvent& event = buffer->ring[i % capacity];
+            if (event.end > from && event.start < to) thread.events.push_back(event);
+        }
+        if (!thread.events.empty()) result.push_back(std::move(thread));
+    }
+    return result;
+}
+
+bool Profiler::WriteChromeTrace(const std::string& filename) {
+    FILE* file = std::fopen(filename.c_str(), "w");
+    if (!file) {
+        std::cerr << "ERROR: Could not write trace " << filename << std::endl;
+        return false;
+    }
+
+    // Формат Trace Event: события "X" с началом и длительностью в микросекундах
+    std::fprintf(file, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (const ProfileThreadEvents& thread : Collect(INT64_MIN, INT64_MAX)) {
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                     first ? "" : ",\n", thread.thread);
+        WriteJsonString(file, thread.name);
+        std::fprintf(file, "}}");
+        first = false;
+
+        for (const ProfileEvent& event : thread.events) {
+            std::fprintf(file, ",\n{\"name\":");
+            WriteJsonString(file, event.name);
+            std::fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                         thread.thread, event.start / 1000.0, (event.end - event.start) / 1000.0);
+        }
+    }
+    std::fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    bool ok = std::fclose(file) == 0;
+    if (!ok) std::cerr << "ERROR: Could not write trace " << filename << std::endl;
+    return ok;
+}
+
+int Profiler::EnterScope() {
+    return CurrentThread().depth++;
+}
+
+void Profiler::LeaveScope(const char* name, int64_t start, int depth) {
+    int64_t end = NowNs();
+    ThreadBuffer& buffer = CurrentThread();
+    buffer.depth = depth;
+
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.ring[buffer.count % buffer.ring.size()] = {name, start, end, depth};
+    buffer.count++;
+}
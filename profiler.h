@@ -0,0 +1,88 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+// Профилировщик стадий кадра на CPU.
+// PROFILE_SCOPE("имя") замеряет время до конца блока и пишет событие в кольцевой буфер своего
+// потока: потоки друг другу не мешают, старые события перезаписываются. Выключенный профилировщик
+// стоит одной проверки флага на блок, а при сборке с ENGINE_PROFILER=0 макрос исчезает совсем.
+// Имя должно жить всё время работы программы (строковый литерал).
+//
+// Собранные события показываются в окне (таймлайн кадра) и выгружаются в формат Chrome trace
+// (chrome://tracing, Perfetto).
+struct ProfileEvent {
+    const char* name;
+    int64_t start; // Наносекунды от запуска профилировщика
+    int64_t end;
+    int depth;     // Вложенность блока в своём потоке
+};
+
+struct ProfileThreadEvents {
+    int thread;
+    std::string name;
+    std::vector<ProfileEvent> events; // По времени окончания
+};
+
+namespace Profiler {
+    // Событий в кольце одного потока
+    const int EVENTS_PER_THREAD = 1 << 15;
+
+    extern std::atomic<bool> enabled;
+    inline bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+    void SetEnabled(bool value);
+
+    int64_t NowNs();
+
+    // Имя текущего потока в таймлайне и в трассе
+    void SetThreadName(const std::string& name);
+
+    // Отметка начала кадра (вызывается из главного цикла)
+    void BeginFrame();
+    // Границы последнего завершённого кадра; false, если кадров ещё не было
+    bool GetLastFrame(int64_t& start, int64_t& end);
+
+    // Копия событий всех потоков, пересекающихся с интервалом [from, to)
+    std::vector<ProfileThreadEvents> Collect(int64_t from, int64_t to);
+
+    // Все накопленные события в формате Chrome trace JSON
+    bool WriteChromeTrace(const std::string& filename);
+
+    // Внутреннее: используется ProfileScope
+    int EnterScope();
+    void LeaveScope(const char* name, int64_t start, int depth);
+}
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : m_name(Profiler::IsEnabled() ? name : nullptr) {
+        if (m_name) {
+            m_depth = Profiler::EnterScope();
+            m_start = Profiler::NowNs();
+        }
+    }
+    ~ProfileScope() {
+        if (m_name) Profiler::LeaveScope(m_name, m_start, m_depth);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* m_name;
+    int64_t m_start = 0;
+    int m_depth = 0;
+};
+
+#ifndef ENGINE_PROFILER
+#define ENGINE_PROFILER 1
+#endif
+
+#if ENGINE_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
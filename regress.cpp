@@ -0,0 +1,761 @@
+// Регрессионные проверки без окна: фиксированный набор сцен и ракурсов.
+//
+// Изображения: каждый ракурс рисуется в обеих раскладках буфера (Linear и Tiled) и сравнивается
+// с эталоном из каталога эталонов. Пиксель считается отличающимся, если хотя бы один канал
+// разошёлся больше допуска; проверка падает, если таких пикселей больше заданной доли.
+// Так любая оптимизация растеризатора или конвейера обязана сохранять картинку.
+// В сборке с ENGINE_ALLOC_TRACKING каждый ракурс рисуется ещё раз, и этот повторный кадр
+// не должен выделять память в куче.
+//
+// Производительность: каждая сцена рисуется серией кадров с вращением, в отчёт идут перцентили
+// времени кадра. С --baseline медиана и p90 сравниваются с сохранённым базовым прогоном той же
+// машины; замедление больше порога — ошибка. Базовый прогон зависит от машины и сборки,
+// поэтому в репозитории не хранится и создаётся локально (--update).
+//
+// Вывод (--present): кадры серии с вращением, сменой цвета очистки и размера отдаются поддельному
+// бэкенду с кольцом буферов, который переносит на «экран» только присланные прямоугольники.
+// Экран после каждого кадра должен совпасть с кадром, нарисованным без бэкенда. Кольцо проверяется
+// с разными адресами буферов, с одним адресом на все буферы (так бывает при отображении PBO
+// заново на каждый кадр) и с буферами без номера.
+//
+// Кластеры (--clusters): в файле .cmsh портятся две страницы, которые запрашиваются первыми
+// (неверное смещение и индекс за пределами вершин). Остальные кластеры всё равно должны
+// догрузиться, а поток — прийти в покой: без недостающих страниц и без повторных загрузок.
+//
+// Чистка сетки (--sanitize): грани с вершинами NaN и inf отбрасываются, остальные сохраняются;
+// огромные координаты при крошечном допуске сварки не ломают пространственный хэш.
+//
+// Ядра SIMD (--kernels): каждый вариант, который поддерживает машина, сравнивается со скалярным
+// на случайных данных. --cpu ограничивает уровень для остальных проверок. Там же проверяется
+// Affine3x4: совпадение с Mat4 и обратное преобразование InverseRigid.
+//
+// Коды выхода: 0 — всё прошло, 1 — регрессия или ошибка, 77 — проверка пропущена
+// (нет базового прогона), так этот код понимает CTest (SKIP_RETURN_CODE).
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <iterator>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+#include "renderer.h"
+#include "mesh.h"
+#include "math_3d.h"
+#include "pipeline.h"
+#include "shapes_generator.h"
+#include "image_io.h"
+#include "alloc_tracker.h"
+#include "cpu_features.h"
+#include "simd_kernels.h"
+#include "fast_math.h"
+#include "cluster_mesh.h"
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+const float PI = 3.14159265f;
+const int EXIT_SKIPPED = 77;
+
+struct RegressOptions {
+    std::string refs = "regress";
+    std::string assets = "assets";
+    std::string baseline;
+    std::string outDir;
+    bool images = false;
+    bool perf = false;
+    bool kernels = false;
+    bool present = false;
+    bool clusters = false;
+    bool sanitize = false;
+    bool update = false;
+    int width = 320;
+    int height = 240;
+    int tolerance = 2;         // Допустимая разница канала
+    double maxBad = 0.001;     // Доля пикселей, которым разрешено выйти за допуск
+    int perfWidth = 1280;
+    int perfHeight = 720;
+    int perfFrames = 60;
+    double threshold = 0.15;   // Допустимое замедление относительно базового прогона
+    double minDelta = 0.25;    // Мс, которые всегда прощаются: шум таймера на лёгких сценах
+};
+
+struct CameraPose {
+    float rotX, rotY, zoom;
+};
+
+struct RegressScene {
+    std::string name;
+    Mesh mesh;
+    std::vector<CameraPose> poses;
+};
+
+static void PrintUsage() {
+    std::cerr <<
+        "Usage: engine_regress [options]\n"
+        "  --images                compare renders against the reference images\n"
+        "  --perf                  measure frame time percentiles (both checks run if neither is given)\n"
+        "  --kernels               check every supported SIMD kernel variant against the scalar one\n"
+        "  --present               check dirty-rect presentation through a ring of backend buffers\n"
+        "  --clusters              check cluster streaming with corrupted pages in the file\n"
+        "  --sanitize              check mesh sanitizing with non-finite and huge vertices\n"
+        "  --cpu <level>           limit SIMD to scalar, sse2, sse4.1, avx2 or avx512\n"
+        "  --math <exact|fast>     sin/cos and 1/sqrt mode for shapes, normals and lighting (default exact)\n"
+        "  --refs <dir>            reference image directory (default regress)\n"
+        "  --assets <dir>          directory with cube.obj and pyramid.obj (default assets)\n"
+        "  --baseline <file>       performance baseline to compare against (JSON)\n"
+        "  --update                rewrite reference images and the baseline instead of comparing\n"
+        "  --out <dir>             write actual and diff images of failed cases here\n"
+        "  --tolerance <n>         allowed per-channel difference (default 2)\n"
+        "  --max-bad <fraction>    allowed fraction of pixels beyond tolerance (default 0.001)\n"
+        "  --frames <n>            frames per scene for the performance run (default 60)\n"
+        "  --perf-size <WxH>       performance run resolution (default 1280x720)\n"
+        "  --threshold <fraction>  allowed slowdown against the baseline (default 0.15)\n"
+        "  --min-delta <ms>        slowdown always tolerated, for very light scenes (default 0.25)\n";
+}
+
+static bool ParseOptions(int argc, char** argv, RegressOptions& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") return false;
+        if (arg == "--images") { opt.images = true; continue; }
+        if (arg == "--perf") { opt.perf = true; continue; }
+        if (arg == "--kernels") { opt.kernels = true; continue; }
+        if (arg == "--present") { opt.present = true; continue; }
+        if (arg == "--clusters") { opt.clusters = true; continue; }
+        if (arg == "--sanitize") { opt.sanitize = true; continue; }
+        if (arg == "--update") { opt.update = true; continue; }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--refs") opt.refs = value;
+        else if (arg == "--assets") opt.assets = value;
+        else if (arg == "--baseline") opt.baseline = value;
+        else if (arg == "--out") opt.outDir = value;
+        else if (arg == "--tolerance") opt.tolerance = std::atoi(value.c_str());
+        else if (arg == "--max-bad") opt.maxBad = std::atof(value.c_str());
+        else if (arg == "--frames") opt.perfFrames = std::atoi(value.c_str());
+        else if (arg == "--threshold") opt.threshold = std::atof(value.c_str());
+        else if (arg == "--min-delta") opt.minDelta = std::atof(value.c_str());
+        else if (arg == "--math") FastMath::SetMode(value == "fast" ? FastMath::Fast : FastMath::Exact);
+        else if (arg == "--cpu") {
+            CpuFeatures::Level level;
+            if (!CpuFeatures::Parse(value, level)) {
+                std::cerr << "Unknown CPU level " << value << std::endl;
+                return false;
+            }
+            if (!CpuFeatures::Force(level)) {
+                std::cerr << "CPU level " << value << " is not supported here" << std::endl;
+                return false;
+            }
+        } else if (arg == "--perf-size") {
+            if (std::sscanf(value.c_str(), "%dx%d", &opt.perfWidth, &opt.perfHeight) != 2) {
+                std::cerr << "Bad --perf-size, expected WxH: " << value << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (!opt.images && !opt.perf && !opt.kernels && !opt.present && !opt.clusters && !opt.sanitize)
+        opt.images = opt.perf = true;
+    if (opt.perfWidth <= 0 || opt.perfHeight <= 0 || opt.perfFrames <= 0) {
+        std::cerr << "Performance size and frame count must be positive" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Набор сцен фиксирован: эталоны и базовые прогоны привязаны к именам и ракурсам
+static bool LoadScenes(const RegressOptions& opt, std::vector<RegressScene>& scenes) {
+    const std::vector<CameraPose> poses = {{0.5f, 0.8f, 5.0f}, {-0.3f, 2.4f, 5.0f}};
+
+    for (const char* name : {"cube", "pyramid"}) {
+        Mesh mesh = Mesh::LoadFromObj((fs::path(opt.assets) / (std::string(name) + ".obj")).string());
+        if (!mesh.validated || mesh.faces.empty()) {
+            std::cerr << "ERROR: Could not load scene " << name << " from " << opt.assets << std::endl;
+            return false;
+        }
+        scenes.push_back({name, std::move(mesh), poses});
+    }
+
+    scenes.push_back({"sphere", ShapesGenerator::SmoothSphere(1.0f, 50, 50), {{0.5f, 0.8f, 3.0f}, {-0.3f, 2.4f, 3.0f}}});
+    scenes.push_back({"torus", ShapesGenerator::SmoothTorus(1.0f, 0.4f, 60, 30), {{0.5f, 0.8f, 3.0f}, {1.2f, 2.4f, 3.0f}}});
+    scenes.push_back({"icosphere", ShapesGenerator::Icosphere(1.0f, 64), {{0.5f, 0.8f, 2.5f}, {-0.3f, 2.4f, 1.6f}}});
+    scenes.push_back({"stress", ShapesGenerator::InstanceField(ShapesGenerator::Icosphere(1.0f, 8), 400, 2.5f, 1),
+                      {{0.3f, 0.4f, 7.0f}, {-0.2f, 2.0f, 3.0f}}});
+    return true;
+}
+
+static void RenderPose(Renderer& renderer, const RegressScene& scene, const CameraPose& pose, const Mat4& matProj) {
+    renderer.Clear(MakeColor(40, 40, 40));
+    RenderFaces(renderer, scene.mesh.vertices, scene.mesh.faces, MakeWorldMatrix(pose.rotX, pose.rotY, pose.zoom), matProj);
+    renderer.Resolve();
+}
+
+// --- Изображения ---
+
+struct ImageDiff {
+    int badPixels = 0;
+    int maxDifference = 0;
+};
+
+static ImageDiff CompareImages(const Renderer& renderer, const std::vector<uint32_t>& reference, int tolerance,
+                               std::vector<uint32_t>* diffImage) {
+    ImageDiff diff;
+    int width = renderer.GetWidth();
+    for (int y = 0; y < renderer.GetHeight(); y++) {
+        const uint32_t* row = renderer.GetPixels() + (size_t)y * renderer.GetStride();
+        for (int x = 0; x < width; x++) {
+            uint32_t a = row[x];
+            uint32_t b = reference[(size_t)y * width + x];
+            int d = std::max({std::abs(ColorR(a) - ColorR(b)), std::abs(ColorG(a) - ColorG(b)),
+                              std::abs(ColorB(a) - ColorB(b))});
+            diff.maxDifference = std::max(diff.maxDifference, d);
+            bool bad = d > tolerance;
+            if (bad) diff.badPixels++;
+
+            // Отличия — красным поверх приглушённого эталона
+            if (diffImage) {
+                (*diffImage)[(size_t)y * width + x] = bad
+                    ? MakeColor(255, 0, 0)
+                    : MakeColor(ColorR(b) / 3, ColorG(b) / 3, ColorB(b) / 3);
+            }
+        }
+    }
+    return diff;
+}
+
+static bool CheckImages(const RegressOptions& opt, const std::vector<RegressScene>& scenes) {
+    if (opt.update) {
+        std::error_code ec;
+        fs::create_directories(opt.refs, ec);
+    }
+    if (!opt.outDir.empty()) {
+        std::error_code ec;
+        fs::create_directories(opt.outDir, ec);
+    }
+
+    Mat4 matProj = MakeProjection(opt.width, opt.height);
+    Renderer linear(opt.width, opt.height, nullptr, Renderer::Linear);
+    Renderer tiled(opt.width, opt.height, nullptr, Renderer::Tiled);
+    const double allowedBad = opt.maxBad * opt.width * opt.height;
+
+    int failed = 0, total = 0;
+    for (const RegressScene& scene : scenes) {
+        for (size_t p = 0; p < scene.poses.size(); p++) {
+            std::string caseName = scene.name + "_" + std::to_string(p);
+            std::string refPath = (fs::path(opt.refs) / (caseName + ".png")).string();
+
+            if (opt.update) {
+                RenderPose(linear, scene, scene.poses[p], matProj);
+                if (!WriteImage(refPath, linear.GetPixels(), opt.width, opt.height, linear.GetStride())) return false;
+                std::cout << "  updated " << refPath << std::endl;
+                continue;
+            }
+
+            std::vector<uint32_t> reference;
+            int refWidth = 0, refHeight = 0;
+            if (!ReadImage(refPath, reference, refWidth, refHeight) ||
+                refWidth != opt.width || refHeight != opt.height) {
+                std::cerr << "  FAIL " << caseName << ": missing or mismatched reference " << refPath << std::endl;
+                failed++;
+                total++;
+                continue;
+            }
+
+            for (Renderer* renderer : {&linear, &tiled}) {
+                const char* layout = renderer->GetLayout() == Renderer::Tiled ? "tiled" : "linear";
+                RenderPose(*renderer, scene, scene.poses[p], matProj);
+
+                std::vector<uint32_t> diffImage;
+                if (!opt.outDir.empty()) diffImage.resize(reference.size());
+                ImageDiff diff = CompareImages(*renderer, reference, opt.tolerance,
+                                               opt.outDir.empty() ? nullptr : &diffImage);
+                bool ok = diff.badPixels <= allowedBad;
+                total++;
+
+                std::printf("  %s %-12s %-6s  bad pixels %6d  max diff %3d", ok ? "ok  " : "FAIL",
+                            caseName.c_str(), layout, diff.badPixels, diff.maxDifference);
+                if (AllocTracker::IsEnabled()) {
+                    // Повторный кадр того же ракурса: все буферы уже есть, куча не нужна
+                    NoAllocScope noAlloc("regress frame", false);
+                    RenderPose(*renderer, scene, scene.poses[p], matProj);
+                    uint64_t allocations = noAlloc.GetCount();
+                    std::printf("  heap allocs %llu", (unsigned long long)allocations);
+                    if (allocations > 0 && ok) {
+                        ok = false;
+                        std::printf("  FAIL");
+                    }
+                }
+                std::printf("\n");
+                if (ok) continue;
+
+                failed++;
+                if (!opt.outDir.empty()) {
+                    std::string prefix = (fs::path(opt.outDir) / (caseName + "_" + layout)).string();
+                    WriteImage(prefix + "_actual.png", renderer->GetPixels(), opt.width, opt.height, renderer->GetStride());
+                    WriteImage(prefix + "_diff.png", diffImage.data(), opt.width, opt.height, opt.width);
+                }
+            }
+        }
+    }
+
+    if (opt.update) return true;
+    std::printf("Images: %d of %d cases passed\n", total - failed, total);
+    return failed == 0;
+}
+
+// --- Вывод через бэкенд ---
+
+// Цвет, которым заполнены новые буферы и экран: на их содержимое рассчитывать нельзя
+const uint32_t GARBAGE_COLOR = 0xFFFF00FF;
+
+// Кольцо из RING_SIZE буферов, «экран» обновляется только в присланных прямоугольниках
+class RingBackend : public PresentBackend {
+public:
+    enum Addressing { Distinct, Shared, Unnumbered };
+    static const int RING_SIZE = 3;
+
+    explicit RingBackend(Addressing addressing) : m_addressing(addressing) {}
+
+    uint32_t* AcquireTarget(int width, int height, int& stride, int& index) override {
+        if (width != m_width || height != m_height) {
+            m_width = width;
+            m_height = height;
+            for (std::vector<uint32_t>& buffer : m_buffers) buffer.assign((size_t)width * height, GARBAGE_COLOR);
+            m_staging.assign((size_t)width * height, GARBAGE_COLOR);
+            m_screen.assign((size_t)width * height, GARBAGE_COLOR);
+        }
+        m_slot = (m_slot + 1) % RING_SIZE;
+        stride = width;
+        index = m_addressing == Unnumbered ? -1 : m_slot;
+        if (m_addressing == Distinct) return m_buffers[m_slot].data();
+
+        // Буфер отображается заново по тому же адресу, содержимое с прошлого раза сохраняется
+        m_staging = m_buffers[m_slot];
+        return m_staging.data();
+    }
+
+    void Present(const uint32_t* pixels, int width, int height, int stride,
+                 const PresentRect* rects, int rectCount) override {
+        PresentRect full = {0, 0, width, height};
+        if (!rects) {
+            rects = &full;
+            rectCount = 1;
+        }
+        for (int r = 0; r < rectCount; r++) {
+            for (int y = rects[r].y; y < rects[r].y + rects[r].height; y++)
+                std::copy_n(pixels + (size_t)y * stride + rects[r].x, rects[r].width,
+                            m_screen.begin() + (size_t)y * width + rects[r].x);
+        }
+        if (m_addressing != Distinct) m_buffers[m_slot] = m_staging;
+    }
+
+    const std::vector<uint32_t>& GetScreen() const { return m_screen; }
+
+private:
+    Addressing m_addressing;
+    std::vector<uint32_t> m_buffers[RING_SIZE];
+    std::vector<uint32_t> m_staging;
+    std::vector<uint32_t> m_screen;
+    int m_width = 0;
+    int m_height = 0;
+    int m_slot = -1;
+};
+
+static bool CheckPresent(const RegressOptions& opt, const std::vector<RegressScene>& scenes) {
+    const int FRAMES = 60;
+    const char* addressingNames[] = {"distinct", "shared", "unnumbered"};
+
+    int failed = 0, total = 0;
+    for (int addressing = RingBackend::Distinct; addressing <= RingBackend::Unnumbered; addressing++) {
+        for (Renderer::Layout layout : {Renderer::Linear, Renderer::Tiled}) {
+            RingBackend backend((RingBackend::Addressing)addressing);
+            Renderer renderer(opt.width, opt.height, &backend, layout);
+            Renderer reference(opt.width, opt.height, nullptr, layout);
+
+            // Треть серии — в уменьшенном размере, одна сцена на треть серии, цвет очистки меняется
+            long long badPixels = 0;
+            int badFrames = 0, presentedTiles = 0, tileCount = 0;
+            for (int frame = 0; frame < FRAMES; frame++) {
+                int phase = frame * 3 / FRAMES;
+                int width = phase == 1 ? opt.width / 2 + 3 : opt.width;
+                int height = phase == 1 ? opt.height / 2 + 5 : opt.height;
+                const RegressScene& scene = scenes[(frame * scenes.size() / FRAMES)];
+                const CameraPose& base = scene.poses[0];
+                CameraPose pose = {base.rotX, base.rotY + 0.05f * frame, base.zoom};
+                uint32_t clearColor = frame % 17 < 12 ? MakeColor(40, 40, 40) : MakeColor(10, 20, 70);
+                Mat4 matProj = MakeProjection(width, height);
+
+                for (Renderer* r : {&renderer, &reference}) {
+                    r->Resize(width, height);
+                    r->Clear(clearColor);
+                    RenderFaces(*r, scene.mesh.vertices, scene.mesh.faces,
+                                MakeWorldMatrix(pose.rotX, pose.rotY, pose.zoom), matProj);
+                }
+                renderer.DrawBuffer();
+                reference.Resolve();
+                presentedTiles += renderer.GetPresentedTiles();
+                tileCount += renderer.GetTileCount();
+
+                int bad = 0;
+                const std::vector<uint32_t>& screen = backend.GetScreen();
+                for (int y = 0; y < height; y++) {
+                    const uint32_t* row = reference.GetPixels() + (size_t)y * reference.GetStride();
+                    for (int x = 0; x < width; x++)
+                        if (screen[(size_t)y * width + x] != row[x]) bad++;
+                }
+                badPixels += bad;
+                if (bad > 0) badFrames++;
+            }
+
+            bool ok = badPixels == 0;
+            total++;
+            if (!ok) failed++;
+            std::printf("  %s %-10s %-6s  bad frames %3d  bad pixels %8lld  presented tiles %5.1f%%\n",
+                        ok ? "ok  " : "FAIL", addressingNames[addressing],
+                        layout == Renderer::Tiled ? "tiled" : "linear", badFrames, badPixels,
+                        100.0 * presentedTiles / tileCount);
+        }
+    }
+    std::printf("Present: %d of %d cases passed\n", total - failed, total);
+    return failed == 0;
+}
+
+// --- Потоковая загрузка кластеров ---
+
+static bool CheckClusters() {
+    std::cout.setstate(std::ios::failbit);
+    Mesh mesh = ShapesGenerator::Icosphere(1.0f, 24);
+    std::string filename = (fs::temp_directory_path() / "engine_regress_clusters.cmsh").string();
+    bool written = ClusterFile::Write(mesh, filename, 256);
+    std::cout.clear();
+    if (!written) return false;
+
+    // Ракурс фиксирован: сфера прямо перед камерой, без поворота
+    const int width = 320, height = 240;
+    const float zoom = 2.5f;
+    Affine3x4 matWorld = Affine3x4::Translate(0.0f, 0.0f, zoom);
+    Mat4 matProj = MakeProjection(width, height);
+
+    std::vector<uint8_t> data;
+    {
+        std::ifstream in(filename, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    ClusterFileHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    ClusterRecord* records = reinterpret_cast<ClusterRecord*>(data.data() + sizeof(header));
+
+    // Пустой кластер сначала просит самый грубый уровень; больше всех на экране — ближайшие
+    std::vector<std::pair<float, uint32_t>> order;
+    for (uint32_t c = 0; c < header.clusterCount; c++) {
+        const ClusterRecord& rec = records[c];
+        Vec3 center = matWorld.TransformPoint(Vec3(rec.center[0], rec.center[1], rec.center[2]));
+        float distance = std::max(std::sqrt(DotProduct(center, center)) - rec.radius, 0.1f);
+        order.push_back({rec.radius / distance, c});
+    }
+    std::sort(order.rbegin(), order.rend());
+    auto coarsest = [](ClusterRecord& rec) -> ClusterLodRecord& {
+        for (int lod = CLUSTER_MAX_LODS - 1; lod > 0; lod--)
+            if (rec.lods[lod].offset != 0) return rec.lods[lod];
+        return rec.lods[0];
+    };
+    coarsest(records[order[0].second]).offset += 2;
+    ClusterLodRecord& broken = coarsest(records[order[1].second]);
+    int32_t badIndex = 0x7FFFFFFF;
+    std::memcpy(data.data() + broken.offset + (size_t)broken.vertexCount * sizeof(Vec3), &badIndex, sizeof(badIndex));
+    {
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
+    }
+
+    ClusterStream stream;
+    std::cout.setstate(std::ios::failbit);
+    bool opened = stream.Open(filename);
+    std::cout.clear();
+    if (!opened) return false;
+
+    int frames = 0;
+    ClusterStream::Stats stats;
+    for (; frames < 100; frames++) {
+        stream.Update(matWorld, matProj, height);
+        stats = stream.GetStats();
+        if (stats.missing == 0 && stats.loaded == 0) break;
+    }
+    stream.Close();
+    std::error_code ec;
+    fs::remove(filename, ec);
+
+    bool ok = stats.missing == 0 && stats.loaded == 0 && stats.failed == 2 && stats.drawn == stats.visible;
+    std::printf("  %s %d clusters, %d visible, %d drawn, %d corrupted, settled after %d frames\n", ok ? "ok  " : "FAIL",
+                stats.clusters, stats.visible, stats.drawn, stats.failed, frames);
+    return ok;
+}
+
+// --- Чистка сетки ---
+
+static bool CheckSanitize() {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+
+    // Квадрат из двух граней и три грани, задевающие испорченные вершины 4 и 5
+    Mesh broken;
+    for (Vec3 v : {Vec3(0, 0, 0), Vec3(1, 0, 0), Vec3(1, 1, 0), Vec3(0, 1, 0), Vec3(nan, 0, 0), Vec3(0, inf, -inf)})
+        broken.vertices.push_back(v);
+    broken.faces = {{{0, 1, 2}}, {{0, 2, 3}}, {{0, 1, 4}}, {{4, 2, 3}}, {{1, 5, 2}}};
+
+    // Координаты порядка 1e30 при допуске 1e-25: номер ячейки далеко за пределами int64_t
+    Mesh huge;
+    for (Vec3 v : {Vec3(0, 0, 0), Vec3(1e30f, 0, 0), Vec3(0, 1e30f, 0), Vec3(-1e30f, -1e30f, 0)})
+        huge.vertices.push_back(v);
+    huge.faces = {{{0, 1, 2}}, {{0, 2, 3}}};
+
+    std::cout.setstate(std::ios::failbit);
+    broken.Sanitize();
+    huge.Sanitize(1e-25f);
+    std::cout.clear();
+
+    bool finite = true;
+    for (const Mesh* mesh : {&broken, &huge})
+        for (const Vec3& v : mesh->vertices)
+            finite = finite && std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+
+    bool ok = finite && broken.validated && broken.faces.size() == 2 && broken.vertices.size() == 4 &&
+              huge.validated && huge.faces.size() == 2 && huge.vertices.size() == 4;
+    std::printf("%-8s %s: %zu of 5 faces kept with non-finite vertices, %zu of 2 with huge coordinates\n", "sanitize",
+                ok ? "ok" : "FAIL", broken.faces.size(), huge.faces.size());
+    return ok;
+}
+
+// --- Производительность ---
+
+struct FrameTimes {
+    std::string scene;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+};
+
+static double Percentile(const std::vector<double>& sorted, double fraction) {
+    size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static FrameTimes MeasureScene(const RegressOptions& opt, Renderer& renderer, const RegressScene& scene) {
+    Mat4 matProj = MakeProjection(opt.perfWidth, opt.perfHeight);
+    CameraPose base = scene.poses[0];
+
+    // Первый кадр — прогрев (выделение памяти, заполнение кэшей), в статистику не идёт
+    std::vector<double> times;
+    for (int frame = -1; frame < opt.perfFrames; frame++) {
+        CameraPose pose = {base.rotX, base.rotY + 2.0f * PI * std::max(frame, 0) / opt.perfFrames, base.zoom};
+        auto start = Clock::now();
+        RenderPose(renderer, scene, pose, matProj);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (frame >= 0) times.push_back(ms);
+    }
+    std::sort(times.begin(), times.end());
+
+    FrameTimes result;
+    result.scene = scene.name;
+    result.p50 = Percentile(times, 0.50);
+    result.p90 = Percentile(times, 0.90);
+    result.p99 = Percentile(times, 0.99);
+    return result;
+}
+
+// Базовый прогон — JSON, одна сцена на строку; читается только то, что пишет WriteBaseline
+static bool WriteBaseline(const std::string& filename, const std::vector<FrameTimes>& results, const RegressOptions& opt) {
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "ERROR: Could not write baseline " << filename << std::endl;
+        return false;
+    }
+    char line[256];
+    std::snprintf(line, sizeof(line), "{\n  \"width\": %d,\n  \"height\": %d,\n  \"frames\": %d,\n  \"scenes\": [\n",
+                  opt.perfWidth, opt.perfHeight, opt.perfFrames);
+    out << line;
+    for (size_t i = 0; i < results.size(); i++) {
+        std::snprintf(line, sizeof(line), "    {\"scene\": \"%s\", \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f}%s\n",
+                      results[i].scene.c_str(), results[i].p50, results[i].p90, results[i].p99,
+                      i + 1 < results.size() ? "," : "");
+        out << line;
+    }
+    out << "  ]\n}\n";
+    return (bool)out;
+}
+
+static bool ReadBaseline(const std::string& filename, std::vector<FrameTimes>& results, int& width, int& height) {
+    std::ifstream in(filename);
+    if (!in.is_open()) return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        char scene[64];
+        FrameTimes times;
+        if (std::sscanf(line.c_str(), " {\"scene\": \"%63[^\"]\", \"p50\": %lf, \"p90\": %lf, \"p99\": %lf",
+                        scene, &times.p50, &times.p90, &times.p99) == 4) {
+            times.scene = scene;
+            results.push_back(times);
+        }
+        std::sscanf(line.c_str(), " \"width\": %d", &width);
+        std::sscanf(line.c_str(), " \"height\": %d", &height);
+    }
+    return !results.empty();
+}
+
+// Возвращает EXIT_SUCCESS, EXIT_FAILURE или EXIT_SKIPPED
+static int CheckPerformance(const RegressOptions& opt, const std::vector<RegressScene>& scenes) {
+#ifndef NDEBUG
+    std::cerr << "WARNING: engine_regress built without optimizations, frame times are not representative" << std::endl;
+#endif
+    // Без базового прогона сравнивать не с чем: не тратим время на замеры
+    std::vector<FrameTimes> baseline;
+    int baseWidth = 0, baseHeight = 0;
+    bool compare = !opt.baseline.empty() && !opt.update;
+    if (compare && !ReadBaseline(opt.baseline, baseline, baseWidth, baseHeight)) {
+        std::cout << "Performance: no baseline at " << opt.baseline << ", comparison skipped (create one with --update)" << std::endl;
+        return EXIT_SKIPPED;
+    }
+    if (compare && (baseWidth != opt.perfWidth || baseHeight != opt.perfHeight)) {
+        std::cerr << "ERROR: Baseline was recorded at " << baseWidth << "x" << baseHeight << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Renderer renderer(opt.perfWidth, opt.perfHeight);
+    std::vector<FrameTimes> results;
+    std::printf("Frame times at %dx%d over %d frames (ms):\n", opt.perfWidth, opt.perfHeight, opt.perfFrames);
+    for (const RegressScene& scene : scenes) {
+        results.push_back(MeasureScene(opt, renderer, scene));
+        const FrameTimes& r = results.back();
+        std::printf("  %-12s p50 %8.3f  p90 %8.3f  p99 %8.3f\n", r.scene.c_str(), r.p50, r.p90, r.p99);
+    }
+
+    if (opt.baseline.empty()) return EXIT_SUCCESS;
+    if (opt.update) {
+        if (!WriteBaseline(opt.baseline, results, opt)) return EXIT_FAILURE;
+        std::cout << "  updated " << opt.baseline << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Медиана ловит общее замедление, p90 — рост редких тяжёлых кадров
+    int regressions = 0;
+    for (const FrameTimes& r : results) {
+        auto it = std::find_if(baseline.begin(), baseline.end(), [&](const FrameTimes& b) { return b.scene == r.scene; });
+        if (it == baseline.end()) {
+            std::printf("  %-12s not in baseline\n", r.scene.c_str());
+            continue;
+        }
+        double ratio50 = r.p50 / it->p50;
+        double ratio90 = r.p90 / it->p90;
+        bool ok = r.p50 <= it->p50 * (1.0 + opt.threshold) + opt.minDelta &&
+                  r.p90 <= it->p90 * (1.0 + opt.threshold) + opt.minDelta;
+        if (!ok) regressions++;
+        std::printf("  %s %-12s p50 %+6.1f%%  p90 %+6.1f%%\n", ok ? "ok  " : "SLOW", r.scene.c_str(),
+                    (ratio50 - 1.0) * 100.0, (ratio90 - 1.0) * 100.0);
+    }
+    std::printf("Performance: %d regressions over %.0f%%\n", regressions, opt.threshold * 100.0);
+    return regressions == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Все уровни до обнаруженного включительно, независимо от --cpu
+static bool CheckKernels() {
+    int failures = 0;
+    for (int i = CpuFeatures::Scalar; i <= CpuFeatures::Detected(); i++) {
+        CpuFeatures::Level level = (CpuFeatures::Level)i;
+        std::string error;
+        bool ok = ValidateKernels(level, error);
+        std::printf("%-8s %s%s%s\n", CpuFeatures::Name(level), ok ? "ok" : "FAIL", ok ? "" : ": ", error.c_str());
+        if (!ok) failures++;
+    }
+    std::printf("Kernels: %d failed, detected %s, active %s\n", failures, CpuFeatures::Name(CpuFeatures::Detected()),
+                CpuFeatures::Name(CpuFeatures::Active()));
+    return failures == 0;
+}
+
+// Случайные повороты с переносом: A * A.InverseRigid() должно давать единичную матрицу, а точки,
+// произведение и ToMat4 — побитно совпадать с тем же преобразованием в Mat4
+static bool CheckAffine() {
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> angle(-PI, PI);
+    std::uniform_real_distribution<float> offset(-50.0f, 50.0f);
+
+    float maxError = 0.0f;
+    int mismatches = 0;
+    for (int i = 0; i < 1000; i++) {
+        float ax = angle(rng), ay = angle(rng), az = angle(rng);
+        float tx = offset(rng), ty = offset(rng), tz = offset(rng);
+        Affine3x4 a = Affine3x4::Translate(tx, ty, tz) * (Affine3x4::RotateZ(az) * (Affine3x4::RotateY(ay) * Affine3x4::RotateX(ax)));
+        Mat4 m = Mat4::Translate(tx, ty, tz) * (Mat4::RotateZ(az) * (Mat4::RotateY(ay) * Mat4::RotateX(ax)));
+
+        // Погрешность переноса растёт с его длиной: сравниваем относительно 1 + |t|
+        Affine3x4 identity = a * a.InverseRigid();
+        float scale = 1.0f + std::sqrt(tx * tx + ty * ty + tz * tz);
+        for (int r = 0; r < 3; r++)
+            for (int c = 0; c < 4; c++)
+                maxError = std::max(maxError, std::abs(identity.m[r][c] - (r == c ? 1.0f : 0.0f)) / scale);
+
+        Mat4 converted = a.ToMat4();
+        if (std::memcmp(converted.m, m.m, sizeof(m.m)) != 0) mismatches++;
+        Vec3 p(offset(rng), offset(rng), offset(rng));
+        Vec3 pa = a.TransformPoint(p);
+        Vec3 pm = MultiplyMatrixVector(p, m);
+        if (pa.x != pm.x || pa.y != pm.y || pa.z != pm.z) mismatches++;
+    }
+
+    bool ok = maxError <= 1e-6f && mismatches == 0;
+    std::printf("%-8s %s: inverse error %.2e, %d mismatches against Mat4\n", "affine", ok ? "ok" : "FAIL", maxError,
+                mismatches);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    RegressOptions opt;
+    if (!ParseOptions(argc, argv, opt)) {
+        PrintUsage();
+        return 1;
+    }
+
+    bool failed = false;
+    if (opt.kernels) {
+        if (!CheckKernels()) failed = true;
+        if (!CheckAffine()) failed = true;
+    }
+    if (opt.clusters && !CheckClusters()) failed = true;
+    if (opt.sanitize && !CheckSanitize()) failed = true;
+    if (!opt.images && !opt.perf && !opt.present) return failed ? 1 : 0;
+
+    // Загрузчик пишет о каждом файле в std::cout; в отчёте проверок это лишнее
+    std::cout.setstate(std::ios::failbit);
+    std::vector<RegressScene> scenes;
+    bool loaded = LoadScenes(opt, scenes);
+    std::cout.clear();
+    if (!loaded) return 1;
+
+    bool skipped = false;
+    if (opt.images && !CheckImages(opt, scenes)) failed = true;
+    if (opt.present && !CheckPresent(opt, scenes)) failed = true;
+    if (opt.perf) {
+        int status = CheckPerformance(opt, scenes);
+        if (status == EXIT_FAILURE) failed = true;
+        if (status == EXIT_SKIPPED) skipped = true;
+    }
+
+    if (failed) return 1;
+    return skipped ? EXIT_SKIPPED : 0;
+}
@@ -1,29 +1,14 @@
 #include "renderer.h"
+#include "present_backend.h"
+#include "profiler.h"
+#include "simd_kernels.h"
 #include <iostream>
 #include <algorithm>
 
-// Простейшие шейдеры. Вершинный просто передает координаты, 
-// Фрагментный берет цвет из нашей текстуры.
-const char* vertexShaderSource = R"(
-    #version 330 core
-    layout (location = 0) in vec2 aPos;
-    layout (location = 1) in vec2 aTexCoord;
-    out vec2 TexCoord;
-    void main() {
-        gl_Position = vec4(aPos, 0.0, 1.0);
-        TexCoord = aTexCoord;
-    }
-)";
-
-const char* fragmentShaderSource = R"(
-    #version 330 core
-    out vec4 FragColor;
-    in vec2 TexCoord;
-    uniform sampler2D screenTexture;
-    void main() {
-        FragColor = texture(screenTexture, TexCoord);
-    }
-)";
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINE_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
 
 // Вспомогательная функция: Edge Function
 // Если результат >= 0, точка P находится справа от вектора AB
@@ -31,67 +16,481 @@ static int EdgeFunction(int x0, int y0, int x1, int y1, int px, int py) {
     return (px - x0) * (y1 - y0) - (py - y0) * (x1 - x0);
 }
 
+RenderStats& RenderStats::operator+=(const RenderStats& other) {
+    verticesTransformed += other.verticesTransformed;
+    facesSubmitted += other.facesSubmitted;
+    facesBackCulled += other.facesBackCulled;
+    facesFrustumCulled += other.facesFrustumCulled;
+    trianglesClipped += other.trianglesClipped;
+    trianglesRasterized += other.trianglesRasterized;
+    pixelsTested += other.pixelsTested;
+    pixelsWritten += other.pixelsWritten;
+    return *this;
+}
+
+// Палитра перерисовки: 1 — синий, 2 — бирюзовый, 3 — зелёный, 4 — жёлтый, 6 — оранжевый,
+// 8 — красный, от 16 — белый; между опорными точками цвета смешиваются
+static const struct OverdrawPalette {
+    uint32_t colors[256];
+
+    OverdrawPalette() {
+        struct Stop { int count; uint8_t r, g, b; };
+        static const Stop stops[] = {
+            {0, 0, 0, 0}, {1, 0, 0, 160}, {2, 0, 160, 160}, {3, 0, 200, 0}, {4, 230, 230, 0},
+            {6, 255, 128, 0}, {8, 255, 0, 0}, {16, 255, 255, 255}, {255, 255, 255, 255}};
+        int s = 0;
+        for (int i = 0; i < 256; i++) {
+            while (stops[s + 1].count < i) s++;
+            const Stop& a = stops[s];
+            const Stop& b = stops[s + 1];
+            float t = (float)(i - a.count) / (b.count - a.count);
+            colors[i] = MakeColor((uint8_t)(a.r + (b.r - a.r) * t), (uint8_t)(a.g + (b.g - a.g) * t),
+                                  (uint8_t)(a.b + (b.b - a.b) * t));
+        }
+    }
+} g_overdrawPalette;
+
 void Renderer::DrawTriangle(int x0, int y0, int x1, int y1, int x2, int y2, uint32_t color) {
     // 1. Находим ограничивающий прямоугольник (Bounding Box)
     int minX = std::min({x0, x1, x2});
     int minY = std::min({y0, y1, y2});
     int maxX = std::max({x0, x1, x2});
     int maxY = std::max({y0, y1, y2});
+    bool clipped = minX < 0 || minY < 0 || maxX >= m_width || maxY >= m_height;
 
     // Обрезаем по краям экрана (Clipping)
     minX = std::max(minX, 0);
     minY = std::max(minY, 0);
     maxX = std::min(maxX, m_width - 1);
     maxY = std::min(maxY, m_height - 1);
+    if (minX > maxX || minY > maxY) return;
+
+    m_stats.trianglesClipped += clipped;
+    m_stats.trianglesRasterized++;
+    m_stats.pixelsTested += (uint64_t)(maxX - minX + 1) * (maxY - minY + 1);
+
+    // Тайлы помечаются по ограничивающему прямоугольнику: с запасом, но один раз на треугольник
+    MarkTiles(minX, minY, maxX, maxY);
+
+    if (m_frameViewMode == Overdraw) {
+        DrawTriangleOverdraw(x0, y0, x1, y1, x2, y2, minX, minY, maxX, maxY);
+        return;
+    }
+    uint64_t written = 0;
+
+    // Строка обходится ядром rasterSpan: рёберные функции считаются один раз в начале строки,
+    // дальше к ним прибавляется шаг по x
+    const SimdKernels& kernels = GetKernels();
+    const int d0 = y2 - y1;
+    const int d1 = y0 - y2;
+    const int d2 = y1 - y0;
+
+    if (m_layout == Tiled) {
+        // Обход по блокам 8x8: пока идём по блоку, пишем в одни и те же 4 кэш-линии
+        const int blockPixels = RENDER_BLOCK_SIZE * RENDER_BLOCK_SIZE;
+        for (int by = minY >> RENDER_BLOCK_SHIFT; by <= (maxY >> RENDER_BLOCK_SHIFT); by++) {
+            int yStart = std::max(minY, by << RENDER_BLOCK_SHIFT);
+            int yEnd = std::min(maxY, ((by + 1) << RENDER_BLOCK_SHIFT) - 1);
+            for (int bx = minX >> RENDER_BLOCK_SHIFT; bx <= (maxX >> RENDER_BLOCK_SHIFT); bx++) {
+                int xStart = std::max(minX, bx << RENDER_BLOCK_SHIFT);
+                int xEnd = std::min(maxX, ((bx + 1) << RENDER_BLOCK_SHIFT) - 1);
+                uint32_t* block = m_surface + ((size_t)by * m_blocksX + bx) * blockPixels;
 
-    // 2. Пробегаем по всем пикселям прямоугольника
+                for (int y = yStart; y <= yEnd; y++) {
+                    uint32_t* row = block + ((y & (RENDER_BLOCK_SIZE - 1)) << RENDER_BLOCK_SHIFT);
+                    written += kernels.rasterSpan(row + (xStart & (RENDER_BLOCK_SIZE - 1)), xEnd - xStart + 1,
+                                                  EdgeFunction(x1, y1, x2, y2, xStart, y),
+                                                  EdgeFunction(x2, y2, x0, y0, xStart, y),
+                                                  EdgeFunction(x0, y0, x1, y1, xStart, y), d0, d1, d2, color);
+                }
+            }
+        }
+        m_stats.pixelsWritten += written;
+        return;
+    }
+
+    // 2. Пробегаем по всем строкам прямоугольника
+    // 3. Пиксель пишется, если он "справа" от всех трех сторон треугольника
+    for (int y = minY; y <= maxY; y++) {
+        uint32_t* row = m_surface + (size_t)y * m_surfaceStride;
+        written += kernels.rasterSpan(row + minX, maxX - minX + 1, EdgeFunction(x1, y1, x2, y2, minX, y),
+                                      EdgeFunction(x2, y2, x0, y0, minX, y), EdgeFunction(x0, y0, x1, y1, minX, y),
+                                      d0, d1, d2, color);
+    }
+    m_stats.pixelsWritten += written;
+}
+
+// Отладочный проход без оптимизаций раскладки: скорость здесь не важна
+void Renderer::DrawTriangleOverdraw(int x0, int y0, int x1, int y1, int x2, int y2,
+                                    int minX, int minY, int maxX, int maxY) {
     for (int y = minY; y <= maxY; y++) {
         for (int x = minX; x <= maxX; x++) {
-            // 3. Проверяем, лежит ли пиксель внутри треугольника
-            // Пиксель должен быть "справа" от всех трех сторон треугольника
             int w0 = EdgeFunction(x1, y1, x2, y2, x, y);
             int w1 = EdgeFunction(x2, y2, x0, y0, x, y);
             int w2 = EdgeFunction(x0, y0, x1, y1, x, y);
+            if (w0 >= 0 && w1 >= 0 && w2 >= 0) WriteOverdraw(x, y);
+        }
+    }
+}
 
-            if (w0 >= 0 && w1 >= 0 && w2 >= 0) {
-                PutPixel(x, y, color);
-            }
+void Renderer::WriteOverdraw(int x, int y) {
+    uint8_t& count = m_overdraw[(size_t)y * m_width + x];
+    if (count < 255) count++;
+    m_surface[SurfaceIndex(x, y)] = g_overdrawPalette.colors[count];
+    m_stats.pixelsWritten++;
+}
+
+size_t Renderer::SurfaceIndex(int x, int y) const {
+    if (m_layout == Tiled) {
+        size_t block = (size_t)(y >> RENDER_BLOCK_SHIFT) * m_blocksX + (x >> RENDER_BLOCK_SHIFT);
+        return block * (RENDER_BLOCK_SIZE * RENDER_BLOCK_SIZE) +
+               ((y & (RENDER_BLOCK_SIZE - 1)) << RENDER_BLOCK_SHIFT) + (x & (RENDER_BLOCK_SIZE - 1));
+    }
+    return (size_t)y * m_surfaceStride + x;
+}
+
+Renderer::Renderer(int width, int height, PresentBackend* backend, Layout layout)
+    : m_width(0), m_height(0), m_backend(backend), m_layout(layout) {
+    Resize(width, height);
+}
+
+void Renderer::Resize(int width, int height) {
+    if (width == m_width && height == m_height) return;
+    m_width = width;
+    m_height = height;
+    m_tilesX = (width + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    m_tilesY = (height + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+
+    // Вся история тайлов относится к старому размеру
+    m_targets.clear();
+    m_buffer.clear();
+    m_presentedDirty.assign((size_t)m_tilesX * m_tilesY, 0);
+    m_presentedKnown = false;
+    m_pending.assign((size_t)m_tilesX * m_tilesY, 0);
+    m_pendingCount = 0;
+    m_overdraw.clear();
+    m_frameViewMode = Shaded;
+
+    if (m_layout == Tiled) {
+        // Буфер дополняется до целых блоков, чтобы блок всегда был полным
+        m_blocksX = (width + RENDER_BLOCK_SIZE - 1) / RENDER_BLOCK_SIZE;
+        m_blocksY = (height + RENDER_BLOCK_SIZE - 1) / RENDER_BLOCK_SIZE;
+        m_tiled.resize((size_t)m_blocksX * m_blocksY * RENDER_BLOCK_SIZE * RENDER_BLOCK_SIZE);
+        m_tiledState.dirty.assign((size_t)m_tilesX * m_tilesY, 0);
+        m_tiledState.known = false;
+        m_surface = m_tiled.data();
+        m_surfaceState = &m_tiledState;
+        m_dirty = m_tiledState.dirty.data();
+    }
+    AcquireTarget();
+}
+
+// Шаг строки своего буфера: кратен кэш-линии (16 пикселей), чтобы каждая строка начиналась с её
+// границы, и не кратен 4 КБ — иначе соседние строки попадают в одни и те же наборы кэша
+static int RowStride(int width) {
+    const int linePixels = (int)(MEMORY_ALIGNMENT / sizeof(uint32_t));
+    int stride = (width + linePixels - 1) / linePixels * linePixels;
+    if (stride % 1024 == 0) stride += linePixels;
+    return stride;
+}
+
+void Renderer::AcquireTarget() {
+    int stride = 0;
+    int index = -1;
+    uint32_t* target = m_backend ? m_backend->AcquireTarget(m_width, m_height, stride, index) : nullptr;
+    if (target) {
+        m_pixels = target;
+        m_stride = stride;
+    } else {
+        m_stride = RowStride(m_width);
+        m_buffer.resize((size_t)m_stride * m_height);
+        m_pixels = m_buffer.data();
+        index = OWN_BUFFER;
+    }
+
+    // Бэкенд обычно крутит 2-3 буфера по кругу. История ищется по номеру буфера, а не по адресу;
+    // буфер без номера всякий раз считается новым, с неизвестным содержимым
+    m_target = -1;
+    for (int i = 0; i < (int)m_targets.size() && index != -1; i++)
+        if (m_targets[i].index == index) m_target = i;
+    if (m_target < 0) {
+        if (m_targets.size() >= 8) m_targets.clear();
+        TargetState state;
+        state.index = index;
+        state.dirty.assign((size_t)m_tilesX * m_tilesY, 0);
+        m_targets.push_back(std::move(state));
+        m_target = (int)m_targets.size() - 1;
+    }
+    if (m_layout == Linear) {
+        m_surface = m_pixels;
+        m_surfaceStride = m_stride;
+        m_surfaceState = &m_targets[m_target];
+        m_dirty = m_surfaceState->dirty.data();
+    }
+    // Плиточную поверхность нужно заново переписать уже в новый буфер
+    m_surfaceChanged = true;
+}
+
+void Renderer::SetBackend(PresentBackend* backend) {
+    // Отложенная очистка относится к старому буферу
+    Resolve();
+    m_backend = backend;
+    m_targets.clear();
+    m_presentedKnown = false;
+    AcquireTarget();
+}
+
+void Renderer::MarkTiles(int minX, int minY, int maxX, int maxY) {
+    m_surfaceChanged = true;
+    for (int ty = minY >> RENDER_TILE_SHIFT; ty <= (maxY >> RENDER_TILE_SHIFT); ty++) {
+        int rowStart = ty * m_tilesX;
+        for (int tx = minX >> RENDER_TILE_SHIFT; tx <= (maxX >> RENDER_TILE_SHIFT); tx++) {
+            if (!m_dirty[rowStart + tx]) TouchTile(rowStart + tx);
         }
     }
 }
 
-Renderer::Renderer(int width, int height) : m_width(width), m_height(height) {
-    m_buffer.resize(width * height); 
-    InitOpenGL();
+// Первое касание тайла в кадре: отложенная заливка делается сейчас, обычными записями,
+// потому что сразу за ней в тайл будут рисовать
+void Renderer::TouchTile(int tile) {
+    if (m_pending[tile]) {
+        FillTile(tile % m_tilesX, tile / m_tilesX, m_pendingColor, false);
+        m_pending[tile] = 0;
+        m_pendingCount--;
+        m_touchClearedTiles++;
+    }
+    if (m_frameViewMode == Overdraw) {
+        // Счётчики перерисовки обнуляются так же лениво, как заливается тайл
+        int x0 = (tile % m_tilesX) * RENDER_TILE_SIZE;
+        int y0 = (tile / m_tilesX) * RENDER_TILE_SIZE;
+        int x1 = std::min(x0 + RENDER_TILE_SIZE, m_width);
+        int y1 = std::min(y0 + RENDER_TILE_SIZE, m_height);
+        for (int y = y0; y < y1; y++) {
+            std::fill(&m_overdraw[(size_t)y * m_width + x0], &m_overdraw[(size_t)y * m_width + x1], (uint8_t)0);
+        }
+    }
+    m_dirty[tile] = 1;
 }
 
-Renderer::~Renderer() {
-    glDeleteVertexArrays(1, &m_VAO);
-    glDeleteBuffers(1, &m_VBO);
-    glDeleteTextures(1, &m_textureID);
-    glDeleteProgram(m_shaderProgram);
+// Заливка тайла поверхности: обычными записями (тайл сейчас будут рисовать) или потоковыми.
+// В плиточной раскладке тайл 32x32 — это 4 строки по 4 блока, и блоки одной строки лежат
+// в памяти подряд: тайл заливается четырьмя непрерывными участками
+void Renderer::FillTile(int tx, int ty, uint32_t color, bool stream) {
+    if (m_layout == Tiled) {
+        const int blocksPerTile = RENDER_TILE_SIZE / RENDER_BLOCK_SIZE;
+        const int blockPixels = RENDER_BLOCK_SIZE * RENDER_BLOCK_SIZE;
+        int bx0 = tx * blocksPerTile;
+        int bx1 = std::min(bx0 + blocksPerTile, m_blocksX);
+        int by1 = std::min((ty + 1) * blocksPerTile, m_blocksY);
+        for (int by = ty * blocksPerTile; by < by1; by++) {
+            uint32_t* start = m_surface + ((size_t)by * m_blocksX + bx0) * blockPixels;
+            uint32_t* end = start + (size_t)(bx1 - bx0) * blockPixels;
+            if (stream) GetKernels().streamFill(start, end, color);
+            else std::fill(start, end, color);
+        }
+        return;
+    }
+
+    int x0 = tx * RENDER_TILE_SIZE;
+    int y0 = ty * RENDER_TILE_SIZE;
+    int x1 = std::min(x0 + RENDER_TILE_SIZE, m_width);
+    int y1 = std::min(y0 + RENDER_TILE_SIZE, m_height);
+    for (int y = y0; y < y1; y++) {
+        uint32_t* row = m_surface + (size_t)y * m_surfaceStride;
+        if (stream) GetKernels().streamFill(row + x0, row + x1, color);
+        else std::fill(row + x0, row + x1, color);
+    }
+}
+
+// Перевод тайла из блоков 8x8 в строки буфера кадра. Строка блока — ровно два 16-байтных слова;
+// запись потоковая, если позволяет выравнивание строки в буфере кадра
+void Renderer::CopyTileToTarget(int tx, int ty) {
+    const int blocksPerTile = RENDER_TILE_SIZE / RENDER_BLOCK_SIZE;
+    const int blockPixels = RENDER_BLOCK_SIZE * RENDER_BLOCK_SIZE;
+    int bx0 = tx * blocksPerTile;
+    int bx1 = std::min(bx0 + blocksPerTile, m_blocksX);
+    int y0 = ty * RENDER_TILE_SIZE;
+    int y1 = std::min(y0 + RENDER_TILE_SIZE, m_height);
+
+    for (int y = y0; y < y1; y++) {
+        const uint32_t* src = m_surface + ((size_t)(y >> RENDER_BLOCK_SHIFT) * m_blocksX + bx0) * blockPixels +
+                              ((y & (RENDER_BLOCK_SIZE - 1)) << RENDER_BLOCK_SHIFT);
+        uint32_t* dst = m_pixels + (size_t)y * m_stride + bx0 * RENDER_BLOCK_SIZE;
+        for (int bx = bx0; bx < bx1; bx++, src += blockPixels, dst += RENDER_BLOCK_SIZE) {
+            int count = std::min(RENDER_BLOCK_SIZE, m_width - bx * RENDER_BLOCK_SIZE);
+#ifdef ENGINE_HAS_SSE2
+            if (count == RENDER_BLOCK_SIZE) {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4));
+                if ((reinterpret_cast<uintptr_t>(dst) & 15) == 0) {
+                    _mm_stream_si128(reinterpret_cast<__m128i*>(dst), a);
+                    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 4), b);
+                } else {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), a);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4), b);
+                }
+                continue;
+            }
+#endif
+            std::copy(src, src + count, dst);
+        }
+    }
 }
 
 void Renderer::Clear(uint32_t color) {
-    std::fill(m_buffer.begin(), m_buffer.end(), color);
+    TargetState& target = *m_surfaceState;
+    const int tileCount = m_tilesX * m_tilesY;
+
+    // Вне грязных тайлов буфер и так залит этим цветом; неизвестный буфер — заливаем весь.
+    // Ещё не выполненная заливка прошлого Clear того же цвета сохраняется
+    bool keep = target.known && target.clearColor == color;
+    m_pendingCount = 0;
+    for (int i = 0; i < tileCount; i++) {
+        m_pending[i] = (!keep || target.dirty[i] || m_pending[i]) ? 1 : 0;
+        m_pendingCount += m_pending[i];
+    }
+    m_pendingColor = color;
+    m_touchClearedTiles = 0;
+    m_resolvedTiles = 0;
+    m_stats = RenderStats();
+    m_arena.Reset();
+
+    m_frameViewMode = m_viewMode;
+    if (m_frameViewMode == Overdraw) m_overdraw.resize((size_t)m_width * m_height);
+
+    std::fill(target.dirty.begin(), target.dirty.end(), (uint8_t)0);
+    target.clearColor = color;
+    target.known = true;
+    m_surfaceChanged = true;
+}
+
+void Renderer::Resolve() {
+    const int tileCount = m_tilesX * m_tilesY;
+    if (m_layout == Linear && m_pendingCount == 0) return;
+    if (m_layout == Tiled && !m_surfaceChanged) return;
+    PROFILE_SCOPE("Resolve");
+
+    for (int i = 0; m_pendingCount > 0 && i < tileCount; i++) {
+        if (!m_pending[i]) continue;
+        FillTile(i % m_tilesX, i / m_tilesX, m_pendingColor, true);
+        m_pending[i] = 0;
+        m_pendingCount--;
+        m_resolvedTiles++;
+    }
+
+    if (m_layout == Tiled) {
+        // В буфер кадра переписываются тайлы, где отличается поверхность или он сам
+        // (грязный с прошлого раза). Тайлы, где поверхность чистая, просто заливаются цветом
+        TargetState& target = m_targets[m_target];
+        bool all = !target.known || !m_tiledState.known || target.clearColor != m_tiledState.clearColor;
+        const SimdKernels& kernels = GetKernels();
+        for (int i = 0; i < tileCount; i++) {
+            int tx = i % m_tilesX;
+            int ty = i / m_tilesX;
+            if (m_tiledState.dirty[i] || !m_tiledState.known) {
+                CopyTileToTarget(tx, ty);
+            } else if (all || target.dirty[i]) {
+                int x0 = tx * RENDER_TILE_SIZE;
+                int x1 = std::min(x0 + RENDER_TILE_SIZE, m_width);
+                for (int y = ty * RENDER_TILE_SIZE; y < std::min((ty + 1) * RENDER_TILE_SIZE, m_height); y++) {
+                    uint32_t* row = m_pixels + (size_t)y * m_stride;
+                    kernels.streamFill(row + x0, row + x1, m_tiledState.clearColor);
+                }
+            }
+        }
+        target.dirty = m_tiledState.dirty;
+        target.clearColor = m_tiledState.clearColor;
+        target.known = m_tiledState.known;
+        m_surfaceChanged = false;
+    }
+#ifdef ENGINE_HAS_SSE2
+    // Потоковые записи должны стать видимы до того, как кадр прочитают (другой поток или GPU)
+    _mm_sfence();
+#endif
 }
 
 void Renderer::PutPixel(int x, int y, uint32_t color) {
     // Защита от выхода за границы массива
     if (x < 0 || x >= m_width || y < 0 || y >= m_height) return;
-    
-    // Формула перевода 2D координат в 1D индекс массива
+    int tile = (y >> RENDER_TILE_SHIFT) * m_tilesX + (x >> RENDER_TILE_SHIFT);
+    if (!m_dirty[tile]) TouchTile(tile);
+    m_surfaceChanged = true;
+
+    if (m_frameViewMode == Overdraw) {
+        WriteOverdraw(x, y);
+        return;
+    }
+
     // Мы считаем (0,0) левым верхним углом
-    m_buffer[y * m_width + x] = color;
+    m_surface[SurfaceIndex(x, y)] = color;
+    m_stats.pixelsWritten++;
 }
 
 void Renderer::DrawBuffer() {
-    glBindTexture(GL_TEXTURE_2D, m_textureID);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, m_buffer.data());
+    PROFILE_SCOPE("DrawBuffer");
+    Resolve();
+    if (!m_backend) return;
+    const TargetState& target = m_targets[m_target];
+    const int tileCount = m_tilesX * m_tilesY;
 
-    glUseProgram(m_shaderProgram);
-    glBindVertexArray(m_VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    // Вне тайлов, грязных в этом или в показанном кадре, оба кадра залиты одним цветом
+    bool incremental = target.known && m_presentedKnown && target.clearColor == m_presentedColor;
+    if (incremental) {
+        for (int i = 0; i < tileCount; i++) m_presentedDirty[i] |= target.dirty[i];
+        BuildRects(m_presentedDirty);
+        m_presentedTiles = 0;
+        for (int i = 0; i < tileCount; i++) m_presentedTiles += m_presentedDirty[i];
+        m_backend->Present(m_pixels, m_width, m_height, m_stride, m_rects.data(), (int)m_rects.size());
+    } else {
+        m_presentedTiles = tileCount;
+        m_backend->Present(m_pixels, m_width, m_height, m_stride, nullptr, 0);
+    }
+
+    m_presentedDirty = target.dirty;
+    m_presentedColor = target.clearColor;
+    m_presentedKnown = target.known;
+    AcquireTarget();
+}
+
+void Renderer::BuildRects(const std::vector<uint8_t>& mask) {
+    // Горизонтальные отрезки тайлов в каждой строке; отрезок, совпадающий по x с прямоугольником,
+    // который доходит до этой строки, продлевает его вниз
+    m_rects.clear();
+    LinearArena& arena = m_arena.Main();
+    LinearArena::Marker marker = arena.GetMarker();
+    int* open = arena.AllocateArray<int>(m_tilesX);
+    int* nextOpen = arena.AllocateArray<int>(m_tilesX);
+    int openCount = 0;
+    for (int ty = 0; ty < m_tilesY; ty++) {
+        int nextCount = 0;
+        const uint8_t* row = mask.data() + (size_t)ty * m_tilesX;
+        for (int tx = 0; tx < m_tilesX;) {
+            if (!row[tx]) { tx++; continue; }
+            int start = tx;
+            while (tx < m_tilesX && row[tx]) tx++;
+
+            int x = start * RENDER_TILE_SIZE;
+            int width = std::min(tx * RENDER_TILE_SIZE, m_width) - x;
+            int y = ty * RENDER_TILE_SIZE;
+            int height = std::min(y + RENDER_TILE_SIZE, m_height) - y;
+
+            int index = -1;
+            for (int i = 0; i < openCount; i++) {
+                int r = open[i];
+                if (m_rects[r].x == x && m_rects[r].width == width) index = r;
+            }
+            if (index >= 0) {
+                m_rects[index].height += height;
+            } else {
+                index = (int)m_rects.size();
+                m_rects.push_back({x, y, width, height});
+            }
+            nextOpen[nextCount++] = index;
+        }
+        std::swap(open, nextOpen);
+        openCount = nextCount;
+    }
+    arena.Rewind(marker);
 }
 
 void Renderer::DrawLine(int x0, int y0, int x1, int y1, uint32_t color) {
@@ -129,65 +528,3 @@ void Renderer::DrawLine(int x0, int y0, int x1, int y1, uint32_t color) {
         }
     }
 }
-
-void Renderer::InitOpenGL() {
-    // Создаем шейдерную программу
-    m_shaderProgram = CreateShader(vertexShaderSource, fragmentShaderSource);
-
-    // Координаты квадрата на весь экран (2 треугольника)
-    // Format: X, Y, U, V
-    float vertices[] = {
-        // Первый треугольник
-        -1.0f,  1.0f,  0.0f, 0.0f, // Top-left
-        -1.0f, -1.0f,  0.0f, 1.0f, // Bottom-left
-         1.0f, -1.0f,  1.0f, 1.0f, // Bottom-right
-        // Второй треугольник
-        -1.0f,  1.0f,  0.0f, 0.0f, // Top-left
-         1.0f, -1.0f,  1.0f, 1.0f, // Bottom-right
-         1.0f,  1.0f,  1.0f, 0.0f  // Top-right
-    };
-
-    glGenVertexArrays(1, &m_VAO);
-    glGenBuffers(1, &m_VBO);
-
-    glBindVertexArray(m_VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    // Атрибут координат (X, Y)
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // Атрибут текстурных координат (U, V)
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    // Создаем текстуру
-    glGenTextures(1, &m_textureID);
-    glBindTexture(GL_TEXTURE_2D, m_textureID);
-    // Параметры: не размывать пиксели (GL_NEAREST), чтобы видеть каждый пиксель четко
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    
-    // Выделяем память на GPU под текстуру (пока пустую)
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-}
-
-GLuint Renderer::CreateShader(const char* vertexSrc, const char* fragmentSrc) {
-    // Стандартная компиляция шейдеров (сокращенно для экономии места)
-    GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vertexSrc, NULL);
-    glCompileShader(vertex);
-    
-    GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fragmentSrc, NULL);
-    glCompileShader(fragment);
-
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vertex);
-    glAttachShader(program, fragment);
-    glLinkProgram(program);
-    
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
-    return program;
-}
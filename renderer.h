@@ -1,16 +1,84 @@
 #pragma once
 #include <vector>
 #include <cstdint>
-#include <glad/glad.h> 
+#include <cstddef>
+#include "present_backend.h"
+#include "frame_arena.h"
+#include "aligned_memory.h"
 
+// Кадр делится на квадратные тайлы: по ним отслеживаются изменённые области
+const int RENDER_TILE_SHIFT = 5;
+const int RENDER_TILE_SIZE = 1 << RENDER_TILE_SHIFT;
+
+// Блок плиточной раскладки: 8x8 пикселей подряд в памяти (256 байт, 4 кэш-линии)
+const int RENDER_BLOCK_SHIFT = 3;
+const int RENDER_BLOCK_SIZE = 1 << RENDER_BLOCK_SHIFT;
+
+// Упаковка цвета в формат пикселя буфера: 0xAARRGGBB, байты в памяти B, G, R, A.
+// Это родной формат загрузки текстур (GL_BGRA), драйверу не нужно переставлять каналы
+inline uint32_t MakeColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
+    return ((uint32_t)a << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+
+// Обратная распаковка каналов (для записи изображений)
+inline uint8_t ColorR(uint32_t c) { return (uint8_t)((c >> 16) & 0xFF); }
+inline uint8_t ColorG(uint32_t c) { return (uint8_t)((c >> 8) & 0xFF); }
+inline uint8_t ColorB(uint32_t c) { return (uint8_t)(c & 0xFF); }
+inline uint8_t ColorA(uint32_t c) { return (uint8_t)(c >> 24); }
+
+// Счётчики конвейера за кадр (с последнего Clear). Геометрические стадии (pipeline) пишут
+// в счётчики того Renderer, в который рисуют, поэтому у каждого потока они свои
+struct RenderStats {
+    uint64_t verticesTransformed = 0;
+    uint64_t facesSubmitted = 0;
+    uint64_t facesBackCulled = 0;
+    uint64_t facesFrustumCulled = 0;  // Целиком за краем экрана
+    uint64_t trianglesClipped = 0;    // Частично за краем: прямоугольник обрезан по экрану
+    uint64_t trianglesRasterized = 0;
+    uint64_t pixelsTested = 0;        // Пикселей в ограничивающих прямоугольниках
+    uint64_t pixelsWritten = 0;
+
+    RenderStats& operator+=(const RenderStats& other);
+};
+
+// Программный растеризатор: всё рисуется в буфер в оперативной памяти.
+// Вывод готового кадра делегируется бэкенду (окно OpenGL, файлы, память).
+// Буфер кадра может принадлежать бэкенду (PresentBackend::AcquireTarget): тогда после каждого
+// DrawBuffer он меняется, и содержимое нового буфера не определено до Clear.
+//
+// Для каждого буфера помнится, в каких тайлах он отличается от цвета очистки. Clear заливает
+// только эти тайлы, а DrawBuffer передаёт бэкенду лишь прямоугольники, где новый кадр может
+// отличаться от показанного прошлым (тайлы, затронутые в любом из двух кадров).
+//
+// Сам Clear ничего не пишет, а только помечает тайлы. Тайл заливается при первом касании
+// (перед рисованием в него, пока он всё равно в кэше) или в Resolve, если его никто не тронул, —
+// потоковыми записями в обход кэша. Так каждый пиксель пишется за кадр один раз, без отдельного
+// прохода по всему буферу.
+//
+// Раскладка Tiled: рисование идёт во внутренний буфер из блоков 8x8, каждый блок лежит в памяти
+// подряд. Высокий треугольник тогда задевает гораздо меньше кэш-линий и страниц, чем при
+// построчной раскладке. В линейный буфер кадра изменённые тайлы переписываются в Resolve.
+//
+// Временные данные кадра (буферы стадий конвейера и т.п.) берутся из арены кадра (GetFrameArena):
+// она очищается в Clear, так что в установившемся режиме кадр не обращается к куче.
+//
+// Режим Overdraw — отладочный: вместо цвета треугольника пиксель окрашивается по тому,
+// сколько раз в него писали за кадр (синий — один раз, дальше к красному и белому).
 class Renderer {
 public:
-    Renderer(int width, int height);
-    ~Renderer();
+    enum Layout { Linear, Tiled };
+    enum ViewMode { Shaded, Overdraw };
+
+    // backend может быть nullptr: тогда кадр просто остаётся в буфере (GetPixels)
+    Renderer(int width, int height, PresentBackend* backend = nullptr, Layout layout = Linear);
 
-    // Очистка экрана цветом (формат 0xRRGGBBAA)
+    // Очистка экрана цветом (формат MakeColor). Отложенная: см. Resolve
     void Clear(uint32_t color);
 
+    // Дозаливка тайлов, которых не коснулось рисование, и (для Tiled) перевод в линейный буфер.
+    // DrawBuffer вызывает его сам; без бэкенда его нужно вызвать перед чтением кадра через GetPixels
+    void Resolve();
+
     // Установка конкретного пикселя (главная функция движка)
     void PutPixel(int x, int y, uint32_t color);
 
@@ -18,24 +86,111 @@ public:
     void DrawLine(int x0, int y0, int x1, int y1, uint32_t color);
     
     void DrawTriangle(int x0, int y0, int x1, int y1, int x2, int y2, uint32_t color);
-    // Отправка буфера на видеокарту и отрисовка
+    // Передача готового кадра бэкенду и получение буфера для следующего
     void DrawBuffer();
 
+    // Смена бэкенда начинает новый кадр в буфере нового бэкенда
+    void SetBackend(PresentBackend* backend);
+
+    // Смена размера кадра (например, внутреннего разрешения при масштабировании).
+    // Текущий кадр отбрасывается, следующий начинается с Clear в буфере нового размера
+    void Resize(int width, int height);
+
     int GetWidth() const { return m_width; }
     int GetHeight() const { return m_height; }
+    Layout GetLayout() const { return m_layout; }
+
+    // Режим отображения действует с ближайшего Clear
+    void SetViewMode(ViewMode mode) { m_viewMode = mode; }
+    ViewMode GetViewMode() const { return m_viewMode; }
+
+    // Счётчики текущего кадра; неконстантная версия — для стадий конвейера
+    const RenderStats& GetStats() const { return m_stats; }
+    RenderStats& GetStats() { return m_stats; }
+
+    // Память для данных, нужных до конца текущего кадра
+    FrameArena& GetFrameArena() { return m_arena; }
+
+    // Доступ к кадру напрямую (всегда построчно): stride — пикселей между началами строк
+    const uint32_t* GetPixels() const { return m_pixels; }
+    int GetStride() const { return m_stride; }
+
+    // Статистика тайлов за последний кадр: всего, залито при касании, залито в Resolve,
+    // отдано бэкенду
+    int GetTileCount() const { return m_tilesX * m_tilesY; }
+    int GetTouchClearedTiles() const { return m_touchClearedTiles; }
+    int GetResolvedTiles() const { return m_resolvedTiles; }
+    int GetPresentedTiles() const { return m_presentedTiles; }
 
 private:
     int m_width;
     int m_height;
     
-    // Наш буфер пикселей в оперативной памяти
-    std::vector<uint32_t> m_buffer;
+    // Текущий буфер кадра: свой m_buffer или память бэкенда
+    uint32_t* m_pixels = nullptr;
+    int m_stride = 0;
+
+    // Наш буфер пикселей в оперативной памяти (если бэкенд не дал свой).
+    // Строки выровнены на кэш-линию, шаг дополнен (RowStride)
+    AlignedVector<uint32_t> m_buffer;
+
+    PresentBackend* m_backend;
+
+    // Состояние одного буфера кадра (своего или одного из буферов бэкенда)
+    static const int OWN_BUFFER = -2;
+    struct TargetState {
+        int index = OWN_BUFFER;     // Номер буфера у бэкенда или OWN_BUFFER
+        std::vector<uint8_t> dirty; // Тайлы, где буфер отличается от clearColor
+        uint32_t clearColor = 0;
+        bool known = false;         // false — содержимое буфера неизвестно
+    };
+
+    int m_tilesX = 0;
+    int m_tilesY = 0;
+    std::vector<TargetState> m_targets;
+    int m_target = 0;
+
+    // Поверхность, в которую рисуют: сам буфер кадра (Linear) или плиточный буфер (Tiled)
+    Layout m_layout;
+    uint32_t* m_surface = nullptr;
+    int m_surfaceStride = 0;      // Для Linear
+    int m_blocksX = 0;            // Для Tiled: размер в блоках
+    int m_blocksY = 0;
+    AlignedVector<uint32_t> m_tiled;
+    TargetState m_tiledState;
+    TargetState* m_surfaceState = nullptr;
+    uint8_t* m_dirty = nullptr;   // dirty поверхности
+    bool m_surfaceChanged = true; // Есть изменения, ещё не переписанные в буфер кадра
+
+    // Что показано бэкендом последним: цвет очистки и тайлы, где кадр от него отличался
+    std::vector<uint8_t> m_presentedDirty;
+    uint32_t m_presentedColor = 0;
+    bool m_presentedKnown = false;
+
+    // Тайлы, ждущие заливки цветом m_pendingColor
+    std::vector<uint8_t> m_pending;
+    int m_pendingCount = 0;
+    uint32_t m_pendingColor = 0;
+
+    // Отладочный режим: число записей в каждый пиксель (построчно, насыщается на 255)
+    ViewMode m_viewMode = Shaded;
+    ViewMode m_frameViewMode = Shaded;
+    AlignedVector<uint8_t> m_overdraw;
 
-    // OpenGL идентификаторы
-    GLuint m_textureID;
-    GLuint m_shaderProgram;
-    GLuint m_VAO, m_VBO;
+    RenderStats m_stats;
+    FrameArena m_arena;
+    std::vector<PresentRect> m_rects;
+    int m_touchClearedTiles = 0;
+    int m_resolvedTiles = 0;
+    int m_presentedTiles = 0;
 
-    void InitOpenGL();
-    GLuint CreateShader(const char* vertexSrc, const char* fragmentSrc);
+    void AcquireTarget();
+    void MarkTiles(int minX, int minY, int maxX, int maxY);
+    void TouchTile(int tile);
+    void FillTile(int tx, int ty, uint32_t color, bool stream);
+    void CopyTileToTarget(int tx, int ty);
+    void DrawTriangleOverdraw(int x0, int y0, int x1, int y1, int x2, int y2, int minX, int minY, int maxX, int maxY);
+    void WriteOverdraw(int x, int y);
+    size_t SurfaceIndex(int x, int y) const;
+    void BuildRects(const std::vector<uint8_t>& mask);
 };
@@ -0,0 +1,61 @@
+#include "resolution_controller.h"
+#include <algorithm>
+#include <cmath>
+
+// Ширина кадра кратна 8: строки выровнены по 32 байта и состоят из целых блоков
+static const int WIDTH_STEP = 8;
+
+// Целимся чуть ниже бюджета, чтобы случайные всплески не выводили за него
+static const float TARGET_HEADROOM = 0.9f;
+
+ResolutionController::ResolutionController(int maxWidth, int maxHeight)
+    : m_maxWidth(maxWidth), m_maxHeight(maxHeight), m_width(maxWidth), m_height(maxHeight) {}
+
+bool ResolutionController::Update(float frameMs) {
+    int historyFrames = std::max(1, settings.historyFrames);
+    if ((int)m_history.size() != historyFrames) {
+        m_history.assign(historyFrames, 0.0f);
+        m_historyPos = 0;
+        m_historyCount = 0;
+    }
+    m_history[m_historyPos] = frameMs;
+    m_historyPos = (m_historyPos + 1) % historyFrames;
+    m_historyCount = std::min(m_historyCount + 1, historyFrames);
+
+    float sum = 0.0f;
+    for (int i = 0; i < m_historyCount; i++) sum += m_history[i];
+    m_averageMs = sum / m_historyCount;
+    if (m_historyCount < historyFrames || m_averageMs <= 0.0f) return false;
+
+    float target = settings.targetMs;
+    float scale = m_scale;
+    if (m_averageMs > target) {
+        scale = m_scale * std::sqrt(target * TARGET_HEADROOM / m_averageMs);
+    } else if (m_averageMs < target * settings.growThreshold && m_scale < 1.0f) {
+        scale = m_scale * std::min(std::sqrt(target * TARGET_HEADROOM / m_averageMs), settings.maxGrowStep);
+    }
+    return SetScale(scale);
+}
+
+void ResolutionController::Reset() {
+    SetScale(1.0f);
+}
+
+bool ResolutionController::SetScale(float scale) {
+    float minScale = std::clamp(settings.minScale, 0.01f, 1.0f);
+    scale = std::clamp(scale, minScale, 1.0f);
+
+    // Высота следует за шириной, чтобы не менялось соотношение сторон
+    int width = (int)std::lround(m_maxWidth * scale / WIDTH_STEP) * WIDTH_STEP;
+    width = std::clamp(width, std::min(WIDTH_STEP, m_maxWidth), m_maxWidth);
+    if (scale >= 1.0f) width = m_maxWidth;
+    int height = std::max(1, (int)std::lround((double)width * m_maxHeight / m_maxWidth));
+    if (width == m_width && height == m_height) return false;
+
+    m_width = width;
+    m_height = height;
+    m_scale = (float)width / m_maxWidth;
+    m_historyCount = 0;
+    m_historyPos = 0;
+    return true;
+}
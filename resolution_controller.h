@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+
+// Динамическое разрешение: по истории времени кадра подбирает внутреннее разрешение рендера
+// (не больше размера окна), чтобы держать заданный бюджет кадра. Стоимость растеризации примерно
+// пропорциональна числу пикселей, поэтому масштаб по стороне меняется как корень из отношения
+// бюджета к среднему времени. Между порогами уменьшения и увеличения разрешение не трогается,
+// а рост за один шаг ограничен — так оно не скачет туда-сюда.
+class ResolutionController {
+public:
+    struct Settings {
+        float targetMs = 16.6f;      // Бюджет кадра
+        float minScale = 0.25f;      // Нижний предел масштаба по стороне
+        int historyFrames = 20;      // Кадров в скользящем среднем
+        float growThreshold = 0.75f; // Растём, если среднее ниже этой доли бюджета
+        float maxGrowStep = 1.15f;   // Во сколько раз сторона может вырасти за шаг
+    };
+
+    Settings settings;
+
+    ResolutionController(int maxWidth, int maxHeight);
+
+    // Время работы очередного кадра (только то, что зависит от разрешения, без ожидания vsync).
+    // Возвращает true, если разрешение изменилось
+    bool Update(float frameMs);
+
+    // Возврат к полному разрешению (например, при выключении масштабирования)
+    void Reset();
+
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    float GetScale() const { return m_scale; }
+    float GetAverageMs() const { return m_averageMs; }
+
+private:
+    int m_maxWidth;
+    int m_maxHeight;
+    int m_width;
+    int m_height;
+    float m_scale = 1.0f;
+    float m_averageMs = 0.0f;
+
+    // После смены разрешения история собирается заново: старые замеры о другом размере
+    std::vector<float> m_history;
+    int m_historyPos = 0;
+    int m_historyCount = 0;
+
+    bool SetScale(float scale);
+};
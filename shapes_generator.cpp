@@ -1,101 +1,346 @@
 #include "shapes_generator.h"
+#include "parallel.h"
+#include "fast_math.h"
 #include <iostream>
-#include <fstream>
-#include <vector>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <algorithm>
+#include <climits>
 #include <math.h>
-#include <iomanip>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
-struct Vertex {
-    float x, y, z;
+namespace ShapesGenerator {
+
+// Ключ кэша: тип фигуры, режим FastMath (от него зависят вершины) и все параметры фигуры
+using ShapeKey = std::tuple<int, int, float, float, int, int>;
+
+enum ShapeKind { SHAPE_SPHERE, SHAPE_TORUS };
+
+// Параметры могут приходить с ползунка, и каждое новое значение — новая фигура, поэтому кэш
+// ограничен: при переполнении вытесняется фигура, к которой дольше всего не обращались
+const size_t SHAPE_CACHE_SIZE = 8;
+
+struct CachedShape {
+    Mesh mesh;
+    uint64_t lastUse = 0;
 };
 
-namespace ShapesGenerator {
+static std::map<ShapeKey, CachedShape> s_cache;
+static uint64_t s_cacheClock = 0;
+static std::mutex s_cacheMutex;
 
-void CreateSmoothSphere(const std::string& filename, float radius, int slices, int stacks) {
-    std::ofstream out(filename);
-    if (!out.is_open()) {
-        std::cerr << "Failed to create " << filename << std::endl;
-        return;
+// Вызывается под s_cacheMutex
+template <class Build>
+static const Mesh& FindOrBuild(const ShapeKey& key, const char* name, Build build) {
+    auto it = s_cache.find(key);
+    if (it == s_cache.end()) {
+        if (s_cache.size() >= SHAPE_CACHE_SIZE) {
+            auto oldest = std::min_element(s_cache.begin(), s_cache.end(), [](const auto& a, const auto& b) {
+                return a.second.lastUse < b.second.lastUse;
+            });
+            s_cache.erase(oldest);
+        }
+        it = s_cache.emplace(key, CachedShape{build(), 0}).first;
+        const Mesh& mesh = it->second.mesh;
+        std::cout << "Generated " << name << ": " << mesh.vertices.size() << " verts, " << mesh.faces.size() << " faces." << std::endl;
     }
+    it->second.lastUse = ++s_cacheClock;
+    return it->second.mesh;
+}
+
+// Все построители заранее знают итоговые размеры массивов и пишут каждую строку
+// по её собственному смещению, поэтому строки можно заполнять параллельно.
 
-    std::vector<Vertex> vertices;
-    
-    for (int i = 0; i <= stacks; ++i) {
-        float phi = (float)i / stacks * M_PI;
-        
-        for (int j = 0; j < slices; ++j) {
-            float theta = (float)j / slices * 2.0f * M_PI; 
-        
-            float x = radius * sinf(phi) * cosf(theta);
-            float y = radius * sinf(phi) * sinf(theta);
-            float z = radius * cosf(phi);
-            
-            vertices.push_back({x, y, z});
-            out << "v " << x << " " << y << " " << z << "\n";
+static Mesh BuildSphere(float radius, int slices, int stacks, int threads) {
+    Mesh mesh;
+    mesh.vertices.resize((size_t)(stacks - 1) * slices + 2);
+    mesh.faces.resize((size_t)2 * slices * (stacks - 1));
+
+    // Полюса — по одной вершине, чтобы не плодить вырожденные треугольники
+    const int top = 0;
+    const int bottom = (int)mesh.vertices.size() - 1;
+    mesh.vertices[top] = {0.0f, 0.0f, radius};
+    mesh.vertices[bottom] = {0.0f, 0.0f, -radius};
+    auto ring = [slices](int i, int j) { return 1 + (i - 1) * slices + (j % slices); };
+
+    // Синусы и косинусы долготы одни на все кольца: одной пачкой до параллельной части
+    std::vector<float> thetaSin(slices), thetaCos(slices);
+    for (int j = 0; j < slices; ++j) thetaSin[j] = (float)j / slices * 2.0f * M_PI;
+    FastMath::SinCos(thetaSin.data(), thetaSin.data(), thetaCos.data(), slices);
+
+    ParallelFor(1, stacks, [&](int first, int last) {
+        for (int i = first; i < last; ++i) {
+            float phi = (float)i / stacks * M_PI;
+            float phiSin, phiCos;
+            FastMath::SinCos(phi, phiSin, phiCos);
+
+            for (int j = 0; j < slices; ++j) {
+                float x = radius * phiSin * thetaCos[j];
+                float y = radius * phiSin * thetaSin[j];
+                float z = radius * phiCos;
+
+                mesh.vertices[ring(i, j)] = {x, y, z};
+            }
         }
-    }
-    for (int i = 0; i < stacks; ++i) {
-        for (int j = 0; j < slices; ++j) {
-            
-            int currentRow = i * slices;
-            int nextRow = (i + 1) * slices;
-            
-            int p1 = currentRow + j + 1;
-            int p2 = currentRow + ((j + 1) % slices) + 1;
-            int p3 = nextRow + ((j + 1) % slices) + 1;    
-            int p4 = nextRow + j + 1;
-            
-            out << "f " << p1 << " " << p2 << " " << p3 << " " << p4 << "\n";
+    }, threads);
+
+    // Обход против часовой стрелки снаружи: нормали смотрят наружу.
+    // Строка i (0..stacks-1) — пояс между кольцами i и i+1, у полюсов в нём по одному треугольнику на сегмент.
+    ParallelFor(0, stacks, [&](int first, int last) {
+        for (int i = first; i < last; ++i) {
+            Mesh::Face* out = &mesh.faces[(i == 0) ? 0 : (size_t)slices + (size_t)(i - 1) * 2 * slices];
+            for (int j = 0; j < slices; ++j) {
+                if (i == 0) {
+                    *out++ = {{top, ring(1, j), ring(1, j + 1)}};
+                } else if (i == stacks - 1) {
+                    *out++ = {{ring(i, j), bottom, ring(i, j + 1)}};
+                } else {
+                    int p1 = ring(i, j);
+                    int p2 = ring(i, j + 1);
+                    int p3 = ring(i + 1, j + 1);
+                    int p4 = ring(i + 1, j);
+
+                    *out++ = {{p1, p3, p2}};
+                    *out++ = {{p1, p4, p3}};
+                }
+            }
         }
-    }
+    }, threads);
 
-    out.close();
-    std::cout << "Generated high-poly sphere: " << filename << std::endl;
+    // Геометрия корректна по построению, отдельная проверка не нужна
+    mesh.validated = true;
+    return mesh;
 }
 
-void CreateSmoothTorus(const std::string& filename, float majorRadius, float minorRadius, int majorSegments, int minorSegments) {
-    std::ofstream out(filename);
-    if (!out.is_open()) {
-        std::cerr << "Failed to create " << filename << std::endl;
-        return;
-    }
+static Mesh BuildTorus(float majorRadius, float minorRadius, int majorSegments, int minorSegments, int threads) {
+    Mesh mesh;
+    mesh.vertices.resize((size_t)majorSegments * minorSegments);
+    mesh.faces.resize((size_t)2 * majorSegments * minorSegments);
+
+    // Углы малой окружности одни на все сечения
+    std::vector<float> phiSin(minorSegments), phiCos(minorSegments);
+    for (int j = 0; j < minorSegments; ++j) phiSin[j] = (float)j / minorSegments * 2.0f * M_PI;
+    FastMath::SinCos(phiSin.data(), phiSin.data(), phiCos.data(), minorSegments);
+
+    ParallelFor(0, majorSegments, [&](int first, int last) {
+        for (int i = first; i < last; ++i) {
+            float theta = (float)i / majorSegments * 2.0f * M_PI;
+            float thetaSin, thetaCos;
+            FastMath::SinCos(theta, thetaSin, thetaCos);
+
+            for (int j = 0; j < minorSegments; ++j) {
+                float x = (majorRadius + minorRadius * phiCos[j]) * thetaCos;
+                float y = (majorRadius + minorRadius * phiCos[j]) * thetaSin;
+                float z = minorRadius * phiSin[j];
+
+                mesh.vertices[(size_t)i * minorSegments + j] = {x, y, z};
 
-    for (int i = 0; i < majorSegments; ++i) {
-        float theta = (float)i / majorSegments * 2.0f * M_PI;
-        
-        for (int j = 0; j < minorSegments; ++j) {
-            float phi = (float)j / minorSegments * 2.0f * M_PI;
-            
-            
-            float x = (majorRadius + minorRadius * cosf(phi)) * cosf(theta);
-            float y = (majorRadius + minorRadius * cosf(phi)) * sinf(theta);
-            float z = minorRadius * sinf(phi);
-            
-            out << "v " << x << " " << y << " " << z << "\n";
+                int nextI = (i + 1) % majorSegments;
+                int nextJ = (j + 1) % minorSegments;
+
+                int a = i * minorSegments + j;
+                int b = i * minorSegments + nextJ;
+                int c = nextI * minorSegments + nextJ;
+                int d = nextI * minorSegments + j;
+
+                mesh.faces[(size_t)a * 2] = {{a, d, c}};
+                mesh.faces[(size_t)a * 2 + 1] = {{a, c, b}};
+            }
         }
-    }
+    }, threads);
+
+    mesh.validated = true;
+    return mesh;
+}
+
+const Mesh& SmoothSphere(float radius, int slices, int stacks) {
+    slices = std::max(slices, 3);
+    stacks = std::max(stacks, 2);
+
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    ShapeKey key(SHAPE_SPHERE, FastMath::GetMode(), radius, 0.0f, slices, stacks);
+    return FindOrBuild(key, "sphere", [&] { return BuildSphere(radius, slices, stacks, 0); });
+}
+
+const Mesh& SmoothTorus(float majorRadius, float minorRadius, int majorSegments, int minorSegments) {
+    majorSegments = std::max(majorSegments, 3);
+    minorSegments = std::max(minorSegments, 3);
+
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    ShapeKey key(SHAPE_TORUS, FastMath::GetMode(), majorRadius, minorRadius, majorSegments, minorSegments);
+    return FindOrBuild(key, "torus", [&] { return BuildTorus(majorRadius, minorRadius, majorSegments, minorSegments, 0); });
+}
+
+// --- Нагрузочная геометрия ---
 
-    for (int i = 0; i < majorSegments; ++i) {
-        for (int j = 0; j < minorSegments; ++j) {
-            
-            int nextI = (i + 1) % majorSegments;
-            int nextJ = (j + 1) % minorSegments;
-
-            int a = (i * minorSegments + j) + 1;
-            int b = (i * minorSegments + nextJ) + 1;
-            int c = (nextI * minorSegments + nextJ) + 1;
-            int d = (nextI * minorSegments + j) + 1;
-        
-            out << "f " << a << " " << d << " " << c << " " << b << "\n";
+Mesh Icosphere(float radius, int frequency, int threads) {
+    const int f = std::max(frequency, 1);
+
+    // Икосаэдр: грани обходятся против часовой стрелки, если смотреть снаружи
+    const float t = (1.0f + sqrtf(5.0f)) * 0.5f;
+    const Vec3 base[12] = {
+        {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+        {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+        {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}
+    };
+    const int baseFaces[20][3] = {
+        {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+        {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+        {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+        {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}
+    };
+
+    // Каждая грань икосаэдра — треугольная решётка со своими вершинами.
+    // Вершины на общих рёбрах дублируются, но считаются одинаково (см. ниже), поэтому щелей нет.
+    const size_t vertsPerFace = (size_t)(f + 1) * (f + 2) / 2;
+    const size_t facesPerFace = (size_t)f * f;
+
+    Mesh mesh;
+    mesh.vertices.resize(20 * vertsPerFace);
+    mesh.faces.resize(20 * facesPerFace);
+
+    ParallelFor(0, 20, [&](int first, int last) {
+        for (int bf = first; bf < last; bf++) {
+            const int* corner = baseFaces[bf];
+            const int vertexBase = (int)(bf * vertsPerFace);
+            auto index = [&](int i, int j) { return vertexBase + i * (f + 1) - i * (i - 1) / 2 + j; };
+
+            // Слагаемые суммируем в порядке глобальных номеров вершин икосаэдра:
+            // точка на общем ребре получается побитово одинаковой в обеих гранях
+            int order[3] = {0, 1, 2};
+            std::sort(order, order + 3, [&](int a, int b) { return corner[a] < corner[b]; });
+
+            for (int i = 0; i <= f; i++) {
+                for (int j = 0; j <= f - i; j++) {
+                    float w[3] = {(float)(f - i - j) / f, (float)i / f, (float)j / f};
+                    Vec3 p;
+                    for (int k : order) p = p + base[corner[k]] * w[k];
+                    mesh.vertices[index(i, j)] = p;
+                }
+            }
+
+            // Вершины грани лежат подряд: на сферу они проецируются одной пачкой
+            Vec3* faceVerts = &mesh.vertices[vertexBase];
+            FastMath::Normalize(faceVerts, vertsPerFace);
+            for (size_t v = 0; v < vertsPerFace; v++) faceVerts[v] = faceVerts[v] * radius;
+
+            Mesh::Face* out = &mesh.faces[bf * facesPerFace];
+            for (int i = 0; i < f; i++) {
+                for (int j = 0; j < f - i; j++) {
+                    *out++ = {{index(i, j), index(i + 1, j), index(i, j + 1)}};
+                    if (j < f - i - 1) *out++ = {{index(i + 1, j), index(i + 1, j + 1), index(i, j + 1)}};
+                }
+            }
+        }
+    }, threads);
+
+    mesh.validated = true;
+    return mesh;
+}
+
+Mesh StressTorus(float majorRadius, float minorRadius, int majorSegments, int minorSegments, int threads) {
+    return BuildTorus(majorRadius, minorRadius, std::max(majorSegments, 3), std::max(minorSegments, 3), threads);
+}
+
+Mesh Grid(float size, int cellsX, int cellsY, int threads) {
+    cellsX = std::max(cellsX, 1);
+    cellsY = std::max(cellsY, 1);
+    const int rowVerts = cellsX + 1;
+
+    Mesh mesh;
+    mesh.vertices.resize((size_t)rowVerts * (cellsY + 1));
+    mesh.faces.resize((size_t)2 * cellsX * cellsY);
+
+    ParallelFor(0, cellsY + 1, [&](int first, int last) {
+        for (int j = first; j < last; j++) {
+            float y = ((float)j / cellsY - 0.5f) * size;
+            for (int i = 0; i <= cellsX; i++) {
+                float x = ((float)i / cellsX - 0.5f) * size;
+                mesh.vertices[(size_t)j * rowVerts + i] = {x, y, 0.0f};
+
+                if (i == cellsX || j == cellsY) continue;
+                int a = j * rowVerts + i;
+                int b = a + 1;
+                int c = a + rowVerts + 1;
+                int d = a + rowVerts;
+
+                // Нормали смотрят в -Z, то есть на камеру
+                Mesh::Face* out = &mesh.faces[((size_t)j * cellsX + i) * 2];
+                out[0] = {{a, c, b}};
+                out[1] = {{a, d, c}};
+            }
         }
+    }, threads);
+
+    mesh.validated = true;
+    return mesh;
+}
+
+// SplitMix64: у каждого экземпляра свой генератор, поэтому результат не зависит от разбиения по потокам
+static uint64_t SplitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static float RandomFloat(uint64_t& state) {
+    return (float)(SplitMix64(state) >> 40) / (float)(1ull << 24); // [0, 1)
+}
+
+Mesh InstanceField(const Mesh& base, int count, float extent, uint32_t seed, int threads) {
+    Mesh mesh;
+    if (count <= 0 || base.faces.empty()) return mesh;
+
+    const size_t baseVerts = base.vertices.size();
+    const size_t baseFaces = base.faces.size();
+    // Индексы граней — int: всё поле должно уместиться в INT_MAX вершин и граней
+    if (baseVerts > (size_t)INT_MAX / count || baseFaces > (size_t)INT_MAX / count) {
+        std::cerr << "ERROR: Instance field of " << count << " copies of " << baseVerts << " vertices and "
+                  << baseFaces << " faces is too large" << std::endl;
+        return mesh;
     }
+    mesh.vertices.resize(baseVerts * count);
+    mesh.faces.resize(baseFaces * count);
 
-    out.close();
-    std::cout << "Generated high-poly torus: " << filename << std::endl;
+    // Типичный размер экземпляра — доля среднего расстояния между ними
+    const float spacing = 2.0f * extent / cbrtf((float)count);
+
+    ParallelFor(0, count, [&](int first, int last) {
+        for (int n = first; n < last; n++) {
+            uint64_t state = ((uint64_t)seed << 32) ^ (uint64_t)n * 0xD1B54A32D192ED03ull;
+
+            float px = (RandomFloat(state) * 2.0f - 1.0f) * extent;
+            float py = (RandomFloat(state) * 2.0f - 1.0f) * extent;
+            float pz = (RandomFloat(state) * 2.0f - 1.0f) * extent;
+            float ax = RandomFloat(state) * 2.0f * (float)M_PI;
+            float ay = RandomFloat(state) * 2.0f * (float)M_PI;
+            float az = RandomFloat(state) * 2.0f * (float)M_PI;
+            float scale = spacing * (0.15f + 0.25f * RandomFloat(state));
+
+            Affine3x4 transform = Affine3x4::Translate(px, py, pz) * Affine3x4::RotateZ(az) * Affine3x4::RotateY(ay) *
+                                  Affine3x4::RotateX(ax);
+
+            Vec3* dstVerts = &mesh.vertices[(size_t)n * baseVerts];
+            for (size_t v = 0; v < baseVerts; v++) {
+                dstVerts[v] = transform.TransformPoint(base.vertices[v] * scale);
+            }
+
+            const int offset = (int)((size_t)n * baseVerts);
+            Mesh::Face* dstFaces = &mesh.faces[(size_t)n * baseFaces];
+            for (size_t f = 0; f < baseFaces; f++) {
+                const Mesh::Face& src = base.faces[f];
+                dstFaces[f] = {{src.v[0] + offset, src.v[1] + offset, src.v[2] + offset}};
+            }
+        }
+    }, threads);
+
+    mesh.validated = base.validated;
+    return mesh;
 }
 
-} 
+}
@@ -1,7 +1,24 @@
 #pragma once
-#include <string>
+#include <cstdint>
+#include "mesh.h"
 
 namespace ShapesGenerator {
-    void CreateSmoothSphere(const std::string& filename, float radius, int slices, int stacks);
-    void CreateSmoothTorus(const std::string& filename, float majorRadius, float minorRadius, int majorSegments, int minorSegments);
+    // Процедурные модели строятся прямо в памяти, без записи и повторного чтения .obj.
+    // Результат кэшируется по параметрам: повторный вызов с теми же аргументами
+    // возвращает уже построенный меш. В кэше держатся несколько последних фигур, поэтому
+    // ссылка действует, пока не построены ещё несколько других — меш стоит сразу скопировать.
+    const Mesh& SmoothSphere(float radius, int slices, int stacks);
+    const Mesh& SmoothTorus(float majorRadius, float minorRadius, int majorSegments, int minorSegments);
+
+    // Тяжёлая геометрия для нагрузочных тестов (без кэша). Генерация идёт на всех ядрах (threads <= 0)
+    // и детерминирована: результат зависит только от параметров и seed, но не от числа потоков.
+
+    // Геосфера: каждая грань икосаэдра делится на frequency^2 треугольников (всего 20 * frequency^2)
+    Mesh Icosphere(float radius, int frequency, int threads = 0);
+    Mesh StressTorus(float majorRadius, float minorRadius, int majorSegments, int minorSegments, int threads = 0);
+    // Плоская сетка в плоскости XY лицом к камере: 2 * cellsX * cellsY треугольников
+    Mesh Grid(float size, int cellsX, int cellsY, int threads = 0);
+    // count копий base со случайными положением, поворотом и масштабом внутри куба [-extent, extent]^3.
+    // Если вершин или граней получается больше INT_MAX, возвращает пустую сетку
+    Mesh InstanceField(const Mesh& base, int count, float extent, uint32_t seed, int threads = 0);
 }
@@ -0,0 +1,690 @@
+#include "simd_kernels.h"
+#include "aligned_memory.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define ENGINE_HAS_X86 1
+#include <immintrin.h>
+#endif
+
+// Варианты под старшие наборы инструкций собираются в том же файле, без глобальных флагов компилятора:
+// GCC и Clang разрешают их атрибутом target, MSVC — всегда. Вызываются только через таблицу
+// после проверки CPUID. FMA не включается намеренно: слитое умножение-сложение округляет иначе
+#if defined(__GNUC__) || defined(__clang__)
+#define ENGINE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ENGINE_TARGET(isa)
+#endif
+
+static_assert(sizeof(Vec3) == 3 * sizeof(float), "Vec3 must be three packed floats");
+
+namespace {
+
+int CountBits(unsigned mask) {
+    int count = 0;
+    for (; mask; mask &= mask - 1) count++;
+    return count;
+}
+
+// Приведение аргумента: x = k * pi/2 + r, |r| <= pi/4. pi/2 разбито на три части (Коди — Уэйт):
+// первая с коротким значащим, поэтому k * PIO2_1 точно при |k| < 2^16
+const float TWO_OVER_PI = 0.636619772f;
+const float PIO2_1 = 1.5703125f;
+const float PIO2_2 = 4.837512969970703125e-4f;
+const float PIO2_3 = 7.54978995489188216e-8f;
+
+// Минимаксные многочлены на [-pi/4, pi/4] (Cephes)
+const float SIN_C1 = -1.6666654611e-1f;
+const float SIN_C2 = 8.3321608736e-3f;
+const float SIN_C3 = -1.9515295891e-4f;
+const float COS_C1 = 4.166664568298827e-2f;
+const float COS_C2 = -1.388731625493765e-3f;
+const float COS_C3 = 2.443315711809948e-5f;
+
+// Начальное приближение 1/sqrt по битам числа, дальше две итерации Ньютона
+const uint32_t RSQRT_MAGIC = 0x5F375A86;
+
+// --- Скалярные эталоны ---
+
+void TransformPointsScalar(const Vec3* in, Vec3* out, size_t count, const Mat4& m) {
+    for (size_t i = 0; i < count; i++) out[i] = MultiplyMatrixVector(in[i], m);
+}
+
+void TransformAffineScalar(const Vec3* in, Vec3* out, size_t count, const Affine3x4& m) {
+    for (size_t i = 0; i < count; i++) out[i] = m.TransformPoint(in[i]);
+}
+
+void StreamFillScalar(uint32_t* p, uint32_t* end, uint32_t color) {
+    std::fill(p, end, color);
+}
+
+// Рёберные функции считаются по модулю 2^32, как и исходная формула при переполнении
+uint32_t RasterSpanScalar(uint32_t* dst, int count, int w0, int w1, int w2, int d0, int d1, int d2,
+                          uint32_t color) {
+    uint32_t a = (uint32_t)w0, b = (uint32_t)w1, c = (uint32_t)w2;
+    uint32_t written = 0;
+    for (int i = 0; i < count; i++) {
+        if ((int32_t)(a | b | c) >= 0) {
+            dst[i] = color;
+            written++;
+        }
+        a += (uint32_t)d0;
+        b += (uint32_t)d1;
+        c += (uint32_t)d2;
+    }
+    return written;
+}
+
+// Скалярные приближения повторяют SIMD-варианты операция в операцию, поэтому совпадают с ними побитно.
+// Округление k — к ближайшему чётному, как у cvtps2dq
+void SinCosScalar(const float* angles, float* sines, float* cosines, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        float x = angles[i];
+        float k = std::nearbyint(x * TWO_OVER_PI);
+        int q = (int)k;
+        float r = ((x - k * PIO2_1) - k * PIO2_2) - k * PIO2_3;
+        float z = r * r;
+        float s = ((SIN_C3 * z + SIN_C2) * z + SIN_C1) * z * r + r;
+        float c = ((COS_C3 * z + COS_C2) * z + COS_C1) * z * z - 0.5f * z + 1.0f;
+
+        // Четверть окружности: sin и cos меняются местами и знаками
+        float sine = (q & 1) ? c : s;
+        float cosine = (q & 1) ? s : c;
+        sines[i] = (q & 2) ? -sine : sine;
+        cosines[i] = ((q + 1) & 2) ? -cosine : cosine;
+    }
+}
+
+void RSqrtScalar(const float* values, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        float x = values[i];
+        uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        bits = RSQRT_MAGIC - (bits >> 1);
+        float y;
+        std::memcpy(&y, &bits, sizeof(y));
+        float h = 0.5f * x;
+        y = y * (1.5f - h * y * y);
+        y = y * (1.5f - h * y * y);
+        out[i] = y;
+    }
+}
+
+void NormalizeScalar(Vec3* vectors, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        float length2 = DotProduct(vectors[i], vectors[i]);
+        float scale;
+        RSqrtScalar(&length2, &scale, 1);
+        vectors[i] = vectors[i] * scale;
+    }
+}
+
+#ifdef ENGINE_HAS_X86
+
+// --- SSE2 ---
+
+// Столбцы матрицы: одна вершина — один регистр, сложения в том же порядке, что в MultiplyMatrixVector
+struct MatColumns {
+    __m128 c0, c1, c2, c3;
+};
+
+ENGINE_TARGET("sse2") inline MatColumns LoadColumns(const Mat4& m) {
+    return {_mm_setr_ps(m.m[0][0], m.m[1][0], m.m[2][0], m.m[3][0]),
+            _mm_setr_ps(m.m[0][1], m.m[1][1], m.m[2][1], m.m[3][1]),
+            _mm_setr_ps(m.m[0][2], m.m[1][2], m.m[2][2], m.m[3][2]),
+            _mm_setr_ps(m.m[0][3], m.m[1][3], m.m[2][3], m.m[3][3])};
+}
+
+// Деление на w; при w == 0 результат нулевой, как в скалярной версии
+ENGINE_TARGET("sse2") inline __m128 TransformOne(const Vec3& v, const MatColumns& c) {
+    __m128 r = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v.x), c.c0), _mm_mul_ps(_mm_set1_ps(v.y), c.c1)),
+                                     _mm_mul_ps(_mm_set1_ps(v.z), c.c2)),
+                          c.c3);
+    __m128 w = _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm_and_ps(_mm_div_ps(r, w), _mm_cmpneq_ps(w, _mm_setzero_ps()));
+}
+
+// Вершины лежат подряд по 12 байт: 16-байтная запись задевает x следующей, которую тут же перепишут.
+// У последней вершины массива пишутся ровно 12 байт
+ENGINE_TARGET("sse2") inline void StoreOne(Vec3* out, __m128 v, bool last) {
+    if (!last) {
+        _mm_storeu_ps(&out->x, v);
+        return;
+    }
+    _mm_storel_pi(reinterpret_cast<__m64*>(&out->x), v);
+    _mm_store_ss(&out->z, _mm_movehl_ps(v, v));
+}
+
+ENGINE_TARGET("sse2") void TransformPointsSse2(const Vec3* in, Vec3* out, size_t count, const Mat4& m) {
+    MatColumns c = LoadColumns(m);
+    for (size_t i = 0; i < count; i++) StoreOne(out + i, TransformOne(in[i], c), i + 1 == count);
+}
+
+ENGINE_TARGET("sse2") inline MatColumns LoadColumns(const Affine3x4& m) {
+    return {_mm_setr_ps(m.m[0][0], m.m[1][0], m.m[2][0], 0.0f), _mm_setr_ps(m.m[0][1], m.m[1][1], m.m[2][1], 0.0f),
+            _mm_setr_ps(m.m[0][2], m.m[1][2], m.m[2][2], 0.0f), _mm_setr_ps(m.m[0][3], m.m[1][3], m.m[2][3], 0.0f)};
+}
+
+ENGINE_TARGET("sse2") inline __m128 TransformAffineOne(const Vec3& v, const MatColumns& c) {
+    return _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v.x), c.c0), _mm_mul_ps(_mm_set1_ps(v.y), c.c1)),
+                                 _mm_mul_ps(_mm_set1_ps(v.z), c.c2)),
+                      c.c3);
+}
+
+ENGINE_TARGET("sse2") void TransformAffineSse2(const Vec3* in, Vec3* out, size_t count, const Affine3x4& m) {
+    MatColumns c = LoadColumns(m);
+    for (size_t i = 0; i < count; i++) StoreOne(out + i, TransformAffineOne(in[i], c), i + 1 == count);
+}
+
+ENGINE_TARGET("sse2") void StreamFillSse2(uint32_t* p, uint32_t* end, uint32_t color) {
+    const __m128i value = _mm_set1_epi32((int)color);
+    // Потоковая запись требует выравнивания по 16 байт: края участка пишем обычным способом
+    while (p < end && (reinterpret_cast<uintptr_t>(p) & 15)) *p++ = color;
+    for (; end - p >= 4; p += 4) _mm_stream_si128(reinterpret_cast<__m128i*>(p), value);
+    while (p < end) *p++ = color;
+}
+
+// Частично покрытая четвёрка пишется по одному пикселю. Читать dst нельзя: в раскладке Linear это
+// отображённый только на запись буфер видеокарты (медленная память с объединением записей)
+inline void StorePartial(uint32_t* dst, int outsideMask, uint32_t color) {
+    for (int k = 0; k < 4; k++)
+        if (!(outsideMask & (1 << k))) dst[k] = color;
+}
+
+// Четыре пикселя за шаг, буфер только пишется
+ENGINE_TARGET("sse2") uint32_t RasterSpanSse2(uint32_t* dst, int count, int w0, int w1, int w2, int d0, int d1,
+                                             int d2, uint32_t color) {
+    uint32_t a = (uint32_t)w0, b = (uint32_t)w1, c = (uint32_t)w2;
+    __m128i va = _mm_setr_epi32((int)a, (int)(a + d0), (int)(a + 2u * d0), (int)(a + 3u * d0));
+    __m128i vb = _mm_setr_epi32((int)b, (int)(b + d1), (int)(b + 2u * d1), (int)(b + 3u * d1));
+    __m128i vc = _mm_setr_epi32((int)c, (int)(c + d2), (int)(c + 2u * d2), (int)(c + 3u * d2));
+    const __m128i sa = _mm_set1_epi32((int)(4u * d0));
+    const __m128i sb = _mm_set1_epi32((int)(4u * d1));
+    const __m128i sc = _mm_set1_epi32((int)(4u * d2));
+    const __m128i value = _mm_set1_epi32((int)color);
+
+    uint32_t written = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i outside = _mm_or_si128(_mm_or_si128(va, vb), vc);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(outside));
+        if (mask == 0) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), value);
+            written += 4;
+        } else if (mask != 0xF) {
+            StorePartial(dst + i, mask, color);
+            written += 4 - CountBits((unsigned)mask);
+        }
+        va = _mm_add_epi32(va, sa);
+        vb = _mm_add_epi32(vb, sb);
+        vc = _mm_add_epi32(vc, sc);
+    }
+    return written + RasterSpanScalar(dst + i, count - i, (int)(a + (uint32_t)i * d0), (int)(b + (uint32_t)i * d1),
+                                      (int)(c + (uint32_t)i * d2), d0, d1, d2, color);
+}
+
+ENGINE_TARGET("sse2") void SinCosSse2(const float* angles, float* sines, float* cosines, size_t count) {
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(angles + i);
+        __m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(TWO_OVER_PI)));
+        __m128 k = _mm_cvtepi32_ps(q);
+        __m128 r = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(PIO2_1))), _mm_mul_ps(k, _mm_set1_ps(PIO2_2))),
+                              _mm_mul_ps(k, _mm_set1_ps(PIO2_3)));
+        __m128 z = _mm_mul_ps(r, r);
+        __m128 s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_C3), z),
+                                                                                     _mm_set1_ps(SIN_C2)), z),
+                                                               _mm_set1_ps(SIN_C1)), z), r), r);
+        __m128 c = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_C3), z),
+                                                                                               _mm_set1_ps(COS_C2)), z),
+                                                                         _mm_set1_ps(COS_C1)), z), z),
+                                         _mm_mul_ps(_mm_set1_ps(0.5f), z)),
+                              _mm_set1_ps(1.0f));
+
+        __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+        __m128 sine = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+        __m128 cosine = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+        __m128 sineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+        __m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+        _mm_storeu_ps(sines + i, _mm_xor_ps(sine, _mm_and_ps(sineSign, signBit)));
+        _mm_storeu_ps(cosines + i, _mm_xor_ps(cosine, _mm_and_ps(cosineSign, signBit)));
+    }
+    SinCosScalar(angles + i, sines + i, cosines + i, count - i);
+}
+
+ENGINE_TARGET("sse2") inline __m128 RSqrtOne(__m128 x) {
+    __m128 y = _mm_castsi128_ps(_mm_sub_epi32(_mm_set1_epi32((int)RSQRT_MAGIC), _mm_srli_epi32(_mm_castps_si128(x), 1)));
+    __m128 h = _mm_mul_ps(_mm_set1_ps(0.5f), x);
+    y = _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(h, y), y)));
+    return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(h, y), y)));
+}
+
+ENGINE_TARGET("sse2") void RSqrtSse2(const float* values, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) _mm_storeu_ps(out + i, RSqrtOne(_mm_loadu_ps(values + i)));
+    RSqrtScalar(values + i, out + i, count - i);
+}
+
+// Четыре вектора — три регистра подряд: x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3.
+// Перестановками они разбираются на X, Y, Z, а множители раздаются обратно в том же порядке
+ENGINE_TARGET("sse2") void NormalizeSse2(Vec3* vectors, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float* p = &vectors[i].x;
+        __m128 a = _mm_loadu_ps(p);
+        __m128 b = _mm_loadu_ps(p + 4);
+        __m128 c = _mm_loadu_ps(p + 8);
+        __m128 xy23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+        __m128 yz01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));
+        __m128 x = _mm_shuffle_ps(a, xy23, _MM_SHUFFLE(2, 0, 3, 0));
+        __m128 y = _mm_shuffle_ps(yz01, xy23, _MM_SHUFFLE(3, 1, 2, 0));
+        __m128 z = _mm_shuffle_ps(yz01, c, _MM_SHUFFLE(3, 0, 3, 1));
+
+        __m128 s = RSqrtOne(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+        _mm_storeu_ps(p, _mm_mul_ps(a, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 0, 0))));
+        _mm_storeu_ps(p + 4, _mm_mul_ps(b, _mm_shuffle_ps(s, s, _MM_SHUFFLE(2, 2, 1, 1))));
+        _mm_storeu_ps(p + 8, _mm_mul_ps(c, _mm_shuffle_ps(s, s, _MM_SHUFFLE(3, 3, 3, 2))));
+    }
+    NormalizeScalar(vectors + i, count - i);
+}
+
+// --- SSE4.1 ---
+
+// То же, но начальные значения через умножение
+ENGINE_TARGET("sse4.1") uint32_t RasterSpanSse41(uint32_t* dst, int count, int w0, int w1, int w2, int d0, int d1,
+                                                int d2, uint32_t color) {
+    const __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i va = _mm_add_epi32(_mm_set1_epi32(w0), _mm_mullo_epi32(lane, _mm_set1_epi32(d0)));
+    __m128i vb = _mm_add_epi32(_mm_set1_epi32(w1), _mm_mullo_epi32(lane, _mm_set1_epi32(d1)));
+    __m128i vc = _mm_add_epi32(_mm_set1_epi32(w2), _mm_mullo_epi32(lane, _mm_set1_epi32(d2)));
+    const __m128i sa = _mm_set1_epi32((int)(4u * d0));
+    const __m128i sb = _mm_set1_epi32((int)(4u * d1));
+    const __m128i sc = _mm_set1_epi32((int)(4u * d2));
+    const __m128i value = _mm_set1_epi32((int)color);
+
+    uint32_t written = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i outside = _mm_or_si128(_mm_or_si128(va, vb), vc);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(outside));
+        if (mask == 0) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), value);
+            written += 4;
+        } else if (mask != 0xF) {
+            StorePartial(dst + i, mask, color);
+            written += 4 - CountBits((unsigned)mask);
+        }
+        va = _mm_add_epi32(va, sa);
+        vb = _mm_add_epi32(vb, sb);
+        vc = _mm_add_epi32(vc, sc);
+    }
+    return written + RasterSpanScalar(dst + i, count - i, (int)((uint32_t)w0 + (uint32_t)i * d0),
+                                      (int)((uint32_t)w1 + (uint32_t)i * d1), (int)((uint32_t)w2 + (uint32_t)i * d2),
+                                      d0, d1, d2, color);
+}
+
+// --- AVX2 ---
+
+ENGINE_TARGET("avx2") inline __m256 Pair(float a, float b) {
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(a)), _mm_set1_ps(b), 1);
+}
+
+// Две вершины за шаг, по одной в каждой 128-битной половине
+ENGINE_TARGET("avx2") void TransformPointsAvx2(const Vec3* in, Vec3* out, size_t count, const Mat4& m) {
+    MatColumns c = LoadColumns(m);
+    const __m256 c0 = _mm256_insertf128_ps(_mm256_castps128_ps256(c.c0), c.c0, 1);
+    const __m256 c1 = _mm256_insertf128_ps(_mm256_castps128_ps256(c.c1), c.c1, 1);
+    const __m256 c2 = _mm256_insertf128_ps(_mm256_castps128_ps256(c.c2), c.c2, 1);
+    const __m256 c3 = _mm256_insertf128_ps(_mm256_castps128_ps256(c.c3), c.c3, 1);
+
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const Vec3& v0 = in[i];
+        const Vec3& v1 = in[i + 1];
+        __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(Pair(v0.x, v1.x), c0),
+                                                             _mm256_mul_ps(Pair(v0.y, v1.y), c1)),
+                                               _mm256_mul_ps(Pair(v0.z, v1.z), c2)),
+                                 c3);
+        __m256 w = _mm256_permute_ps(r, _MM_SHUFFLE(3, 3, 3, 3));
+        r = _mm256_and_ps(_mm256_div_ps(r, w), _mm256_cmp_ps(w, _mm256_setzero_ps(), _CMP_NEQ_UQ));
+        StoreOne(out + i, _mm256_castps256_ps128(r), false);
+        StoreOne(out + i + 1, _mm256_extractf128_ps(r, 1), i + 2 == count);
+    }
+    if (i < count) StoreOne(out + i, TransformOne(in[i], c), true);
+}
+
+ENGINE_TARGET("avx2") void TransformAffineAvx2(const Vec3* in, Vec3* out, size_t count, const Affine3x4& m) {
+    MatColumns c = LoadColumns(m);
+    const __m256 c0 = _mm256_insertf128_ps(_mm256_castps128_ps256(c.c0), c.c0, 1);
+    const __m256 c1 = _mm256_insertf128_ps(_mm256_castps128_ps256(c.c1), c.c1, 1);
+    const __m256 c2 = _mm256_insertf128_ps(_mm256_castps128_ps256(c.c2), c.c2, 1);
+    const __m256 c3 = _mm256_insertf128_ps(_mm256_castps128_ps256(c.c3), c.c3, 1);
+
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const Vec3& v0 = in[i];
+        const Vec3& v1 = in[i + 1];
+        __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(Pair(v0.x, v1.x), c0),
+                                                             _mm256_mul_ps(Pair(v0.y, v1.y), c1)),
+                                               _mm256_mul_ps(Pair(v0.z, v1.z), c2)),
+                                 c3);
+        StoreOne(out + i, _mm256_castps256_ps128(r), false);
+        StoreOne(out + i + 1, _mm256_extractf128_ps(r, 1), i + 2 == count);
+    }
+    if (i < count) StoreOne(out + i, TransformAffineOne(in[i], c), true);
+}
+
+ENGINE_TARGET("avx2") void SinCosAvx2(const float* angles, float* sines, float* cosines, size_t count) {
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(angles + i);
+        __m256i q = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(TWO_OVER_PI)));
+        __m256 k = _mm256_cvtepi32_ps(q);
+        __m256 r = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(x, _mm256_mul_ps(k, _mm256_set1_ps(PIO2_1))),
+                                               _mm256_mul_ps(k, _mm256_set1_ps(PIO2_2))),
+                                 _mm256_mul_ps(k, _mm256_set1_ps(PIO2_3)));
+        __m256 z = _mm256_mul_ps(r, r);
+        __m256 s = _mm256_add_ps(
+            _mm256_mul_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIN_C3), z),
+                                                                                  _mm256_set1_ps(SIN_C2)), z),
+                                                      _mm256_set1_ps(SIN_C1)), z), r),
+            r);
+        __m256 c = _mm256_add_ps(
+            _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(COS_C3), z),
+                                                                                                _mm256_set1_ps(COS_C2)), z),
+                                                                    _mm256_set1_ps(COS_C1)), z), z),
+                          _mm256_mul_ps(_mm256_set1_ps(0.5f), z)),
+            _mm256_set1_ps(1.0f));
+
+        __m256 swap = _mm256_castsi256_ps(_mm256_slli_epi32(q, 31));
+        __m256 sine = _mm256_blendv_ps(s, c, swap);
+        __m256 cosine = _mm256_blendv_ps(c, s, swap);
+        __m256 sineSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(q, 1), 31));
+        __m256 cosineSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(_mm256_add_epi32(q, _mm256_set1_epi32(1)), 1), 31));
+        _mm256_storeu_ps(sines + i, _mm256_xor_ps(sine, _mm256_and_ps(sineSign, signBit)));
+        _mm256_storeu_ps(cosines + i, _mm256_xor_ps(cosine, _mm256_and_ps(cosineSign, signBit)));
+    }
+    SinCosScalar(angles + i, sines + i, cosines + i, count - i);
+}
+
+ENGINE_TARGET("avx2") void RSqrtAvx2(const float* values, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(values + i);
+        __m256 y = _mm256_castsi256_ps(_mm256_sub_epi32(_mm256_set1_epi32((int)RSQRT_MAGIC),
+                                                        _mm256_srli_epi32(_mm256_castps_si256(x), 1)));
+        __m256 h = _mm256_mul_ps(_mm256_set1_ps(0.5f), x);
+        y = _mm256_mul_ps(y, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(_mm256_mul_ps(h, y), y)));
+        y = _mm256_mul_ps(y, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(_mm256_mul_ps(h, y), y)));
+        _mm256_storeu_ps(out + i, y);
+    }
+    RSqrtScalar(values + i, out + i, count - i);
+}
+
+ENGINE_TARGET("avx2") void StreamFillAvx2(uint32_t* p, uint32_t* end, uint32_t color) {
+    const __m256i value = _mm256_set1_epi32((int)color);
+    while (p < end && (reinterpret_cast<uintptr_t>(p) & 31)) *p++ = color;
+    for (; end - p >= 8; p += 8) _mm256_stream_si256(reinterpret_cast<__m256i*>(p), value);
+    while (p < end) *p++ = color;
+}
+
+// Восемь пикселей за шаг; запись по маске не трогает пиксели вне треугольника, хвост строки — та же маска
+ENGINE_TARGET("avx2") uint32_t RasterSpanAvx2(uint32_t* dst, int count, int w0, int w1, int w2, int d0, int d1,
+                                             int d2, uint32_t color) {
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i va = _mm256_add_epi32(_mm256_set1_epi32(w0), _mm256_mullo_epi32(lane, _mm256_set1_epi32(d0)));
+    __m256i vb = _mm256_add_epi32(_mm256_set1_epi32(w1), _mm256_mullo_epi32(lane, _mm256_set1_epi32(d1)));
+    __m256i vc = _mm256_add_epi32(_mm256_set1_epi32(w2), _mm256_mullo_epi32(lane, _mm256_set1_epi32(d2)));
+    const __m256i sa = _mm256_set1_epi32((int)(8u * d0));
+    const __m256i sb = _mm256_set1_epi32((int)(8u * d1));
+    const __m256i sc = _mm256_set1_epi32((int)(8u * d2));
+    const __m256i value = _mm256_set1_epi32((int)color);
+
+    uint32_t written = 0;
+    for (int i = 0; i < count; i += 8) {
+        // Старший бит маски: пиксель внутри треугольника и в пределах строки
+        __m256i inside = _mm256_andnot_si256(_mm256_or_si256(_mm256_or_si256(va, vb), vc),
+                                             _mm256_cmpgt_epi32(_mm256_set1_epi32(count - i), lane));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(inside));
+        if (mask) {
+            _mm256_maskstore_epi32(reinterpret_cast<int*>(dst + i), inside, value);
+            written += CountBits((unsigned)mask);
+        }
+        va = _mm256_add_epi32(va, sa);
+        vb = _mm256_add_epi32(vb, sb);
+        vc = _mm256_add_epi32(vc, sc);
+    }
+    return written;
+}
+
+// --- AVX-512 ---
+
+ENGINE_TARGET("avx512f") void StreamFillAvx512(uint32_t* p, uint32_t* end, uint32_t color) {
+    const __m512i value = _mm512_set1_epi32((int)color);
+    while (p < end && (reinterpret_cast<uintptr_t>(p) & 63)) *p++ = color;
+    for (; end - p >= 16; p += 16) _mm512_stream_si512(reinterpret_cast<__m512i*>(p), value);
+    while (p < end) *p++ = color;
+}
+
+ENGINE_TARGET("avx512f") uint32_t RasterSpanAvx512(uint32_t* dst, int count, int w0, int w1, int w2, int d0, int d1,
+                                                  int d2, uint32_t color) {
+    const __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i va = _mm512_add_epi32(_mm512_set1_epi32(w0), _mm512_mullo_epi32(lane, _mm512_set1_epi32(d0)));
+    __m512i vb = _mm512_add_epi32(_mm512_set1_epi32(w1), _mm512_mullo_epi32(lane, _mm512_set1_epi32(d1)));
+    __m512i vc = _mm512_add_epi32(_mm512_set1_epi32(w2), _mm512_mullo_epi32(lane, _mm512_set1_epi32(d2)));
+    const __m512i sa = _mm512_set1_epi32((int)(16u * d0));
+    const __m512i sb = _mm512_set1_epi32((int)(16u * d1));
+    const __m512i sc = _mm512_set1_epi32((int)(16u * d2));
+    const __m512i value = _mm512_set1_epi32((int)color);
+
+    uint32_t written = 0;
+    for (int i = 0; i < count; i += 16) {
+        int left = count - i;
+        __mmask16 valid = left >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << left) - 1);
+        __m512i edges = _mm512_or_si512(_mm512_or_si512(va, vb), vc);
+        __mmask16 inside = _mm512_mask_cmpge_epi32_mask(valid, edges, _mm512_setzero_si512());
+        if (inside) {
+            _mm512_mask_storeu_epi32(dst + i, inside, value);
+            written += CountBits((unsigned)inside);
+        }
+        va = _mm512_add_epi32(va, sa);
+        vb = _mm512_add_epi32(vb, sb);
+        vc = _mm512_add_epi32(vc, sc);
+    }
+    return written;
+}
+
+// Для пересчёта вершин AVX-512 не даёт выигрыша: по 12-байтным Vec3 ширина упирается в загрузки и запись.
+// Плавающие ядра на этом уровне вообще остаются от AVX2: GCC с avx512f включает FMA и сливает умножения
+// со сложениями, и результат перестал бы совпадать со скалярным
+// Нормализация везде остаётся на SSE2: тройки xyz не делятся на 128-битные половины AVX без лишних перестановок
+const SimdKernels KERNELS[] = {
+    {TransformPointsScalar, TransformAffineScalar, StreamFillScalar, RasterSpanScalar, SinCosScalar, RSqrtScalar, NormalizeScalar, CpuFeatures::Scalar},
+    {TransformPointsSse2, TransformAffineSse2, StreamFillSse2, RasterSpanSse2, SinCosSse2, RSqrtSse2, NormalizeSse2, CpuFeatures::SSE2},
+    {TransformPointsSse2, TransformAffineSse2, StreamFillSse2, RasterSpanSse41, SinCosSse2, RSqrtSse2, NormalizeSse2, CpuFeatures::SSE41},
+    {TransformPointsAvx2, TransformAffineAvx2, StreamFillAvx2, RasterSpanAvx2, SinCosAvx2, RSqrtAvx2, NormalizeSse2, CpuFeatures::AVX2},
+    {TransformPointsAvx2, TransformAffineAvx2, StreamFillAvx512, RasterSpanAvx512, SinCosAvx2, RSqrtAvx2, NormalizeSse2, CpuFeatures::AVX512},
+};
+
+#else
+
+const SimdKernels KERNELS[] = {
+    {TransformPointsScalar, TransformAffineScalar, StreamFillScalar, RasterSpanScalar, SinCosScalar, RSqrtScalar, NormalizeScalar, CpuFeatures::Scalar},
+};
+
+#endif
+
+const size_t KERNEL_LEVELS = sizeof(KERNELS) / sizeof(KERNELS[0]);
+
+// --- Проверка ---
+
+bool ValidateTransform(const SimdKernels& test, std::mt19937& rng, std::string& error) {
+    std::uniform_real_distribution<float> coord(-10.0f, 10.0f);
+    const size_t maxCount = 70;
+    std::vector<Vec3> input(maxCount + 4);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = Vec3(coord(rng), coord(rng), coord(rng));
+        if (i % 7 == 0) input[i].z = 0.0f; // w == 0 у проекции
+    }
+
+    Mat4 random;
+    for (int r = 0; r < 4; r++)
+        for (int c = 0; c < 4; c++) random.m[r][c] = coord(rng);
+    const Mat4 matrices[] = {Mat4::Identity(), Mat4::RotateY(0.7f) * Mat4::Translate(1.0f, -2.0f, 5.0f),
+                             Mat4::Projection(1.57f, 0.75f, 0.1f, 100.0f), random};
+
+    // Лишние элементы в конце ловят запись за границу массива
+    std::vector<Vec3> expected(maxCount + 8), actual(maxCount + 8);
+    for (const Mat4& m : matrices) {
+        for (size_t count = 0; count <= maxCount; count++) {
+            for (size_t offset = 0; offset < 4; offset++) {
+                std::fill(expected.begin(), expected.end(), Vec3(-1.0f, -1.0f, -1.0f));
+                std::fill(actual.begin(), actual.end(), Vec3(-1.0f, -1.0f, -1.0f));
+                TransformPointsScalar(input.data() + offset, expected.data() + offset, count, m);
+                test.transformPoints(input.data() + offset, actual.data() + offset, count, m);
+                if (std::memcmp(expected.data(), actual.data(), expected.size() * sizeof(Vec3)) != 0) {
+                    error = "transformPoints differs from scalar (count " + std::to_string(count) + ")";
+                    return false;
+                }
+
+                Affine3x4 affine(Mat4::Uninitialized);
+                std::memcpy(affine.m, m.m, sizeof(affine.m));
+                TransformAffineScalar(input.data() + offset, expected.data() + offset, count, affine);
+                test.transformAffine(input.data() + offset, actual.data() + offset, count, affine);
+                if (std::memcmp(expected.data(), actual.data(), expected.size() * sizeof(Vec3)) != 0) {
+                    error = "transformAffine differs from scalar (count " + std::to_string(count) + ")";
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool ValidateStreamFill(const SimdKernels& test, std::mt19937& rng, std::string& error) {
+    const size_t size = 256;
+    AlignedVector<uint32_t> expected(size), actual(size);
+    std::uniform_int_distribution<size_t> position(0, size);
+    for (int run = 0; run < 500; run++) {
+        size_t a = position(rng), b = position(rng);
+        if (a > b) std::swap(a, b);
+        uint32_t color = (uint32_t)rng();
+        for (size_t i = 0; i < size; i++) expected[i] = actual[i] = (uint32_t)i;
+        StreamFillScalar(expected.data() + a, expected.data() + b, color);
+        test.streamFill(actual.data() + a, actual.data() + b, color);
+        if (expected != actual) {
+            error = "streamFill differs from scalar (range " + std::to_string(a) + ".." + std::to_string(b) + ")";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ValidateRasterSpan(const SimdKernels& test, std::mt19937& rng, std::string& error) {
+    const int maxCount = 70;
+    std::vector<uint32_t> expected(maxCount + 32), actual(maxCount + 32);
+    std::uniform_int_distribution<int> value(-2000, 2000);
+    std::uniform_int_distribution<int> step(-100, 100);
+    for (int run = 0; run < 2000; run++) {
+        int count = run % (maxCount + 1);
+        int offset = (run / (maxCount + 1)) % 16;
+        int w[3], d[3];
+        for (int k = 0; k < 3; k++) {
+            w[k] = value(rng);
+            d[k] = step(rng);
+        }
+        // Каждый десятый прогон — у границы int, где рёберная функция переполняется
+        if (run % 10 == 0) {
+            w[0] = 0x7FFFFF00 + value(rng) / 20;
+            d[0] = 97;
+        }
+        uint32_t color = (uint32_t)rng();
+        for (size_t i = 0; i < expected.size(); i++) expected[i] = actual[i] = (uint32_t)i;
+        uint32_t n0 = RasterSpanScalar(expected.data() + offset, count, w[0], w[1], w[2], d[0], d[1], d[2], color);
+        uint32_t n1 = test.rasterSpan(actual.data() + offset, count, w[0], w[1], w[2], d[0], d[1], d[2], color);
+        if (n0 != n1 || expected != actual) {
+            error = "rasterSpan differs from scalar (count " + std::to_string(count) + ")";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Побитное сравнение, NaN с одинаковыми битами тоже совпадают
+bool SameFloats(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+bool ValidateFastMath(const SimdKernels& test, std::mt19937& rng, std::string& error) {
+    const size_t maxCount = 70;
+    std::vector<float> angles(maxCount + 4), values(maxCount + 4);
+    std::uniform_real_distribution<float> angle(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> exponent(-30.0f, 30.0f);
+    for (size_t i = 0; i < angles.size(); i++) {
+        angles[i] = angle(rng);
+        values[i] = std::pow(2.0f, exponent(rng));
+    }
+    angles[5] = 0.0f;
+    angles[6] = -0.0f;
+    values[7] = 0.0f;
+
+    std::vector<float> s0(maxCount + 8), c0(maxCount + 8), s1(maxCount + 8), c1(maxCount + 8);
+    for (size_t count = 0; count <= maxCount; count++) {
+        for (size_t offset = 0; offset < 4; offset++) {
+            std::fill(s0.begin(), s0.end(), -2.0f); std::fill(c0.begin(), c0.end(), -2.0f);
+            std::fill(s1.begin(), s1.end(), -2.0f); std::fill(c1.begin(), c1.end(), -2.0f);
+            SinCosScalar(angles.data() + offset, s0.data() + offset, c0.data() + offset, count);
+            test.sinCos(angles.data() + offset, s1.data() + offset, c1.data() + offset, count);
+            if (!SameFloats(s0, s1) || !SameFloats(c0, c1)) {
+                error = "sinCos differs from scalar (count " + std::to_string(count) + ")";
+                return false;
+            }
+
+            RSqrtScalar(values.data() + offset, s0.data() + offset, count);
+            test.rsqrt(values.data() + offset, s1.data() + offset, count);
+            if (!SameFloats(s0, s1)) {
+                error = "rsqrt differs from scalar (count " + std::to_string(count) + ")";
+                return false;
+            }
+
+            // Тройки из тех же массивов как векторы
+            size_t vectors = count / 3;
+            std::copy(angles.begin(), angles.end(), s0.begin());
+            std::copy(angles.begin(), angles.end(), s1.begin());
+            NormalizeScalar(reinterpret_cast<Vec3*>(s0.data() + offset), vectors);
+            test.normalize(reinterpret_cast<Vec3*>(s1.data() + offset), vectors);
+            if (!SameFloats(s0, s1)) {
+                error = "normalize differs from scalar (count " + std::to_string(vectors) + ")";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+const SimdKernels& GetKernels() {
+    return GetKernels(CpuFeatures::Active());
+}
+
+const SimdKernels& GetKernels(CpuFeatures::Level level) {
+    return KERNELS[std::min((size_t)level, KERNEL_LEVELS - 1)];
+}
+
+bool ValidateKernels(CpuFeatures::Level level, std::string& error) {
+    if (level > CpuFeatures::Detected()) {
+        error = std::string(CpuFeatures::Name(level)) + " is not supported by this CPU";
+        return false;
+    }
+    const SimdKernels& test = GetKernels(level);
+    std::mt19937 rng(1234);
+    return ValidateTransform(test, rng, error) && ValidateStreamFill(test, rng, error) &&
+           ValidateRasterSpan(test, rng, error) && ValidateFastMath(test, rng, error);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "cpu_features.h"
+#include "math_3d.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Горячие функции движка в нескольких вариантах: скалярный эталон, SSE2, SSE4.1, AVX2, AVX-512.
+// Вариант выбирается по CpuFeatures::Active() при каждом GetKernels(), поэтому Force() действует сразу.
+// Все варианты дают побитно тот же результат, что и скалярный (без FMA и с тем же порядком сложений);
+// ValidateKernels проверяет это на случайных данных.
+struct SimdKernels {
+    // out[i] = MultiplyMatrixVector(in[i], m). in и out не должны пересекаться
+    void (*transformPoints)(const Vec3* in, Vec3* out, size_t count, const Mat4& m);
+
+    // out[i] = m.TransformPoint(in[i]): без строки w и деления. in и out не должны пересекаться
+    void (*transformAffine)(const Vec3* in, Vec3* out, size_t count, const Affine3x4& m);
+
+    // Заливка [p, end) потоковыми записями в обход кэша. Перед чтением буфера другим потоком нужен sfence
+    void (*streamFill)(uint32_t* p, uint32_t* end, uint32_t color);
+
+    // Строка треугольника: count пикселей, значения рёберных функций в первом пикселе w0..w2
+    // и их приращения на шаг по x d0..d2. Пиксель пишется, если все три >= 0. Возвращает число записанных
+    uint32_t (*rasterSpan)(uint32_t* dst, int count, int w0, int w1, int w2, int d0, int d1, int d2, uint32_t color);
+
+    // Быстрые приближения для FastMath (погрешности — в fast_math.h). Поэлементно: выход может совпадать со входом
+    void (*sinCos)(const float* angles, float* sines, float* cosines, size_t count);
+    void (*rsqrt)(const float* values, float* out, size_t count);
+    void (*normalize)(Vec3* vectors, size_t count); // На месте: v * rsqrt(v·v)
+
+    CpuFeatures::Level level; // Уровень, под который собран самый старший вариант в таблице
+};
+
+// Таблица для текущего уровня
+const SimdKernels& GetKernels();
+
+// Таблица для заданного уровня: для каждой функции лучший вариант не выше level
+const SimdKernels& GetKernels(CpuFeatures::Level level);
+
+// Сравнение всех функций уровня со скалярными на случайных данных. Уровень должен поддерживаться машиной
+bool ValidateKernels(CpuFeatures::Level level, std::string& error);
@@ -0,0 +1,221 @@
+#include "y4m_writer.h"
+#include "renderer.h"
+#include "profiler.h"
+#include <iostream>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINE_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+// Коэффициенты BT.601 в фиксированной точке (x256)
+static inline uint8_t LumaFromRGB(int r, int g, int b) {
+    return (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+// Цветность из суммы двух пикселей (поэтому сдвиг на 9)
+static inline uint8_t ChromaU(int r2, int g2, int b2) {
+    return (uint8_t)(((-38 * r2 - 74 * g2 + 112 * b2 + 256) >> 9) + 128);
+}
+
+static inline uint8_t ChromaV(int r2, int g2, int b2) {
+    return (uint8_t)(((112 * r2 - 94 * g2 - 18 * b2 + 256) >> 9) + 128);
+}
+
+// Скалярный перевод полосы столбцов [x0, width). Цветность: среднее по вертикали с округлением вверх
+// (как _mm_avg_epu8), затем сумма по горизонтали — так результат совпадает с SSE2 бит в бит
+static void ConvertRowsScalar(const uint32_t* row0, const uint32_t* row1, int x0, int width,
+                              uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v) {
+    for (int x = x0; x < width; x++) {
+        y0[x] = LumaFromRGB(ColorR(row0[x]), ColorG(row0[x]), ColorB(row0[x]));
+        if (y1) y1[x] = LumaFromRGB(ColorR(row1[x]), ColorG(row1[x]), ColorB(row1[x]));
+    }
+
+    for (int x = x0; x < width; x += 2) {
+        // Нечётная ширина: последний столбец повторяется
+        int xn = (x + 1 < width) ? x + 1 : x;
+        int r = ((ColorR(row0[x]) + ColorR(row1[x]) + 1) >> 1) + ((ColorR(row0[xn]) + ColorR(row1[xn]) + 1) >> 1);
+        int g = ((ColorG(row0[x]) + ColorG(row1[x]) + 1) >> 1) + ((ColorG(row0[xn]) + ColorG(row1[xn]) + 1) >> 1);
+        int b = ((ColorB(row0[x]) + ColorB(row1[x]) + 1) >> 1) + ((ColorB(row0[xn]) + ColorB(row1[xn]) + 1) >> 1);
+        u[x / 2] = ChromaU(r, g, b);
+        v[x / 2] = ChromaV(r, g, b);
+    }
+}
+
+void ConvertToI420Scalar(const uint32_t* pixels, int width, int height, int stride, uint8_t* y, uint8_t* u, uint8_t* v) {
+    const int chromaWidth = (width + 1) / 2;
+    for (int row = 0; row < height; row += 2) {
+        const uint32_t* row0 = pixels + (size_t)row * stride;
+        // Нечётная высота: последняя строка повторяется
+        bool hasPair = row + 1 < height;
+        const uint32_t* row1 = hasPair ? row0 + stride : row0;
+        ConvertRowsScalar(row0, row1, 0, width, y + (size_t)row * width, hasPair ? y + (size_t)(row + 1) * width : nullptr,
+                          u + (size_t)(row / 2) * chromaWidth, v + (size_t)(row / 2) * chromaWidth);
+    }
+}
+
+#ifdef ENGINE_HAS_SSE2
+
+// Горизонтальное сложение соседних 32-битных пар: [a0+a1, a2+a3, b0+b1, b2+b3]
+static inline __m128i AddPairs(__m128i a, __m128i b) {
+    __m128 af = _mm_castsi128_ps(a);
+    __m128 bf = _mm_castsi128_ps(b);
+    __m128i even = _mm_castps_si128(_mm_shuffle_ps(af, bf, _MM_SHUFFLE(2, 0, 2, 0)));
+    __m128i odd = _mm_castps_si128(_mm_shuffle_ps(af, bf, _MM_SHUFFLE(3, 1, 3, 1)));
+    return _mm_add_epi32(even, odd);
+}
+
+// Яркость четырёх пикселей -> четыре 32-битных значения
+static inline __m128i Luma4(__m128i px, __m128i coeffs) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), coeffs);
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), coeffs);
+    __m128i sum = AddPairs(lo, hi);
+    sum = _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8);
+    return _mm_add_epi32(sum, _mm_set1_epi32(16));
+}
+
+// Сумма соседних пикселей по горизонтали: 4 пикселя (уже усреднённых по вертикали) -> 2 суммы BGRA в 16 битах
+static inline __m128i PairSums(__m128i px) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_unpacklo_epi8(px, zero);
+    __m128i hi = _mm_unpackhi_epi8(px, zero);
+    lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+    hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+    return _mm_unpacklo_epi64(lo, hi);
+}
+
+// Цветность для двух сумм пикселей (каждая — два пикселя из пары строк) -> четыре 32-битных значения
+static inline __m128i Chroma4(__m128i sums01, __m128i sums23, __m128i coeffs) {
+    __m128i sum = AddPairs(_mm_madd_epi16(sums01, coeffs), _mm_madd_epi16(sums23, coeffs));
+    sum = _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(256)), 9);
+    return _mm_add_epi32(sum, _mm_set1_epi32(128));
+}
+
+static inline void Store8(uint8_t* dst, __m128i a, __m128i b) {
+    __m128i packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_setzero_si128());
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), packed);
+}
+
+static inline void Store4(uint8_t* dst, __m128i a) {
+    __m128i packed = _mm_packus_epi16(_mm_packs_epi32(a, a), _mm_setzero_si128());
+    int value = _mm_cvtsi128_si32(packed);
+    std::memcpy(dst, &value, 4);
+}
+
+void ConvertToI420(const uint32_t* pixels, int width, int height, int stride, uint8_t* y, uint8_t* u, uint8_t* v) {
+    // Порядок коэффициентов совпадает с байтами пикселя в памяти: B, G, R, A
+    const __m128i coeffY = _mm_setr_epi16(25, 129, 66, 0, 25, 129, 66, 0);
+    const __m128i coeffU = _mm_setr_epi16(112, -74, -38, 0, 112, -74, -38, 0);
+    const __m128i coeffV = _mm_setr_epi16(-18, -94, 112, 0, -18, -94, 112, 0);
+
+    const int chromaWidth = (width + 1) / 2;
+    const int simdWidth = width & ~7; // Блоки по 8 пикселей, хвост — скалярно
+
+    for (int row = 0; row < height; row += 2) {
+        const uint32_t* row0 = pixels + (size_t)row * stride;
+        bool hasPair = row + 1 < height;
+        const uint32_t* row1 = hasPair ? row0 + stride : row0;
+        uint8_t* y0 = y + (size_t)row * width;
+        uint8_t* y1 = hasPair ? y0 + width : nullptr;
+        uint8_t* uRow = u + (size_t)(row / 2) * chromaWidth;
+        uint8_t* vRow = v + (size_t)(row / 2) * chromaWidth;
+
+        for (int x = 0; x < simdWidth; x += 8) {
+            __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x));
+            __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x + 4));
+            __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x));
+            __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x + 4));
+
+            Store8(y0 + x, Luma4(a0, coeffY), Luma4(a1, coeffY));
+            if (y1) Store8(y1 + x, Luma4(b0, coeffY), Luma4(b1, coeffY));
+
+            __m128i s0 = PairSums(_mm_avg_epu8(a0, b0));
+            __m128i s1 = PairSums(_mm_avg_epu8(a1, b1));
+            Store4(uRow + x / 2, Chroma4(s0, s1, coeffU));
+            Store4(vRow + x / 2, Chroma4(s0, s1, coeffV));
+        }
+
+        ConvertRowsScalar(row0, row1, simdWidth, width, y0, y1, uRow, vRow);
+    }
+}
+
+#else
+
+void ConvertToI420(const uint32_t* pixels, int width, int height, int stride, uint8_t* y, uint8_t* u, uint8_t* v) {
+    ConvertToI420Scalar(pixels, width, height, stride, y, u, v);
+}
+
+#endif
+
+// --- Y4mWriter ---
+
+Y4mWriter::~Y4mWriter() {
+    Close();
+}
+
+bool Y4mWriter::Open(const std::string& filename, int width, int height, int fps, size_t maxQueued) {
+    Close();
+
+    if (filename == "-") {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        m_out = stdout;
+        m_ownsFile = false;
+    } else {
+        m_out = std::fopen(filename.c_str(), "wb");
+        if (!m_out) {
+            std::cerr << "Failed to create " << filename << std::endl;
+            return false;
+        }
+        m_ownsFile = true;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_stats = WriterStats();
+
+    // C420jpeg — цветность по центру блока 2x2, именно так она и усредняется
+    std::fprintf(m_out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+    m_writer.reset(new AsyncStreamWriter(m_out, maxQueued));
+    return true;
+}
+
+bool Y4mWriter::Close() {
+    if (!m_out) return true;
+
+    m_writer->Finish();
+    m_stats = m_writer->GetStats();
+    m_writer.reset();
+
+    bool ok = m_stats.failed == 0 && std::fflush(m_out) == 0;
+    if (m_ownsFile) ok = (std::fclose(m_out) == 0) && ok;
+    m_out = nullptr;
+    if (!ok) std::cerr << "Failed to write video stream" << std::endl;
+    return ok;
+}
+
+std::vector<uint8_t> Y4mWriter::EncodeFrame(const uint32_t* pixels, int stride) const {
+    PROFILE_SCOPE("To I420");
+    static const char marker[] = "FRAME\n";
+    const size_t markerSize = sizeof(marker) - 1;
+    const size_t lumaSize = (size_t)m_width * m_height;
+    const size_t chromaSize = (size_t)((m_width + 1) / 2) * ((m_height + 1) / 2);
+
+    std::vector<uint8_t> frame(markerSize + lumaSize + chromaSize * 2);
+    std::memcpy(frame.data(), marker, markerSize);
+    uint8_t* y = frame.data() + markerSize;
+    ConvertToI420(pixels, m_width, m_height, stride, y, y + lumaSize, y + lumaSize + chromaSize);
+    return frame;
+}
+
+void Y4mWriter::WriteFrame(int index, std::vector<uint8_t> frame) {
+    m_writer->Write(index, std::move(frame));
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include "async_writer.h"
+
+// Перевод кадра Renderer в YUV 4:2:0 (I420, BT.601, ограниченный диапазон 16..235).
+// Цветность усредняется по блокам 2x2. y — width*height байт, u и v — по ((width+1)/2)*((height+1)/2).
+// На x86 используется SSE2, иначе скалярный вариант с тем же результатом.
+void ConvertToI420(const uint32_t* pixels, int width, int height, int stride, uint8_t* y, uint8_t* u, uint8_t* v);
+void ConvertToI420Scalar(const uint32_t* pixels, int width, int height, int stride, uint8_t* y, uint8_t* u, uint8_t* v);
+
+// Несжатое видео YUV4MPEG2 (.y4m) в файл или в stdout ("-") для передачи внешнему кодировщику:
+//   engine_batch --output - | ffmpeg -i - out.mp4
+// Кадры можно конвертировать в любых потоках и сдавать в любом порядке:
+// запись идёт в отдельном потоке через ограниченную упорядочивающую очередь.
+class Y4mWriter {
+public:
+    ~Y4mWriter();
+
+    bool Open(const std::string& filename, int width, int height, int fps, size_t maxQueued = 8);
+    // Возвращает false, если какая-то запись не удалась
+    bool Close();
+    bool IsOpen() const { return m_out != nullptr; }
+
+    // Кадр целиком ("FRAME\n" и три плоскости), готовый к записи. Потокобезопасна
+    std::vector<uint8_t> EncodeFrame(const uint32_t* pixels, int stride) const;
+    // index — номер кадра с нуля, каждый номер ровно один раз
+    void WriteFrame(int index, std::vector<uint8_t> frame);
+
+    // Читать после Close()
+    const WriterStats& GetStats() const { return m_stats; }
+
+private:
+    FILE* m_out = nullptr;
+    bool m_ownsFile = false;
+    int m_width = 0;
+    int m_height = 0;
+    std::unique_ptr<AsyncStreamWriter> m_writer;
+    WriterStats m_stats;
+};